@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace zuul
+{
+    struct AllocStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct AllocZoneStats
+    {
+        const char *name = nullptr;
+        AllocStats frame; // During the last completed frame
+        AllocStats total; // Since startup
+    };
+
+    // Counts the C++ heap allocations (global operator new) made per frame and per
+    // zone, to check that steady-state frames do not allocate. Only the thread that
+    // calls endFrame is counted; worker threads allocate outside the frame. Only active
+    // in builds configured with -Dalloc_tracking=true; otherwise every count stays 0.
+    //
+    // A frame that makes more allocations than ZUUL_ALLOC_THRESHOLD (default 0) is
+    // reported on stderr together with the call stack of the allocation that crossed
+    // the threshold. The first frames are not reported, they fill caches on purpose.
+    class AllocTracker
+    {
+    public:
+#if defined(ZUUL_ALLOC_TRACKING)
+        static constexpr bool ENABLED = true;
+#else
+        static constexpr bool ENABLED = false;
+#endif
+
+        AllocTracker();
+
+        AllocTracker(const AllocTracker &) = delete;
+        AllocTracker &operator=(const AllocTracker &) = delete;
+
+        // Closes the current frame, called by Game::run after present()
+        void endFrame();
+
+        // Zones are inclusive: allocations in a nested zone also count for the outer one.
+        // Zones only see allocations of their own thread and are meant for the main thread.
+        void endZone(const char *name, const AllocStats &allocs);
+
+        const AllocStats &getLastFrame() const { return mLastFrame; }
+        std::span<const AllocZoneStats> getZones() const { return {mZones, mZoneCount}; }
+
+        // Frame totals, flagged frames and per zone counts, printed on exit
+        void printSummary() const;
+
+    private:
+        static constexpr size_t MAX_ZONES = 32;
+
+        AllocStats mLastFrame;
+        AllocStats mPeakFrame;
+        AllocStats mTotal;
+        uint64_t mFrames;
+        uint64_t mFlaggedFrames;
+        AllocZoneStats mZones[MAX_ZONES];
+        size_t mZoneCount;
+    };
+
+    AllocTracker &getAllocTracker();
+
+    // Allocations made by the calling thread since it started
+    AllocStats getThreadAllocs();
+
+    // Records the allocations made until the end of the enclosing scope as the named zone.
+    // The name must be a string literal, zones are told apart by its address.
+    class AllocZone
+    {
+    public:
+        explicit AllocZone(const char *name)
+            : mName(name),
+              mStart(getThreadAllocs())
+        {
+        }
+
+        ~AllocZone()
+        {
+            AllocStats end = getThreadAllocs();
+            getAllocTracker().endZone(mName, {end.count - mStart.count, end.bytes - mStart.bytes});
+        }
+
+        AllocZone(const AllocZone &) = delete;
+        AllocZone &operator=(const AllocZone &) = delete;
+
+    private:
+        const char *mName;
+        AllocStats mStart;
+    };
+
+} // namespace zuul
+
+#if defined(ZUUL_ALLOC_TRACKING)
+#define ZUUL_ALLOC_ZONE(name) ::zuul::AllocZone zuulAllocZone(name)
+#else
+#define ZUUL_ALLOC_ZONE(name)
+#endif
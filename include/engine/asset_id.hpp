@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace zuul
+{
+    // 64 bit FNV-1a of an asset path. scripts/gen_asset_manifest.py computes the same
+    // hash for the generated manifest, the two must stay in step.
+    constexpr uint64_t hashAssetPath(std::string_view path)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : path)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    enum class AssetType : uint8_t
+    {
+        Map,
+        Tileset,
+        World,
+        Image,
+        Font,
+        Data
+    };
+
+    // An asset listed in assets/assets.json. The generated asset_manifest.hpp defines one
+    // constant per asset, so a missing asset fails to compile. Compared by hash.
+    struct AssetId
+    {
+        uint64_t hash;
+        uint32_t index; // Into manifest::ASSETS
+        AssetType type;
+        const char *path;
+
+        constexpr bool operator==(const AssetId &other) const { return hash == other.hash; }
+    };
+
+} // namespace zuul
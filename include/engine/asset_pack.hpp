@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zuul
+{
+    // Layout of a pack file, written by the zuul_pack tool:
+    //
+    //   PackHeader | PackEntry[entryCount], sorted by name | names | data
+    //
+    // Names are the lexically normal paths the game asks for, e.g. "assets/home.tmj".
+    // Data blocks start at multiples of PACK_ALIGNMENT, so uncompressed pixels can be
+    // used straight from the mapping. All values are little endian.
+    constexpr char PACK_MAGIC[4] = {'Z', 'P', 'A', 'K'};
+    constexpr uint32_t PACK_VERSION = 1;
+    constexpr size_t PACK_ALIGNMENT = 16;
+
+    enum class PackEntryType : uint8_t
+    {
+        File, // Stored as is
+        Image // Decoded to ARGB8888 pixels, row after row without padding
+    };
+
+    enum class PackCompression : uint8_t
+    {
+        None,
+        LZ4
+    };
+
+    struct PackHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t namesSize;
+    };
+
+    struct PackEntry
+    {
+        uint64_t offset;     // Of the data, from the start of the pack
+        uint64_t size;       // Stored bytes
+        uint64_t rawSize;    // Bytes after decompression
+        uint32_t nameOffset; // Into the names
+        uint32_t nameLength;
+        uint32_t width; // Images only
+        uint32_t height;
+        PackEntryType type;
+        PackCompression compression;
+        uint8_t padding[6];
+    };
+
+    static_assert(sizeof(PackHeader) == 16 && sizeof(PackEntry) == 48, "The pack layout is part of the file format");
+
+    // Pixels of an image in a pack. Uncompressed images point into the mapping, compressed
+    // ones are decompressed into storage.
+    struct PackImage
+    {
+        int width = 0;
+        int height = 0;
+        const uint32_t *pixels = nullptr;
+        std::vector<uint32_t> storage;
+    };
+
+    // A pack file mapped into memory. Read only, so any thread may use it.
+    class AssetPack
+    {
+    public:
+        AssetPack() = default;
+        ~AssetPack();
+
+        AssetPack(const AssetPack &) = delete;
+        AssetPack &operator=(const AssetPack &) = delete;
+
+        // Maps the file and checks its index; on failure the pack stays empty
+        bool open(const std::string &filepath);
+        void close();
+
+        bool isOpen() const { return mData != nullptr; }
+        size_t getEntryCount() const { return mEntries.size(); }
+
+        // nullptr if the pack has no entry of that name
+        const PackEntry *find(std::string_view name) const;
+
+        // The stored bytes of a file entry
+        std::span<const std::byte> getData(const PackEntry &entry) const;
+        bool readImage(const PackEntry &entry, PackImage &image) const;
+
+    private:
+        std::string_view getName(const PackEntry &entry) const;
+
+        const std::byte *mData = nullptr;
+        size_t mSize = 0;
+        std::span<const PackEntry> mEntries;
+        std::string_view mNames;
+        bool mMapped = false;
+        std::vector<std::byte> mBuffer; // Holds the file where it can't be mapped
+    };
+
+} // namespace zuul
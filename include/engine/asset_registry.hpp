@@ -0,0 +1,106 @@
+#pragma once
+
+#include <engine/asset_id.hpp>
+#include <engine/renderer.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zuul
+{
+    class AssetRegistry;
+
+    // Counted reference to a texture owned by an AssetRegistry. Copies share the texture
+    // and the last one to go destroys it. Drawing only needs the handle from get().
+    // The count is not atomic: references belong to the main thread.
+    class TextureAsset
+    {
+    public:
+        TextureAsset() = default;
+        ~TextureAsset();
+
+        TextureAsset(const TextureAsset &other);
+        TextureAsset(TextureAsset &&other) noexcept;
+        TextureAsset &operator=(const TextureAsset &other);
+        TextureAsset &operator=(TextureAsset &&other) noexcept;
+
+        TextureHandle get() const { return mHandle; }
+        void reset();
+
+        explicit operator bool() const { return static_cast<bool>(mHandle); }
+        bool operator==(const TextureAsset &other) const { return mHandle == other.mHandle; }
+
+    private:
+        friend class AssetRegistry;
+
+        // Takes over a reference the registry already counted
+        TextureAsset(AssetRegistry *registry, TextureHandle handle)
+            : mRegistry(registry),
+              mHandle(handle)
+        {
+        }
+
+        AssetRegistry *mRegistry = nullptr;
+        TextureHandle mHandle;
+    };
+
+    // Owns the textures of the game on behalf of the renderer. Images are loaded once
+    // per path and shared; generated textures and render targets belong to whoever
+    // created them. A texture is destroyed when its last TextureAsset goes away.
+    // Must outlive every TextureAsset it handed out.
+    class AssetRegistry
+    {
+    public:
+        explicit AssetRegistry(Renderer &renderer);
+        ~AssetRegistry();
+
+        AssetRegistry(const AssetRegistry &) = delete;
+        AssetRegistry &operator=(const AssetRegistry &) = delete;
+
+        // The empty reference if the image cannot be loaded. Images are found by the hash
+        // of their path; manifest assets have it precomputed.
+        TextureAsset loadTexture(AssetId asset);
+        TextureAsset loadTexture(const std::string &path);
+
+        // For callers that decode the image themselves because they also read its pixels:
+        // shares the texture of the path like loadTexture, but creates it from the given
+        // ARGB8888 pixels if the path isn't loaded yet
+        TextureAsset loadTexture(const std::string &path, int width, int height, const uint32_t *pixels);
+        TextureAsset createTexture(int width, int height, const uint32_t *pixels);
+        TextureAsset createRenderTarget(int width, int height, bool linearFilter = false);
+
+        // Hot reload: replaces the image of a loaded path with pixels decoded again by the
+        // caller. Every reference keeps working and shows the new image. Returns false if
+        // the texture cannot be created; a path that was never loaded has nothing to
+        // reload and succeeds.
+        bool reloadTexture(const std::string &path, int width, int height, const uint32_t *pixels);
+
+        Renderer &getRenderer() { return mRenderer; }
+        size_t getTextureCount() const { return mTextureCount; }
+
+    private:
+        friend class TextureAsset;
+
+        struct Entry
+        {
+            uint32_t references = 0;
+            uint64_t hash = 0;
+            std::string path; // Empty for generated textures
+        };
+
+        // Loads the file unless pixels are given
+        TextureAsset loadTexture(uint64_t hash, const std::string &path, int width = 0, int height = 0,
+                                 const uint32_t *pixels = nullptr);
+        TextureHandle createImageTexture(const std::string &path, int width, int height, const uint32_t *pixels);
+        TextureAsset adopt(TextureHandle handle, uint64_t hash, std::string path);
+        void addReference(TextureHandle handle);
+        void release(TextureHandle handle);
+
+        Renderer &mRenderer;
+        std::vector<Entry> mEntries; // Indexed like the renderer's slot table
+        std::unordered_map<uint64_t, TextureHandle> mPaths; // By path hash
+        size_t mTextureCount;
+    };
+
+} // namespace zuul
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <engine/renderer.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace zuul
+{
+    struct DrawQuad
+    {
+        uint32_t textureSlot;
+        int srcX, srcY, srcW, srcH;
+        int destX, destY, destW, destH;
+    };
+
+    // Collects textured quads for a frame, sorts them by (layer, y-depth, texture)
+    // and submits them to the renderer in that order.
+    class DrawQueue
+    {
+    public:
+        DrawQueue();
+
+        // Key layout, most significant bits first:
+        // 8 bits layer | 32 bits y-depth (signed, biased) | 24 bits texture slot
+        static uint64_t makeKey(uint8_t layer, int32_t depth, uint32_t textureSlot);
+
+        void reserve(size_t count);
+        void clear();
+
+        void push(uint8_t layer, int32_t depth, TextureHandle texture,
+                  int srcX, int srcY, int srcW, int srcH,
+                  int destX, int destY, int destW, int destH);
+
+        // Stable LSD radix sort on the keys. Reuses its scratch buffers, so it does
+        // not allocate once the queue has reached its steady-state size.
+        void sort();
+        void submit(Renderer &renderer) const;
+
+        size_t size() const { return mQuads.size(); }
+        bool empty() const { return mQuads.empty(); }
+
+    private:
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        uint32_t getTextureSlot(TextureHandle texture);
+
+        std::vector<DrawQuad> mQuads;
+        std::vector<SortEntry> mEntries;
+        std::vector<SortEntry> mScratch;
+        std::vector<TextureHandle> mTextures;
+        uint32_t mLastTextureSlot;
+    };
+
+} // namespace zuul
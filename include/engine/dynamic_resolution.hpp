@@ -0,0 +1,27 @@
+#pragma once
+
+namespace zuul
+{
+    // Picks an internal render scale from measured frame times. The scale drops
+    // when frames go over budget and climbs back once there is headroom again.
+    class DynamicResolution
+    {
+    public:
+        DynamicResolution(float frameBudget, int minScale = 1, int maxScale = 1);
+
+        void setScaleRange(int minScale, int maxScale);
+        void update(float frameTime);
+
+        int getScale() const { return mScale; }
+        float getAverageFrameTime() const { return mAverageFrameTime; }
+
+    private:
+        float mFrameBudget;
+        float mAverageFrameTime;
+        int mScale;
+        int mMinScale;
+        int mMaxScale;
+        int mFramesSinceChange;
+    };
+
+} // namespace zuul
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <engine/asset_pack.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+struct SDL_RWops;
+
+namespace zuul
+{
+    // Where the game reads its files from. With a pack mounted, paths it contains are
+    // served from the mapped pack and images come pre-decoded; every other path, or
+    // all of them without a pack, is read from disk.
+    class FileSystem
+    {
+    public:
+        FileSystem() = default;
+
+        FileSystem(const FileSystem &) = delete;
+        FileSystem &operator=(const FileSystem &) = delete;
+
+        // Replaces the mounted pack, if any. Call before anything is loaded.
+        bool mount(const std::string &packPath);
+        bool isMounted() const { return mPack.isOpen(); }
+
+        bool exists(const std::string &path) const;
+        bool readFile(const std::string &path, std::string &contents) const;
+
+        // Stream over the file for SDL loaders, or nullptr. The caller closes it.
+        SDL_RWops *openFile(const std::string &path) const;
+
+        // Pixels of an image stored decoded in the pack. False if the pack doesn't have
+        // it, in which case the image has to be decoded from disk.
+        bool readImage(const std::string &path, PackImage &image) const;
+
+        // Hot reload: the file was changed on disk, so read it from there from now on.
+        // Safe to call from the watcher thread while the main thread loads.
+        void useDiskCopy(const std::string &path);
+
+    private:
+        const PackEntry *findEntry(const std::string &path) const;
+
+        AssetPack mPack;
+        mutable std::mutex mDiskCopiesMutex;
+        std::unordered_set<std::string> mDiskCopies;
+    };
+
+    // The file system of the process
+    FileSystem &getFileSystem();
+
+} // namespace zuul
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zuul
+{
+    // Watches directories for files that were written or moved into place and reports
+    // them from a background thread. Editors often save in several steps, so paths are
+    // collected until no event arrived for a short while and then reported once each.
+    // Uses inotify; on other platforms start() returns false.
+    class FileWatcher
+    {
+    public:
+        using Callback = std::function<void(const std::vector<std::string> &paths)>;
+
+        FileWatcher() = default;
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        // Watches the directories and their subdirectories. The callback runs on the
+        // watcher thread with lexically normal paths.
+        bool start(const std::vector<std::string> &directories, Callback callback);
+        void stop();
+
+        bool isRunning() const { return mThread.joinable(); }
+
+    private:
+        void run();
+
+        Callback mCallback;
+        std::vector<std::string> mWatchedDirectories; // Indexed by watch descriptor
+        std::thread mThread;
+        std::atomic<bool> mStopping = false;
+        int mNotifyFd = -1;
+        int mWakeFds[2] = {-1, -1};
+    };
+
+} // namespace zuul
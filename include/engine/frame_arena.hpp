@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace zuul
+{
+    // Bump allocator for data that only lives until the end of the frame, such as
+    // scratch containers and strings built while updating or rendering. Deallocation
+    // does nothing; reset() frees everything at once. The buffer persists across
+    // frames: when a frame outgrows it, the extra blocks come from the heap and the
+    // buffer is grown at the next reset, so steady-state frames never allocate.
+    // Not thread safe, it belongs to the main thread.
+    class FrameArena : public std::pmr::memory_resource
+    {
+    public:
+        explicit FrameArena(size_t capacity = 256 * 1024);
+
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        void reset();
+
+        size_t getCapacity() const { return mCapacity; }
+        size_t getUsed() const { return mUsed + mOverflowBytes; }
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    private:
+        std::unique_ptr<std::byte[]> mBuffer;
+        size_t mCapacity;
+        size_t mUsed;
+        std::vector<std::unique_ptr<std::byte[]>> mOverflow;
+        size_t mOverflowBytes;
+    };
+
+    // The arena of the current frame, reset by Game::run after every frame
+    FrameArena &getFrameArena();
+
+} // namespace zuul
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "asset_registry.hpp"
 #include "renderer.hpp"
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -17,15 +19,29 @@ namespace zuul
         void run();
         void stop();
 
+        // Time spent on updating and rendering the previous frame, excluding the wait in present()
+        float getFrameWorkTime() const { return mFrameWorkTime; }
+
     protected:
+        // Called once per frame before the fixed updates, for work that should not repeat
+        // when several updates catch up in one frame
+        virtual void beginFrame() {}
         virtual void update(float deltaTime) = 0;
         virtual void render() = 0;
 
-        ::std::shared_ptr<Renderer> getRenderer() { return mRenderer; }
+        Renderer &getRenderer() { return *mRenderer; }
+        AssetRegistry &getAssets() { return *mAssets; }
+
+        // Milliseconds since the game was constructed, for startup timings
+        float getMillisecondsSinceStart() const;
 
     private:
-        ::std::shared_ptr<Renderer> mRenderer;
+        ::std::unique_ptr<Renderer> mRenderer;
+        // Declared after the renderer, so the textures it owns go first
+        ::std::unique_ptr<AssetRegistry> mAssets;
         bool mIsRunning;
+        float mFrameWorkTime;
+        uint64_t mStartCounter;
         const int TARGET_FPS = 60;
         const float FRAME_TIME = 1.0f / TARGET_FPS;
     };
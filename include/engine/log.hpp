@@ -0,0 +1,44 @@
+#pragma once
+
+// Levels below SPDLOG_ACTIVE_LEVEL compile to nothing, arguments included. The
+// build sets it from the log_level meson option; this default keeps everything.
+#ifndef SPDLOG_ACTIVE_LEVEL
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+#include <spdlog/spdlog.h>
+#include <cstdint>
+
+namespace zuul
+{
+    // One named logger per subsystem, so their levels can be set separately
+    enum class LogChannel : uint8_t
+    {
+        Engine,
+        Render,
+        Assets,
+        Map,
+        Game,
+        Count
+    };
+
+    // Loggers format on the calling thread and hand the message to a background thread
+    // that writes it to stderr, so logging never waits for the terminal. The queue drops
+    // the oldest messages rather than block when it is full; warnings and errors are
+    // flushed as soon as the background thread gets to them. Created on first use.
+    spdlog::logger &getLogger(LogChannel channel);
+
+    // Runtime level of every channel, on top of the compile-time threshold. ZUUL_LOG_LEVEL
+    // (trace, debug, info, warn, error, off) sets it at startup.
+    void setLogLevel(spdlog::level::level_enum level);
+
+    // Writes out everything queued so far, e.g. before exiting
+    void flushLogs();
+
+} // namespace zuul
+
+#define ZUUL_LOG_TRACE(channel, ...) SPDLOG_LOGGER_TRACE(&::zuul::getLogger(::zuul::LogChannel::channel), __VA_ARGS__)
+#define ZUUL_LOG_DEBUG(channel, ...) SPDLOG_LOGGER_DEBUG(&::zuul::getLogger(::zuul::LogChannel::channel), __VA_ARGS__)
+#define ZUUL_LOG_INFO(channel, ...) SPDLOG_LOGGER_INFO(&::zuul::getLogger(::zuul::LogChannel::channel), __VA_ARGS__)
+#define ZUUL_LOG_WARN(channel, ...) SPDLOG_LOGGER_WARN(&::zuul::getLogger(::zuul::LogChannel::channel), __VA_ARGS__)
+#define ZUUL_LOG_ERROR(channel, ...) SPDLOG_LOGGER_ERROR(&::zuul::getLogger(::zuul::LogChannel::channel), __VA_ARGS__)
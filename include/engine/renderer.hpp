@@ -2,8 +2,12 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "engine/texture.hpp"
 
 namespace zuul
@@ -20,20 +24,102 @@ namespace zuul
         virtual ~Renderer();
 
         virtual bool initialize(int windowWidth, int windowHeight, const std::string &windowTitle) = 0;
-        virtual void clear() = 0;
+        virtual void clear(const Color &color = {0, 0, 0, 255}) = 0;
         virtual void present() = 0;
 
-        virtual std::shared_ptr<Texture> loadTexture(const std::string &path) = 0;
-        virtual void renderTexture(std::shared_ptr<Texture> texture,
+        // Textures live in a slot table owned by the renderer and are referred to by
+        // handles, so a draw costs an array index. Loading and creating return the
+        // default handle on failure. Usually the AssetRegistry decides when to destroy them.
+        TextureHandle loadTexture(const std::string &path);
+
+        // Texture from ARGB8888 pixels generated on the CPU, e.g. downsampled map chunks
+        TextureHandle createTexture(int width, int height, const uint32_t *pixels);
+
+        // Replaces the image of a texture with ARGB8888 pixels, keeping its handle. On
+        // failure the old image stays.
+        bool reloadTexture(TextureHandle texture, int width, int height, const uint32_t *pixels);
+
+        // The texture is freed after the frame is presented, draws queued before stay valid
+        void destroyTexture(TextureHandle texture);
+
+        bool isValid(TextureHandle texture) const { return getTexture(texture) != nullptr; }
+        bool getTextureSize(TextureHandle texture, int &width, int &height) const;
+
+        virtual void renderTexture(TextureHandle texture,
                                    int srcX, int srcY, int srcW, int srcH,
                                    int destX, int destY, int destW, int destH) = 0;
 
+        // Offscreen render targets. Passing the default handle to setRenderTarget draws to the window again,
+        // and getOutputSize reports the size of whatever is currently bound. Drawing into a target cleared
+        // to transparent leaves premultiplied colour, so targets themselves are drawn with premultiplied
+        // blending and translucent pixels aren't darkened a second time.
+        TextureHandle createRenderTarget(int width, int height, bool linearFilter = false);
+        virtual bool setRenderTarget(TextureHandle target) = 0;
+        virtual void getOutputSize(int &width, int &height) const = 0;
+
         virtual void renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a) = 0;
-        virtual void renderText(const std::string &text, int x, int y, const Color &color) = 0;
+        // Rendered strings are cached as textures, so text that stays the same from
+        // frame to frame is only rasterized once
+        void renderText(std::string_view text, int x, int y, const Color &color);
 
     protected:
+        // Backend texture factories, returning nullptr on failure
+        virtual std::unique_ptr<Texture> loadTextureFile(const std::string &path) = 0;
+        virtual std::unique_ptr<Texture> createPixelTexture(int width, int height, const uint32_t *pixels) = 0;
+        virtual std::unique_ptr<Texture> createTargetTexture(int width, int height, bool linearFilter) = 0;
+        virtual std::unique_ptr<Texture> createTextTexture(SDL_Surface *surface) = 0;
+
+        // The texture of a handle, or nullptr if it was destroyed. Backends cast the result
+        // to their own texture type, every texture in the table was created by them.
+        Texture *getTexture(TextureHandle texture) const
+        {
+            uint32_t index = texture.getIndex();
+            return index < mTextures.size() && mTextures[index].generation == texture.getGeneration()
+                       ? mTextures[index].texture.get()
+                       : nullptr;
+        }
+
+        // Drops text textures that were not drawn for a while and frees destroyed textures.
+        // Backends call this once per frame, after the frame's draws no longer need them.
+        void endFrame();
+
+        // Frees every texture, before the backend tears down the objects they depend on
+        void destroyAllTextures();
+
         SDL_Renderer *mRenderer;
         TTF_Font *mFont;
+
+    private:
+        struct TextKeyHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+        };
+
+        struct TextTexture
+        {
+            TextureHandle texture;
+            int width;
+            int height;
+            uint64_t lastFrame;
+        };
+
+        struct TextureSlot
+        {
+            std::unique_ptr<Texture> texture;
+            uint32_t generation = 1;
+        };
+
+        TextureHandle addTexture(std::unique_ptr<Texture> texture);
+        std::unique_ptr<Texture> loadImage(const std::string &path);
+
+        std::vector<TextureSlot> mTextures;
+        std::vector<uint32_t> mFreeSlots;
+        std::vector<std::unique_ptr<Texture>> mRetiredTextures;
+
+        // Keyed by the text, a 0 byte and the colour
+        std::unordered_map<std::string, TextTexture, TextKeyHash, std::equal_to<>> mTextTextures;
+        uint64_t mTextFrame = 0;
     };
 
 } // namespace zuul
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <engine/asset_id.hpp>
+#include <engine/asset_registry.hpp>
+#include <engine/renderer.hpp>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace zuul
+{
+    enum class SceneLoad : uint8_t
+    {
+        Loading,
+        Ready,
+        Failed
+    };
+
+    // A screen of the game, such as the title or the world, run by a SceneStack
+    class Scene
+    {
+    public:
+        virtual ~Scene() = default;
+
+        // Images the scene draws. The stack loads them before the scene and holds them until
+        // the scene is popped, so getting them from the registry in load() is a lookup.
+        virtual std::span<const AssetId> getAssets() const { return {}; }
+
+        // Called once per frame until it returns Ready, so a scene can load in steps
+        // while the scene below it is still shown
+        virtual SceneLoad load(AssetRegistry &assets) = 0;
+
+        virtual void update(float deltaTime) = 0;
+        virtual void render(Renderer &renderer) = 0;
+
+        // A finished scene makes way for the scene that replaces it, once that has loaded
+        virtual bool isFinished() const { return false; }
+    };
+
+    // Only the top scene is updated and drawn. The next scene, pushed or replacing the top,
+    // loads in the background of the frames before it takes over, so at most the scenes on
+    // the stack and the next one hold assets. Popping a scene releases its assets to the
+    // registry, which frees whatever nothing else refers to.
+    class SceneStack
+    {
+    public:
+        explicit SceneStack(AssetRegistry &assets);
+
+        SceneStack(const SceneStack &) = delete;
+        SceneStack &operator=(const SceneStack &) = delete;
+
+        // Loads the scene and then puts it on top, keeping the scenes below
+        void push(std::unique_ptr<Scene> scene);
+
+        // Loads the scene and swaps it in for the top scene once that one is finished
+        void replace(std::unique_ptr<Scene> scene);
+
+        // Removes the top scene at once
+        void pop();
+
+        // Takes one loading step of the next scene and makes due scene changes; a finished
+        // top scene with nothing to replace it is popped. Returns false if loading failed.
+        bool beginFrame();
+
+        // Loads the next scene in one go, e.g. the first one before the first frame
+        bool finishLoading();
+
+        void update(float deltaTime);
+        void render(Renderer &renderer);
+
+        bool isEmpty() const { return mScenes.empty() && !mNext.scene; }
+        bool isLoading() const { return mNext.scene && !mNextLoaded; }
+
+    private:
+        struct Entry
+        {
+            std::unique_ptr<Scene> scene;
+            std::vector<TextureAsset> textures; // The prefetched assets
+        };
+
+        void setNext(std::unique_ptr<Scene> scene, bool replace);
+        SceneLoad loadNext();
+        void switchScenes();
+
+        AssetRegistry &mAssets;
+        std::vector<Entry> mScenes;
+        Entry mNext;
+        size_t mNextPrefetched = 0;
+        bool mNextLoaded = false;
+        bool mNextReplaces = false;
+    };
+
+} // namespace zuul
@@ -33,19 +33,27 @@ namespace zuul
         bool initialize(int windowWidth, int windowHeight, const std::string &windowTitle);
         void cleanup();
 
-        void clear() override;
+        void clear(const Color &color = {0, 0, 0, 255}) override;
         void present() override;
 
-        std::shared_ptr<Texture> loadTexture(const std::string &path) override;
-        void renderTexture(std::shared_ptr<Texture> texture,
+        void renderTexture(TextureHandle texture,
                            int srcX, int srcY, int srcW, int srcH,
                            int destX, int destY, int destW, int destH) override;
 
+        bool setRenderTarget(TextureHandle target) override;
+        void getOutputSize(int &width, int &height) const override;
+
         void renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a) override;
-        void renderText(const std::string &text, int x, int y, const Color &color) override;
+
+    protected:
+        std::unique_ptr<Texture> loadTextureFile(const std::string &path) override;
+        std::unique_ptr<Texture> createPixelTexture(int width, int height, const uint32_t *pixels) override;
+        std::unique_ptr<Texture> createTargetTexture(int width, int height, bool linearFilter) override;
+        std::unique_ptr<Texture> createTextTexture(SDL_Surface *surface) override;
 
     private:
         SDL_Window *mWindow;
+        TextureHandle mRenderTarget;
     };
 
 } // namespace zuul
\ No newline at end of file
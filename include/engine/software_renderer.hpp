@@ -0,0 +1,114 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <engine/renderer.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zuul
+{
+    // CPU side image in ARGB8888, used for loaded images, text and render targets
+    class SoftwareTexture : public Texture
+    {
+    public:
+        SoftwareTexture(int width, int height);
+
+        int getWidth() const override { return mWidth; }
+        int getHeight() const override { return mHeight; }
+
+        uint32_t *getPixels() { return mPixels.data(); }
+        const uint32_t *getPixels() const { return mPixels.data(); }
+
+        // Opaque textures are copied instead of blended
+        bool isOpaque() const { return mOpaque; }
+        void updateOpacity();
+
+        // Render targets hold premultiplied colour and are blended accordingly
+        bool isPremultiplied() const { return mPremultiplied; }
+        void setPremultiplied(bool premultiplied) { mPremultiplied = premultiplied; }
+
+    private:
+        std::vector<uint32_t> mPixels;
+        int mWidth;
+        int mHeight;
+        bool mOpaque;
+        bool mPremultiplied;
+    };
+
+    // Renderer that rasterizes into a framebuffer in system memory with SIMD kernels
+    // and presents it through a single streaming texture. Draw calls are recorded and
+    // rasterized in screen tiles on a pool of worker threads when the target changes
+    // or the frame is presented.
+    class SoftwareRenderer : public Renderer
+    {
+    public:
+        SoftwareRenderer();
+        ~SoftwareRenderer() override;
+
+        bool initialize(int windowWidth, int windowHeight, const std::string &windowTitle) override;
+        void cleanup();
+
+        void clear(const Color &color = {0, 0, 0, 255}) override;
+        void present() override;
+
+        void renderTexture(TextureHandle texture,
+                           int srcX, int srcY, int srcW, int srcH,
+                           int destX, int destY, int destW, int destH) override;
+
+        bool setRenderTarget(TextureHandle target) override;
+        void getOutputSize(int &width, int &height) const override;
+
+        void renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a) override;
+
+    protected:
+        std::unique_ptr<Texture> loadTextureFile(const std::string &path) override;
+        std::unique_ptr<Texture> createPixelTexture(int width, int height, const uint32_t *pixels) override;
+        std::unique_ptr<Texture> createTargetTexture(int width, int height, bool linearFilter) override;
+        std::unique_ptr<Texture> createTextTexture(SDL_Surface *surface) override;
+
+    private:
+        struct DrawCommand
+        {
+            const SoftwareTexture *texture; // nullptr for rectangle outlines
+            SDL_Rect src;
+            SDL_Rect dest;
+            uint32_t color;
+        };
+
+        static std::unique_ptr<SoftwareTexture> createFromSurface(SDL_Surface *surface);
+
+        void flush();
+        void rasterizeTile(int tileIndex);
+        void workerLoop();
+
+        SDL_Window *mWindow;
+        SDL_Texture *mStreamingTexture;
+        std::unique_ptr<SoftwareTexture> mFramebuffer;
+        // Destroyed textures are only freed after present(), which unbinds them first
+        SoftwareTexture *mTarget;
+
+        // Commands for the current target, binned per screen tile before rasterizing
+        std::vector<DrawCommand> mCommands;
+        std::vector<std::vector<uint32_t>> mTileBins;
+        int mTilesX;
+        int mTilesY;
+
+        // Worker pool: each flush bumps the generation and workers pull tiles from mNextTile
+        std::vector<std::thread> mWorkers;
+        std::mutex mMutex;
+        std::condition_variable mWorkAvailable;
+        std::condition_variable mWorkDone;
+        uint64_t mGeneration;
+        int mBusyWorkers;
+        bool mShuttingDown;
+        std::atomic<int> mNextTile;
+    };
+
+} // namespace zuul
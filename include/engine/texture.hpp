@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace zuul
 {
     class Texture
@@ -9,4 +11,21 @@ namespace zuul
         virtual int getWidth() const = 0;
         virtual int getHeight() const = 0;
     };
-} // namespace zuul
\ No newline at end of file
+
+    // Refers to a texture in a renderer's slot table: 20 bits slot index, 12 bits generation.
+    // The generation changes when the slot is reused, so a handle to a destroyed texture
+    // stays harmless: drawing it does nothing. The default handle refers to nothing.
+    struct TextureHandle
+    {
+        static constexpr uint32_t INDEX_BITS = 20;
+        static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+        uint32_t value = 0;
+
+        uint32_t getIndex() const { return value & INDEX_MASK; }
+        uint32_t getGeneration() const { return value >> INDEX_BITS; }
+
+        explicit operator bool() const { return value != 0; }
+        bool operator==(const TextureHandle &) const = default;
+    };
+} // namespace zuul
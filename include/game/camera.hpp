@@ -11,6 +11,7 @@ namespace zuul
         void update(float targetX, float targetY);
         void setZoom(float zoom);
         void adjustZoom(float delta); // For incrementally changing zoom
+        void setMapSize(int mapWidth, int mapHeight); // After the map was reloaded
 
         // Get the offset to apply to rendered objects
         float getOffsetX() const { return mOffsetX; }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <game/tileset_data.hpp>
+
+namespace zuul
+{
+    struct CollisionHit
+    {
+        float time;    // Fraction of the motion before contact, from 0 to 1
+        float normalX; // Normal of the surface that was hit, pointing against the motion
+        float normalY;
+        int collider;  // Index into getColliders()
+    };
+
+    // Static axis-aligned colliders in a bounding volume hierarchy. Boxes are open
+    // intervals: boxes that only share an edge don't overlap, so a box resting
+    // against a wall can still slide along it.
+    class CollisionWorld
+    {
+    public:
+        void build(std::vector<CollisionBox> colliders);
+
+        bool overlaps(const CollisionBox &box) const;
+        void queryOverlaps(const CollisionBox &box, std::vector<int> &colliders) const;
+
+        // Swept box moving by (dx, dy). Returns the first collider it runs into, ignoring
+        // colliders it already overlaps at the start, so a stuck box can move out.
+        bool castBox(const CollisionBox &box, float dx, float dy, CollisionHit &hit) const;
+
+        // Segment from (x, y) to (x + dx, y + dy)
+        bool raycast(float x, float y, float dx, float dy, CollisionHit &hit) const;
+
+        const std::vector<CollisionBox> &getColliders() const { return mColliders; }
+        size_t getNodeCount() const { return mNodes.size(); }
+
+    private:
+        struct Node
+        {
+            float minX;
+            float minY;
+            float maxX;
+            float maxY;
+            uint32_t first; // Leaves: first collider. Inner nodes: right child, the left one follows this node.
+            uint32_t count; // Colliders in a leaf, 0 for inner nodes
+        };
+
+        uint32_t buildNode(uint32_t first, uint32_t count);
+        bool findOverlaps(const CollisionBox &box, std::vector<int> *colliders) const;
+        bool sweep(float minX, float minY, float maxX, float maxY, float dx, float dy, CollisionHit &hit) const;
+
+        std::vector<CollisionBox> mColliders; // Reordered so every leaf covers a contiguous range
+        std::vector<Node> mNodes;
+    };
+
+} // namespace zuul
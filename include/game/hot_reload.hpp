@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <engine/file_watcher.hpp>
+#include <engine/asset_registry.hpp>
+#include <game/tilemap.hpp>
+
+namespace zuul
+{
+    // Reloads maps, tilesets and tileset images while the game runs. Changed files are
+    // reparsed on the watcher thread; the results are patched into the registered maps
+    // on the main thread by update(), so only the edited cells, tiles and textures
+    // change and the player, camera and collected items keep their state.
+    class HotReloader
+    {
+    public:
+        HotReloader() = default;
+        ~HotReloader();
+
+        // Maps must be registered before start() and outlive the reloader. Maps drawn
+        // with baked composites are baked again after every change.
+        void addMap(TileMap *map, bool bakeComposites = false);
+
+        bool start(const std::string &directory);
+        void stop();
+
+        // Applies the reloads parsed since the last call
+        void update(AssetRegistry &assets);
+
+    private:
+        struct WatchedMap
+        {
+            TileMap *map;
+            std::string filepath;
+            TileGrid::Layout layout;
+            bool bakeComposites;
+        };
+
+        void onFilesChanged(const std::vector<std::string> &paths);
+        void reloadMap(const WatchedMap &watched);
+        void reloadTileset(const std::string &path);
+        void reloadImage(const std::string &path);
+        void finishReload(const WatchedMap &watched, AssetRegistry &assets);
+
+        std::vector<WatchedMap> mMaps; // Read on the watcher thread, fixed while it runs
+        FileWatcher mWatcher;
+
+        std::mutex mPendingMutex;
+        std::vector<std::function<void(AssetRegistry &)>> mPending;
+    };
+
+} // namespace zuul
@@ -3,6 +3,7 @@
 #include <memory>
 #include <functional>
 #include <engine/renderer.hpp>
+#include <engine/draw_queue.hpp>
 #include <game/tileset_data.hpp>
 
 namespace zuul
@@ -12,11 +13,11 @@ namespace zuul
     public:
         using CollectCallback = std::function<void(int)>;
 
-        Item(int tileId, float x, float y, std::shared_ptr<TilesetData> tilesetData, std::shared_ptr<Texture> texture);
+        Item(int tileId, float x, float y, std::shared_ptr<TilesetData> tilesetData);
         ~Item() = default;
 
         void update(float deltaTime);
-        void render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom);
+        void queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom) const;
 
         bool isColliding(float x, float y, float width, float height) const;
         bool isCollected() const { return mCollected; }
@@ -31,8 +32,7 @@ namespace zuul
         int mWidth;
         int mHeight;
         bool mCollected;
-        std::shared_ptr<TilesetData> mTilesetData;
-        std::shared_ptr<Texture> mTexture;
+        std::shared_ptr<TilesetData> mTilesetData; // Also provides the texture, which hot reloads may replace
         CollectCallback mCollectCallback;
     };
 
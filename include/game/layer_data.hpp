@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zuul
+{
+    constexpr size_t BASE64_ERROR = static_cast<size_t>(-1);
+
+    // Decodes base64 text into out, skipping whitespace. Returns the number of bytes
+    // written, or BASE64_ERROR if the text is malformed or does not fit in capacity.
+    size_t decodeBase64(std::string_view text, uint8_t *out, size_t capacity);
+
+    // Decodes the data of a Tiled layer or chunk exported with "encoding": "base64".
+    // compression is the layer's "compression" field: "", "zlib", "gzip" or "zstd".
+    // The gids are written to gids, which must end up holding exactly cellCount tiles.
+    bool decodeLayerData(std::string_view text, const std::string &compression,
+                         size_t cellCount, std::vector<uint32_t> &gids);
+
+} // namespace zuul
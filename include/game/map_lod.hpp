@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <engine/asset_registry.hpp>
+#include <engine/draw_queue.hpp>
+#include <engine/renderer.hpp>
+#include <game/tilemap.hpp>
+
+namespace zuul
+{
+    class MapLodWorker;
+
+    // Downsampled images of every map chunk at 1/2, 1/4 and 1/8 scale, so a zoomed out
+    // map costs one quad per chunk instead of one per tile. Chunks are composited and
+    // downsampled by a MapLodWorker the first time they are drawn, then uploaded by
+    // update(). Edited chunks are regenerated; until then their old images are drawn.
+    class MapLod
+    {
+    public:
+        static constexpr int LEVEL_COUNT = 3; // Level n is drawn at 1 / 2^n scale
+
+        // The map and the worker must outlive the LOD
+        MapLod(TileMap &map, MapLodWorker &worker);
+        ~MapLod();
+
+        MapLod(const MapLod &) = delete;
+        MapLod &operator=(const MapLod &) = delete;
+
+        // Level to draw at a zoom: 0 means the tiles themselves, up to LEVEL_COUNT
+        static int levelForZoom(float zoom);
+
+        // Uploads chunks finished by the worker, at most maxUploads per call
+        void update(AssetRegistry &assets, int maxUploads = 16);
+
+        // Queues the chunks overlapping the view at a level above 0, requesting the
+        // missing ones. Chunks not generated yet are left out.
+        void queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom,
+                   int viewWidth, int viewHeight, int level);
+
+    private:
+        friend class MapLodWorker;
+
+        struct ChunkImages
+        {
+            std::array<TextureAsset, LEVEL_COUNT> levels;
+            int width = 0; // Of level 0, level n is width >> n wide
+            int height = 0;
+            uint32_t generation = 0; // Bumped by edits, results of older generations are dropped
+            bool requested = false;
+        };
+
+        struct JobTileset
+        {
+            std::shared_ptr<const TilesetImage> image;
+            int columns;
+            int tileWidth;
+            int tileHeight;
+        };
+
+        struct JobTile
+        {
+            uint16_t tileset;
+            uint16_t localId;
+            uint16_t cell;
+        };
+
+        // Everything the worker needs, copied so the map can change while it runs
+        struct Job
+        {
+            int chunkX;
+            int chunkY;
+            uint32_t generation;
+            int tileWidth;
+            int tileHeight;
+            std::vector<JobTileset> tilesets;
+            std::vector<JobTile> tiles; // Bottom layer first
+        };
+
+        struct Result
+        {
+            int chunkX;
+            int chunkY;
+            uint32_t generation;
+            std::array<std::vector<uint32_t>, LEVEL_COUNT> levels;
+            int width; // Of level 1
+            int height;
+        };
+
+        static uint64_t keyOf(int chunkX, int chunkY)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkY);
+        }
+
+        void onTilesChanged(std::span<const TileChange> changes);
+        void request(const TileGrid::Chunk &chunk, ChunkImages &images);
+        static Result generate(const Job &job);
+
+        TileMap &mMap;
+        MapLodWorker &mWorker;
+        uint32_t mClient; // Tags this LOD's jobs and results at the worker
+        std::shared_ptr<bool> mAlive; // Lets the map's tile change callback outlive this object
+        std::unordered_map<uint64_t, ChunkImages> mChunks;
+        uint32_t mContentGeneration;
+    };
+
+    // One background thread generating the chunk images of every MapLod that uses it, so
+    // a world with many maps doesn't keep a thread per map. The thread starts with the
+    // first client. Jobs run in the order they were pushed, whichever map they are for.
+    class MapLodWorker
+    {
+    public:
+        MapLodWorker() = default;
+        ~MapLodWorker();
+
+        MapLodWorker(const MapLodWorker &) = delete;
+        MapLodWorker &operator=(const MapLodWorker &) = delete;
+
+        // Registers a client; removing it drops its queued jobs and unclaimed results
+        uint32_t addClient();
+        void removeClient(uint32_t client);
+
+        void push(uint32_t client, MapLod::Job &&job);
+        // Moves up to maxResults finished results of the client into results
+        void takeResults(uint32_t client, size_t maxResults, std::pmr::vector<MapLod::Result> &results);
+
+    private:
+        struct QueuedJob
+        {
+            uint32_t client;
+            MapLod::Job job;
+        };
+
+        void workerLoop();
+
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mJobAvailable;
+        std::deque<QueuedJob> mJobs;
+        std::unordered_map<uint32_t, std::vector<MapLod::Result>> mResults; // By client
+        uint32_t mNextClient = 0;
+        bool mShuttingDown = false;
+    };
+
+} // namespace zuul
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <engine/draw_queue.hpp>
+#include <engine/renderer.hpp>
+#include <game/world.hpp>
+
+namespace zuul
+{
+    // The whole world in the top right corner of the screen, drawn from the coarsest
+    // chunk images of its maps, with a marker at the player
+    class Minimap
+    {
+    public:
+        Minimap(int width = 192, int height = 96, int margin = 8);
+
+        // Player position in world pixels
+        void render(Renderer &renderer, World &world, float playerX, float playerY, int windowWidth);
+
+    private:
+        DrawQueue mDrawQueue;
+        int mWidth;
+        int mHeight;
+        int mMargin;
+    };
+
+} // namespace zuul
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <game/tilemap.hpp>
+
+namespace zuul
+{
+    struct NavCell
+    {
+        int x;
+        int y;
+
+        bool operator==(const NavCell &other) const { return x == other.x && y == other.y; }
+    };
+
+    // Open list entry of the grid searches, a min-heap by priority
+    struct NavOpenEntry
+    {
+        float priority;
+        float cost;
+        int cell;
+
+        bool operator>(const NavOpenEntry &other) const { return priority > other.priority; }
+    };
+
+    // Direction to walk from every cell to reach one goal, shared by all agents heading
+    // there. Agents look up their cell and step to the neighbour it points at.
+    class FlowField
+    {
+    public:
+        FlowField(int width, int height, NavCell goal);
+
+        // False if the cell can't reach the goal or is the goal itself
+        bool getDirection(int x, int y, int &dx, int &dy) const;
+        float getDistance(int x, int y) const; // Infinite if unreachable
+        NavCell getGoal() const { return mGoal; }
+
+    private:
+        friend class NavGrid;
+
+        int mWidth;
+        int mHeight;
+        NavCell mGoal;
+        std::vector<float> mDistance;
+        std::vector<int8_t> mDirection; // Index into the 8 neighbour offsets, -1 for none
+    };
+
+    // Walkable tiles of a map, taken from its collision geometry: a tile is blocked if
+    // any collider overlaps it. Moves go to the 8 neighbours, but never diagonally past
+    // a blocked tile. Paths and flow fields are cached until the walkable tiles change;
+    // tile edits on the map mark their chunks, which the next query reads again.
+    class NavGrid
+    {
+    public:
+        // The map must outlive the grid
+        explicit NavGrid(TileMap &map);
+
+        NavGrid(const NavGrid &) = delete;
+        NavGrid &operator=(const NavGrid &) = delete;
+
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+        bool isWalkable(int x, int y) const
+        {
+            return x >= 0 && y >= 0 && x < mWidth && y < mHeight && mWalkable[static_cast<size_t>(y) * mWidth + x];
+        }
+
+        // Bumped whenever a tile becomes walkable or blocked
+        uint32_t getGeneration() const { return mGeneration; }
+        // Bumped for the 16x16 cluster that contains the changed tiles
+        uint32_t getClusterGeneration(int clusterX, int clusterY) const;
+
+        // A* with jump point search. The path lists every tile from start to goal.
+        // Returns false if the goal can't be reached.
+        bool findPath(NavCell start, NavCell goal, std::vector<NavCell> &path);
+
+        // Plain A* that never leaves the given tile rect, as used inside one cluster.
+        // Returns the path cost, or a negative value if there is no path.
+        float findCost(NavCell start, NavCell goal, int minX, int minY, int maxX, int maxY) const;
+
+        // Flow field towards a goal, computed on first use and then shared
+        std::shared_ptr<const FlowField> getFlowField(NavCell goal);
+
+        // Re-reads all walkable tiles if the map or its tilesets were reloaded, and the
+        // tiles around edits made since the last call. Queries call this themselves.
+        void update();
+
+    private:
+        static uint64_t keyOf(NavCell cell)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32) | static_cast<uint32_t>(cell.y);
+        }
+
+        void rebuild();
+        void onTilesChanged(std::span<const TileChange> changes);
+        bool updateArea(int minX, int minY, int maxX, int maxY);
+        void invalidate();
+        bool canStep(int x, int y, int dx, int dy) const;
+        bool jump(int x, int y, int dx, int dy, NavCell goal, NavCell &jumpPoint) const;
+        void findSuccessors(NavCell cell, NavCell parent, bool hasParent, std::vector<NavCell> &directions) const;
+
+        // Per-cell search state, valid only where stamp matches mSearchStamp
+        struct SearchNode
+        {
+            float cost;
+            int parent;
+            uint32_t stamp;
+        };
+
+        TileMap &mMap;
+        std::shared_ptr<bool> mAlive;
+        int mWidth;
+        int mHeight;
+        uint32_t mMapGeneration;
+        uint32_t mGeneration;
+        std::vector<uint8_t> mWalkable;
+        std::vector<uint32_t> mClusterGenerations;
+        int mClustersX;
+        std::unordered_set<uint64_t> mPendingChunks; // Edited since the last update()
+
+        // Cached results, dropped whenever the walkable tiles change
+        std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::vector<NavCell>>> mPathCache; // By goal, then start
+        std::unordered_map<uint64_t, std::shared_ptr<const FlowField>> mFlowFields;
+        size_t mCachedPaths;
+
+        // Reused by findPath, so a query only touches the cells it visits: bumping the
+        // stamp resets every node at once
+        std::vector<SearchNode> mSearchNodes;
+        uint32_t mSearchStamp = 0;
+        std::vector<NavOpenEntry> mOpenScratch;
+        std::vector<NavCell> mDirectionScratch;
+        std::vector<NavCell> mJumpPointScratch;
+    };
+
+} // namespace zuul
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <game/nav_grid.hpp>
+#include <game/world.hpp>
+
+namespace zuul
+{
+    struct NavPoint
+    {
+        int map; // Index into World::getMaps()
+        int x;   // Tile in that map
+        int y;
+
+        bool operator==(const NavPoint &other) const { return map == other.map && x == other.x && y == other.y; }
+    };
+
+    // Pathfinding across all maps of a world. Maps are split into 16x16 tile clusters
+    // joined by entrances on their borders, including the borders where two maps of the
+    // world touch. Long routes are searched on that small graph first (hierarchical A*)
+    // and only then refined tile by tile with each map's NavGrid.
+    class NavWorld
+    {
+    public:
+        // The world must outlive this and keep its maps
+        void build(World &world);
+
+        bool findPath(NavPoint start, NavPoint goal, std::vector<NavPoint> &path);
+
+        // Tile under a world position in pixels, false if no map is there
+        bool locate(float worldX, float worldY, NavPoint &point) const;
+        // Center of a tile in world pixels
+        void getCenter(const NavPoint &point, float &worldX, float &worldY) const;
+
+        NavGrid *getGrid(int map) { return mGrids[map].get(); }
+        size_t getNodeCount() const { return mNodes.size(); }
+
+    private:
+        struct Edge
+        {
+            int node;
+            float cost;
+        };
+
+        struct Node
+        {
+            NavPoint point;
+            int cluster;
+            float worldX; // Position in world tiles, for the heuristic
+            float worldY;
+            std::vector<Edge> edges;
+        };
+
+        struct Cluster
+        {
+            std::vector<int> nodes;
+
+            // Costs between all pairs of entrances, kept while neither the cluster nor
+            // its entrances change
+            uint32_t generation = 0;
+            std::vector<NavCell> cells;
+            std::vector<float> costs;
+        };
+
+        void update();
+        void rebuildGraph();
+        void scanBorder(int mapA, NavCell a, int mapB, NavCell b, int stepX, int stepY, int length);
+        void addEntrance(int mapA, NavCell a, int mapB, NavCell b);
+        int addNode(const NavPoint &point);
+        void connectCluster(int cluster);
+        int clusterOf(const NavPoint &point) const;
+        bool findAbstractPath(NavPoint start, NavPoint goal, std::vector<NavPoint> &waypoints);
+
+        World *mWorld = nullptr;
+        std::vector<std::unique_ptr<NavGrid>> mGrids;
+        std::vector<int> mClusterOffsets; // First cluster of every map
+        std::vector<int> mClustersX;
+        std::vector<Cluster> mClusters;
+        std::vector<Node> mNodes;
+        std::map<std::tuple<int, int, int>, int> mNodeIndex;
+        uint64_t mGeneration = ~0ull; // Sum of the grid generations the graph was built for
+
+        std::map<std::pair<uint64_t, uint64_t>, std::vector<NavPoint>> mPathCache;
+        std::vector<NavCell> mScratchCells; // Reused by findPath, so cached queries don't allocate
+    };
+
+} // namespace zuul
@@ -2,6 +2,7 @@
 
 #include <SDL2/SDL.h>
 #include <engine/renderer.hpp>
+#include <engine/draw_queue.hpp>
 #include <game/tileset_data.hpp>
 #include <memory>
 
@@ -23,9 +24,10 @@ namespace zuul
         Player();
         ~Player() = default;
 
-        bool initialize(std::shared_ptr<Renderer> renderer);
+        bool initialize(AssetRegistry &assets);
         void update(float deltaTime, const TileMap &tileMap);
-        void render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom);
+        void queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom) const;
+        void renderDebug(Renderer &renderer, float offsetX, float offsetY, float zoom);
 
         void setPosition(float x, float y)
         {
@@ -43,7 +45,7 @@ namespace zuul
 
         Direction mDirection;
         std::shared_ptr<TilesetData> mTilesetData;
-        std::shared_ptr<Texture> mTexture;
+        TextureAsset mTexture;
         float mX;
         float mY;
         float mSpeed;
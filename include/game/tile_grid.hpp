@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zuul
+{
+    // Tiled stores flip flags in the top three bits of every gid
+    constexpr uint32_t FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
+    constexpr uint32_t FLIPPED_VERTICALLY_FLAG = 0x40000000;
+    constexpr uint32_t FLIPPED_DIAGONALLY_FLAG = 0x20000000;
+    constexpr uint32_t ALL_FLIP_FLAGS = FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG;
+
+    // Sparse storage for all tile layers of a map, in 16x16 chunks keyed by chunk
+    // coordinate. Chunks are only allocated once a non-empty tile is stored in them.
+    // Tiles are 16-bit indices into a palette of the gids used in the grid, with the
+    // flip flags removed (0 is empty), so any gid fits as long as a map uses fewer
+    // than 65536 different tiles. Flips live in per-chunk bitplanes that are only
+    // allocated once a flipped tile is stored.
+    class TileGrid
+    {
+    public:
+        enum class Layout
+        {
+            Cell,  // All layers of a cell are adjacent: one cache line holds the full stack
+            Chunk  // One 16x16 plane per layer inside each chunk
+        };
+
+        static constexpr int CHUNK_SIZE = 16;
+        static constexpr int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+        static constexpr size_t MAX_PALETTE_SIZE = 0x10000;
+        static constexpr uint16_t NO_COMPOSITE = 0xFFFF;
+
+        struct Chunk
+        {
+            int chunkX;
+            int chunkY;
+            std::vector<uint16_t> tiles;
+            std::vector<uint64_t> flipPlanes[3]; // Horizontal, vertical, diagonal; indexed like tiles
+
+            // Storing a tile marks the chunk dirty; TileMap rebuilds the data it derives
+            // from the chunk the next time it draws it
+            mutable bool dirty = true;
+        };
+
+        TileGrid();
+
+        void reset(int layerCount, Layout layout = Layout::Cell);
+
+        // Returns false if the palette is full and the gid is not in it yet
+        bool setGid(int layer, int x, int y, uint32_t gid);
+        uint32_t getGid(int layer, int x, int y) const;
+
+        // Gid without flip flags of a stored tile
+        uint32_t getPaletteGid(uint16_t tile) const { return mPalette[tile]; }
+
+        uint16_t getTile(int layer, int x, int y) const
+        {
+            const Chunk *chunk = findChunk(x >> 4, y >> 4);
+            return chunk ? chunk->tiles[indexOf(layer, cellOf(x, y))] : 0;
+        }
+        uint8_t getFlips(int layer, int x, int y) const;
+
+        // Chunk-local access for loops that walk whole chunks
+        uint16_t getTile(const Chunk &chunk, int layer, int cell) const { return chunk.tiles[indexOf(layer, cell)]; }
+        static int cellOf(int x, int y) { return (y & (CHUNK_SIZE - 1)) * CHUNK_SIZE + (x & (CHUNK_SIZE - 1)); }
+
+        Chunk *findChunk(int chunkX, int chunkY);
+        const Chunk *findChunk(int chunkX, int chunkY) const;
+
+        // True if the chunks hold the same gids and flips, even if the grids' palettes differ
+        bool sameTiles(const Chunk &chunk, const TileGrid &other, const Chunk &otherChunk) const;
+
+        // Calls fn for every allocated chunk overlapping the half-open tile rect [x0, x1) x [y0, y1)
+        template <typename Fn>
+        void forEachChunk(int x0, int y0, int x1, int y1, Fn &&fn) const;
+        template <typename Fn>
+        void forEachChunk(Fn &&fn) const;
+
+        // Tile bounds of all allocated chunks, as a half-open rect
+        int getMinX() const { return mMinChunkX * CHUNK_SIZE; }
+        int getMinY() const { return mMinChunkY * CHUNK_SIZE; }
+        int getMaxX() const { return (mMaxChunkX + 1) * CHUNK_SIZE; }
+        int getMaxY() const { return (mMaxChunkY + 1) * CHUNK_SIZE; }
+
+        int getLayerCount() const { return mLayerCount; }
+        Layout getLayout() const { return mLayout; }
+        size_t getChunkCount() const { return mChunks.size(); }
+        size_t getMemoryUsage() const;
+
+        // Unique key of a chunk coordinate, for maps of per-chunk data
+        static uint64_t keyOf(int chunkX, int chunkY)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkY);
+        }
+
+    private:
+
+        size_t indexOf(int layer, int cell) const
+        {
+            return mLayout == Layout::Cell ? static_cast<size_t>(cell) * mLayerCount + layer
+                                           : static_cast<size_t>(layer) * CHUNK_CELLS + cell;
+        }
+
+        std::unordered_map<uint64_t, Chunk> mChunks;
+        std::vector<uint32_t> mPalette; // Gid of every tile, in the order they were first stored
+        std::unordered_map<uint32_t, uint16_t> mPaletteTiles; // Gid -> tile
+        int mLayerCount;
+        Layout mLayout;
+        int mMinChunkX;
+        int mMinChunkY;
+        int mMaxChunkX;
+        int mMaxChunkY;
+    };
+
+    template <typename Fn>
+    void TileGrid::forEachChunk(int x0, int y0, int x1, int y1, Fn &&fn) const
+    {
+        if (x0 >= x1 || y0 >= y1)
+        {
+            return;
+        }
+
+        int firstX = x0 >> 4;
+        int firstY = y0 >> 4;
+        int lastX = (x1 - 1) >> 4;
+        int lastY = (y1 - 1) >> 4;
+
+        // Looking up every coordinate is cheaper unless the rect spans more chunks than exist
+        size_t coordinates = static_cast<size_t>(lastX - firstX + 1) * (lastY - firstY + 1);
+        if (coordinates <= mChunks.size())
+        {
+            for (int chunkY = firstY; chunkY <= lastY; ++chunkY)
+            {
+                for (int chunkX = firstX; chunkX <= lastX; ++chunkX)
+                {
+                    if (const Chunk *chunk = findChunk(chunkX, chunkY))
+                    {
+                        fn(*chunk);
+                    }
+                }
+            }
+            return;
+        }
+
+        for (const auto &[key, chunk] : mChunks)
+        {
+            if (chunk.chunkX >= firstX && chunk.chunkX <= lastX && chunk.chunkY >= firstY && chunk.chunkY <= lastY)
+            {
+                fn(chunk);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void TileGrid::forEachChunk(Fn &&fn) const
+    {
+        for (const auto &[key, chunk] : mChunks)
+        {
+            fn(chunk);
+        }
+    }
+
+} // namespace zuul
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zuul
+{
+    // Keys of the containers leading to an object, skipping array indices.
+    // A tile animation frame in a tileset is at {"tiles", "animation"}.
+    struct TiledPath
+    {
+        std::vector<std::string> keys;
+
+        bool is(std::initializer_list<std::string_view> expected) const
+        {
+            return std::equal(keys.begin(), keys.end(), expected.begin(), expected.end());
+        }
+    };
+
+    // An object read from a Tiled JSON file, without its nested containers
+    struct TiledObject
+    {
+        nlohmann::json fields = nlohmann::json::object(); // Numbers, strings, bools and arrays of them
+        std::vector<uint32_t> data;                        // Numeric "data" array (layer or chunk gids)
+        bool hasData = false;
+    };
+
+    using TiledObjectHandler = std::function<void(const TiledPath &path, TiledObject &object)>;
+
+    // Streams a Tiled map or tileset and calls onObject for every object once it is
+    // complete, innermost objects first. No DOM of the file is built: numeric "data"
+    // arrays are cut out of the text and parsed separately, large ones in parallel,
+    // so tile ids never become json nodes. Returns false if the file can't be read
+    // or is not valid JSON.
+    bool readTiledFile(const std::string &filepath, const TiledObjectHandler &onObject);
+
+} // namespace zuul
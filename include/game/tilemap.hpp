@@ -1,13 +1,22 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <engine/asset_registry.hpp>
 #include <engine/renderer.hpp>
+#include <engine/draw_queue.hpp>
 #include <game/tileset_data.hpp>
+#include <game/tile_grid.hpp>
+#include <game/collision_world.hpp>
+#include <array>
 #include <memory>
 #include <vector>
 #include <string>
 #include <game/item.hpp>
 #include <functional>
+#include <map>
+#include <set>
+#include <span>
+#include <unordered_map>
 
 namespace zuul
 {
@@ -15,8 +24,71 @@ namespace zuul
     struct MapLayer
     {
         std::string name;
-        std::vector<unsigned int> tileData;
         bool visible;
+        bool ySorted; // Tiles are depth sorted against sprites (Tiled layer property "ysort")
+    };
+
+    // A tileset referenced by the map, covering gids [firstGid, firstGid + tileCount)
+    struct MapTileset
+    {
+        int firstGid;
+        std::shared_ptr<TilesetData> data;
+        TextureHandle texture; // Owned by data
+        int columns;
+        int tileWidth;
+        int tileHeight;
+        bool oversized; // Tiles larger than the map grid are drawn from the cell's bottom left corner
+    };
+
+    // A runtime tile edit; gid may carry flip flags and 0 clears the cell
+    struct TileChange
+    {
+        int layer;
+        int x;
+        int y;
+        uint32_t gid;
+    };
+
+    // Entry of the flat gid lookup table built at load time
+    struct GidEntry
+    {
+        static constexpr uint16_t NO_TILESET = 0xFFFF;
+
+        uint16_t tileset; // Index into the map's tilesets, NO_TILESET for empty or unknown gids
+        uint16_t localId;
+    };
+
+    // A map read from disk without touching the renderer, so it can be parsed on any
+    // thread and then loaded into or patched onto a TileMap on the render thread
+    struct MapSnapshot
+    {
+        struct Tileset
+        {
+            int firstGid;
+            std::shared_ptr<TilesetData> data; // Read, texture not loaded yet
+        };
+
+        struct ItemPlacement
+        {
+            int tileset;
+            int localId;
+            float x;
+            float y;
+        };
+
+        std::string filepath;
+        int width = 0;
+        int height = 0;
+        int tileWidth = 0;
+        int tileHeight = 0;
+        std::vector<MapLayer> layers;
+        std::vector<Tileset> tilesets;
+        std::vector<GidEntry> gidTable;
+        std::vector<ItemPlacement> items;
+        TileGrid tiles;
+
+        // Fills gidTable from tilesets
+        void buildGidTable();
     };
 
     class TileMap
@@ -25,47 +97,155 @@ namespace zuul
         TileMap();
         virtual ~TileMap() = default;
 
-        bool loadFromFile(const std::string &filepath, std::shared_ptr<Renderer> renderer);
+        bool loadFromFile(const std::string &filepath, AssetRegistry &assets);
+
+        // Loading in two steps, as for tilesets. readSnapshot returns nullptr on failure.
+        static std::shared_ptr<MapSnapshot> readSnapshot(const std::string &filepath, TileGrid::Layout layout);
+        bool loadSnapshot(MapSnapshot &&snapshot, AssetRegistry &assets);
+
+        // Hot reload: applies only the cells that differ from a newly read snapshot through
+        // setTiles, keeping items and their collected state. Falls back to loadSnapshot
+        // if the map size, layer count or tilesets changed.
+        bool patchFromSnapshot(MapSnapshot &&snapshot, AssetRegistry &assets);
+
+        // Picks up tilesets that were patched or had their image reloaded. Drops the
+        // baked composites, which have to be baked again.
+        void refreshTilesets();
         void update(float deltaTime);
-        virtual void render(std::shared_ptr<Renderer> renderer, float offsetX = 0.0f, float offsetY = 0.0f, float zoom = 1.0f);
-        void renderDebugCollisions(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom);
+        virtual void render(Renderer &renderer, float offsetX = 0.0f, float offsetY = 0.0f, float zoom = 1.0f);
+        void queueTiles(DrawQueue &queue, float offsetX, float offsetY, float zoom) const;
+
+        // Optional: composites each unique stack of static tiles below the entity layer
+        // into a generated atlas, so those cells render with a single draw
+        bool bakeCompositeTiles(AssetRegistry &assets);
+        void renderDebugCollisions(Renderer &renderer, float offsetX, float offsetY, float zoom);
 
-        // Collision detection
+        // Collision detection. Solid tiles and tile collision boxes are merged into a few
+        // larger colliders per chunk at load time. Edits only mark their chunks; those are
+        // merged again, and the BVH rebuilt once, by the next query after any number of edits.
         bool checkCollision(float x, float y, float width, float height) const;
+        const CollisionWorld &getCollisionWorld() const
+        {
+            if (!mDirtyColliderChunks.empty())
+            {
+                updateCollision();
+            }
+            return mCollision;
+        }
+
+        // Runtime edits. Only the touched chunks are invalidated and rebuilt lazily when
+        // next drawn; systems that derive data from tiles subscribe to the applied changes.
+        // Changes outside the map or with gids that have no tileset are ignored.
+        bool setTile(int layer, int x, int y, uint32_t gid);
+        size_t setTiles(std::span<const TileChange> changes);
+        uint32_t getTile(int layer, int x, int y) const { return mTiles.getGid(layer, x, y); }
+        void addTileChangeCallback(std::function<void(std::span<const TileChange>)> callback);
+
+        // Memory layout of the tile grid, used by the next loadFromFile
+        void setTileLayout(TileGrid::Layout layout) { mTileLayout = layout; }
+        TileGrid::Layout getTileLayout() const { return mTileLayout; }
+
+        // Size of the area the map is drawn into, used to find the visible tiles
+        void setViewSize(int width, int height)
+        {
+            mWindowWidth = width;
+            mWindowHeight = height;
+        }
 
         // Debug options
         void setDebugRendering(bool enabled) { mDebugRendering = enabled; }
         bool getDebugRendering() const { return mDebugRendering; }
 
-        // Getters
+        // Getters. Infinite maps are shifted so their used area starts at tile 0, 0
         int getWidth() const { return mWidth; }
         int getHeight() const { return mHeight; }
         int getTileWidth() const { return mTileWidth; }
         int getTileHeight() const { return mTileHeight; }
+        const std::string &getFilepath() const { return mFilepath; }
+        const std::vector<MapTileset> &getTilesets() const { return mTilesets; }
+        const std::vector<MapLayer> &getLayers() const { return mLayers; }
+        const TileGrid &getTileGrid() const { return mTiles; }
+
+        // Tileset and local tile id of a tile stored in the grid, through its gid, or nullptr
+        // for empty cells and gids of tilesets that failed to load
+        const MapTileset *resolveTile(uint16_t tile, int &localId) const
+        {
+            const GidEntry entry = mGidTable[mTiles.getPaletteGid(tile)];
+            localId = entry.localId;
+            return entry.tileset != GidEntry::NO_TILESET ? &mTilesets[entry.tileset] : nullptr;
+        }
+
+        // Changes whenever tilesets, layer properties or the whole map were reloaded; tile edits are
+        // reported through the tile change callbacks instead
+        uint32_t getContentGeneration() const { return mContentGeneration; }
+
+        // Draw queue layer shared by sprites and the first y-sorted tile layer.
+        // Tile layers above it are drawn over sprites (roofs, tree tops).
+        uint8_t getEntityLayer() const { return mEntityLayer; }
 
         // Item handling
         void checkItemCollisions(float x, float y, float width, float height) const;
-        void renderItems(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom);
+        void queueItems(DrawQueue &queue, float offsetX, float offsetY, float zoom) const;
         void setItemCollectCallback(std::function<void(int)> callback);
 
     protected:
         std::pair<int, int> worldToTile(float x, float y) const;
+        void updateEntityLayer();
+
+        // Culling and composite data of the cells of a chunk, derived from its tiles
+        struct ChunkCells
+        {
+            std::array<uint8_t, TileGrid::CHUNK_CELLS> firstVisibleLayer;
+            std::array<uint16_t, TileGrid::CHUNK_CELLS> composite;
+        };
+
+        // Creates the cell data of a chunk on first use and rebuilds it once the chunk is dirty
+        const ChunkCells &getChunkCells(const TileGrid::Chunk &chunk) const;
+        void refreshChunk(const TileGrid::Chunk &chunk, ChunkCells &cells) const;
+        void rebuildColliders();
+        void rebuildChunkColliders(int chunkX, int chunkY) const;
+        void buildCollisionWorld() const;
+        void updateCollision() const;
+        uint8_t findFirstVisibleLayer(const TileGrid::Chunk &chunk, int cell) const;
+        bool findStaticStack(const TileGrid::Chunk &chunk, int cell, int firstLayer, std::vector<uint16_t> &stack) const;
 
-        std::shared_ptr<Texture> mTileset;
-        std::shared_ptr<TilesetData> mTilesetData;
+        std::string mFilepath;
+        std::vector<MapTileset> mTilesets;
+        std::vector<GidEntry> mGidTable; // Indexed by gid without flip flags
         std::vector<MapLayer> mLayers;
+        TileGrid mTiles;
+        TileGrid::Layout mTileLayout;
 
         int mWidth;
         int mHeight;
         int mTileWidth;
         int mTileHeight;
-        int mTilesetColumns;
         int mWindowWidth;
         int mWindowHeight;
         bool mDebugRendering;
+        uint8_t mEntityLayer;
+        uint32_t mContentGeneration;
+        DrawQueue mDrawQueue;
+
+        // Baked layer stacks covering layers below mFlattenedLayerEnd; cells index the atlas per chunk.
+        // Edited cells whose new stack was not baked fall back to drawing every tile.
+        TextureAsset mCompositeAtlas;
+        std::map<std::vector<uint16_t>, int> mCompositeStacks;
+        int mCompositeColumns;
+        uint8_t mFlattenedLayerEnd;
+
+        // Only held for chunks that were drawn, by TileGrid::keyOf; dropped whenever the
+        // tilesets, layers or composites change
+        mutable std::unordered_map<uint64_t, ChunkCells> mChunkCells;
+
+        // Brought up to date by getCollisionWorld(), so they change in const queries
+        mutable CollisionWorld mCollision;
+        mutable std::map<std::pair<int, int>, std::vector<CollisionBox>> mChunkColliders;
+        mutable std::set<std::pair<int, int>> mDirtyColliderChunks;
 
         mutable std::vector<Item> mItems;
         std::function<void(int)> mItemCollectCallback;
+        std::vector<std::function<void(std::span<const TileChange>)>> mTileChangeCallbacks;
     };
 
 } // namespace zuul
\ No newline at end of file
@@ -4,10 +4,15 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <optional>
+#include <cstdint>
+#include <engine/asset_registry.hpp>
 #include <engine/renderer.hpp>
 
 namespace zuul
 {
+    struct TiledPath;
+    struct TiledObject;
 
     struct AnimationFrame
     {
@@ -30,18 +35,52 @@ namespace zuul
         float height;
     };
 
+    // Alpha coverage of a tile, used to skip tiles hidden under opaque ones
+    enum class TileOpacity : uint8_t
+    {
+        Transparent,
+        Opaque,
+        Mixed
+    };
+
+    // CPU copy of a tileset image in ARGB8888. Replaced, never modified, when the image
+    // reloads, so background jobs can keep reading the copy they were given.
+    struct TilesetImage
+    {
+        int width;
+        int height;
+        ::std::vector<uint32_t> pixels;
+    };
+
     struct TilesetInfo
     {
         int columns;
         int tileWidth;
         int tileHeight;
+        int tileCount;
         ::std::string imagePath;
     };
 
     class TilesetData
     {
     public:
-        bool loadFromFile(const ::std::string &filepath, std::shared_ptr<Renderer> renderer);
+        bool loadFromFile(const ::std::string &filepath, AssetRegistry &assets);
+
+        // Loading in two steps: reading parses the file and can run on any thread,
+        // finishing loads the texture on the render thread
+        bool readFromFile(const ::std::string &filepath);
+        bool finishLoading(AssetRegistry &assets);
+
+        // Tilesets embedded in a map are fed the objects below the map's "tilesets" key,
+        // then given the map's directory to resolve the image path
+        void readObject(const TiledPath &path, TiledObject &object);
+        void resolveImagePath(const ::std::string &directory);
+
+        // Hot reload: takes over the tiles that differ in a freshly read copy of this
+        // tileset, reloading the image only if it or the tile layout changed
+        bool patchFrom(const TilesetData &other, AssetRegistry &assets);
+        bool reloadImage(AssetRegistry &assets);
+
         void update(float deltaTime);
 
         // Animation methods
@@ -54,19 +93,39 @@ namespace zuul
         const CollisionBox *getCollisionBox(int tileId) const;
         bool isSolid(int tileId) const;
 
+        // Opacity methods. Animated tiles only count as opaque if every frame is.
+        TileOpacity getOpacity(int tileId) const;
+        bool isOpaque(int tileId) const { return getOpacity(tileId) == TileOpacity::Opaque; }
+
         // Tileset info
         const TilesetInfo &getTilesetInfo() const { return mTilesetInfo; }
-        std::shared_ptr<Texture> getTexture() const { return mTexture; }
+        TextureHandle getTexture() const { return mTexture.get(); }
+        std::shared_ptr<const TilesetImage> getImage() const { return mImage; }
+        const ::std::string &getSourcePath() const { return mSourcePath; } // Empty for embedded tilesets
+        const ::std::string &getImagePath() const { return mImagePath; }
 
         // Render methods
-        void renderTile(std::shared_ptr<Renderer> renderer, int tileId, float x, float y, float zoom = 1.0f) const;
+        void renderTile(Renderer &renderer, int tileId, float x, float y, float zoom = 1.0f) const;
 
     private:
+        // Decodes the image and creates or, on reload, replaces its texture from the same pixels
+        bool loadImage(AssetRegistry &assets, bool reload);
+        void analyseOpacity();
+
         ::std::map<int, TileAnimation> mAnimations;
         ::std::map<int, CollisionBox> mCollisionBoxes;
         ::std::map<int, bool> mSolidTiles;
+        ::std::vector<TileOpacity> mOpacity;
         TilesetInfo mTilesetInfo;
-        std::shared_ptr<Texture> mTexture;
+        TextureAsset mTexture;
+        std::shared_ptr<const TilesetImage> mImage;
+        ::std::string mSourcePath;
+        ::std::string mImagePath;
+
+        // Child objects complete before their tile, so they are held until the tile's id is known
+        TileAnimation mPendingAnimation;
+        ::std::optional<CollisionBox> mPendingCollisionBox;
+        ::std::optional<bool> mPendingSolid;
     };
 
 } // namespace zuul
\ No newline at end of file
@@ -3,24 +3,29 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <engine/asset_registry.hpp>
 #include <engine/renderer.hpp>
+#include <engine/scene.hpp>
 
 namespace zuul
 {
-    class TitleScreen
+    // Finished by any key press. It stays up, animating and saying it is loading, until
+    // the scene replacing it has loaded.
+    class TitleScreen : public Scene
     {
     public:
         TitleScreen();
         ~TitleScreen() = default;
 
-        bool initialize(std::shared_ptr<Renderer> renderer);
-        void update(float deltaTime);
-        void render(std::shared_ptr<Renderer> renderer);
-        bool isDone() const { return mIsDone; }
+        std::span<const AssetId> getAssets() const override;
+        SceneLoad load(AssetRegistry &assets) override;
+        void update(float deltaTime) override;
+        void render(Renderer &renderer) override;
+        bool isFinished() const override { return mIsDone; }
 
     private:
-        std::shared_ptr<Texture> mBackground;
-        std::vector<std::shared_ptr<Texture>> mFrames;
+        TextureAsset mBackground;
+        std::vector<TextureAsset> mFrames;
         float mAnimationTimer;
         float mFrameDuration;
         float mBlinkTimer;
@@ -8,23 +8,34 @@
 
 namespace zuul
 {
+    // The item bar at the bottom of the screen. It is composited into its own render
+    // target, rebuilt only when the collected items, the window size or the map change,
+    // and drawn with a single blit every frame.
     class UI : public TileMap
     {
     public:
         UI();
         ~UI() override = default;
 
-        bool initialize(std::shared_ptr<Renderer> renderer);
-        void render(std::shared_ptr<Renderer> renderer, float offsetX = 0.0f, float offsetY = 0.0f, float zoom = 1.0f) override;
+        // The bar is manifest::UI_MAP, read with readSnapshot
+        bool initialize(MapSnapshot &&snapshot, AssetRegistry &assets);
+        void render(Renderer &renderer, float offsetX = 0.0f, float offsetY = 0.0f, float zoom = 1.0f) override;
 
         // Item collection
         void addCollectedItem(int itemId);
         int getCollectedItemCount(int itemId) const;
 
     private:
+        void rebuild(Renderer &renderer, float stretchZoom, int barHeight);
+        void drawBar(Renderer &renderer, float top, float stretchZoom);
+
         std::map<int, int> mCollectedItems; // itemId -> count
-        int mWindowWidth;
-        int mWindowHeight;
+        AssetRegistry *mAssets = nullptr;
+        TextureAsset mTarget;
+        bool mDirty = true;
+        uint32_t mBuiltGeneration = 0;
+        int mWindowWidth = 0;
+        int mWindowHeight = 0;
     };
 
 } // namespace zuul
\ No newline at end of file
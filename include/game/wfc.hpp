@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <game/tilemap.hpp>
+
+namespace zuul
+{
+    // Adjacency rules for wave function collapse, taken from the wang sets of a Tiled
+    // tileset. Tiles with the same wang colours form one pattern; two patterns may
+    // touch where the colours along the shared edge match. A tile that isn't part of
+    // a wang set counts as the colour named by the string property "base" of its own
+    // wang set, e.g. road tiles count as grass next to water tiles. Tile probabilities
+    // set in Tiled weight the patterns and pick between the tiles of a pattern.
+    class WfcRules
+    {
+    public:
+        bool loadFromFile(const std::string &filepath);
+
+        int getPatternCount() const { return static_cast<int>(mPatterns.size()); }
+        const std::string &getTilesetPath() const { return mTilesetPath; }
+
+    private:
+        friend class WfcGenerator;
+
+        struct Pattern
+        {
+            std::vector<int> tiles; // Tile ids in the tileset
+            std::vector<float> tileWeights;
+            float weight;
+        };
+
+        std::vector<Pattern> mPatterns;
+        int mWords = 0; // 64 bit words in a set of patterns
+        // Patterns allowed next to each pattern, as pattern sets indexed by
+        // (direction * patterns + pattern) * words. Directions: east, west, south, north.
+        std::vector<uint64_t> mCompatible;
+        std::string mTilesetPath;
+    };
+
+    // Generates tile maps with wave function collapse. Every cell holds the set of
+    // patterns it can still become as a bitset; the cell with the lowest entropy is
+    // collapsed next, and propagation intersects the neighbours' sets with the patterns
+    // allowed next to it. Large maps are split into regions by a lattice of seam rows
+    // and columns, which are collapsed first; the regions between them no longer
+    // depend on each other and are filled in parallel.
+    class WfcGenerator
+    {
+    public:
+        explicit WfcGenerator(const WfcRules &rules);
+
+        // Fills tiles with one tile id per cell, row by row. The same seed gives the
+        // same map. Returns false if contradictions persist after several retries.
+        bool generate(int width, int height, uint32_t seed, std::vector<int> &tiles) const;
+
+        // A generated one layer map, ready for TileMap::loadSnapshot
+        std::shared_ptr<MapSnapshot> generateMap(int width, int height, uint32_t seed,
+                                                 TileGrid::Layout layout = TileGrid::Layout::Cell) const;
+
+    private:
+        const WfcRules &mRules;
+    };
+
+} // namespace zuul
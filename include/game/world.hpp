@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <engine/asset_id.hpp>
+#include <engine/asset_registry.hpp>
+#include <engine/draw_queue.hpp>
+#include <engine/renderer.hpp>
+#include <game/map_lod.hpp>
+#include <game/tilemap.hpp>
+
+namespace zuul
+{
+    // A world file with its maps read, see MapSnapshot
+    struct WorldSnapshot
+    {
+        struct Placement
+        {
+            int x;
+            int y;
+            std::shared_ptr<MapSnapshot> map;
+        };
+
+        std::string filepath;
+        std::vector<Placement> maps;
+    };
+
+    struct WorldMap
+    {
+        int x; // Position in the world in pixels
+        int y;
+        uint64_t pathHash; // Of the path the map was loaded from
+        std::unique_ptr<TileMap> map;
+        std::unique_ptr<MapLod> lod; // Declared after map, so it is destroyed first
+    };
+
+    // All maps of a Tiled .world file with their placement
+    class World
+    {
+    public:
+        World() = default;
+
+        World(const World &) = delete;
+        World &operator=(const World &) = delete;
+
+        bool loadFromFile(const std::string &filepath, AssetRegistry &assets);
+
+        // Loading in two steps, as for maps: readSnapshot parses the world and its maps on
+        // any thread and returns nullptr on failure, loadSnapshot creates their textures.
+        static std::shared_ptr<WorldSnapshot> readSnapshot(const std::string &filepath);
+        bool loadSnapshot(WorldSnapshot &&snapshot, AssetRegistry &assets);
+
+        // Uploads the chunk images generated since the last call
+        void update(AssetRegistry &assets);
+
+        // Queues every map overlapping the view, in world coordinates. Below 1:1 zoom the
+        // maps are drawn from their chunk images, so the whole world stays cheap to draw.
+        void queue(DrawQueue &queue, float offsetX, float offsetY, float zoom, int viewWidth, int viewHeight);
+
+        // Finds a map of the manifest, e.g. manifest::HOME_MAP
+        WorldMap *findMap(AssetId map);
+        const std::vector<WorldMap> &getMaps() const { return mMaps; }
+
+        // Pixel bounds of all maps
+        int getMinX() const { return mMinX; }
+        int getMinY() const { return mMinY; }
+        int getMaxX() const { return mMaxX; }
+        int getMaxY() const { return mMaxY; }
+
+    private:
+        MapLodWorker mLodWorker; // Shared by the maps' LODs, declared first so it outlives them
+        std::vector<WorldMap> mMaps;
+        int mMinX = 0;
+        int mMinY = 0;
+        int mMaxX = 0;
+        int mMaxY = 0;
+    };
+
+} // namespace zuul
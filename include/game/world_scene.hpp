@@ -0,0 +1,84 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <vector>
+#include <engine/draw_queue.hpp>
+#include <engine/dynamic_resolution.hpp>
+#include <engine/game.hpp>
+#include <engine/scene.hpp>
+#include <game/tilemap.hpp>
+#include <game/hot_reload.hpp>
+#include <game/minimap.hpp>
+#include <game/nav_world.hpp>
+#include <game/world.hpp>
+#include <game/player.hpp>
+#include <game/camera.hpp>
+#include <game/ui.hpp>
+
+namespace zuul
+{
+    // The world with the player, camera and UI
+    class WorldScene : public Scene
+    {
+    public:
+        // The game supplies the frame times that pick the render resolution
+        WorldScene(const Game &game, int windowWidth, int windowHeight);
+        ~WorldScene() = default;
+
+        std::span<const AssetId> getAssets() const override;
+        SceneLoad load(AssetRegistry &assets) override;
+        void update(float deltaTime) override;
+        void render(Renderer &renderer) override;
+
+    private:
+        // Loading runs in phases, so the scene below keeps drawing: the world and UI maps
+        // are parsed on a background thread, then set up on the main thread one phase per
+        // frame
+        enum class LoadPhase : uint8_t
+        {
+            Reading,
+            World,
+            Player,
+            UI,
+            Done
+        };
+
+        struct StartupFiles
+        {
+            std::shared_ptr<WorldSnapshot> world;
+            std::shared_ptr<MapSnapshot> ui;
+        };
+
+        // Returns false if loading failed
+        bool loadNextPhase();
+        void renderWorld(Renderer &renderer);
+        void renderOverview(Renderer &renderer);
+        void renderDebugPath(Renderer &renderer, float offsetX, float offsetY, float zoom);
+        // Allocation counts of the last frame, in builds with allocation tracking
+        void renderAllocStats(Renderer &renderer);
+
+        const Game &mGame;
+        AssetRegistry *mAssets = nullptr; // Set by load()
+        World mWorld;
+        WorldMap *mCurrentMap = nullptr;
+        TileMap *mTileMap = nullptr; // The current map, owned by mWorld
+        std::unique_ptr<Player> mPlayer;
+        std::unique_ptr<Camera> mCamera;
+        std::unique_ptr<UI> mUI;
+        Minimap mMinimap;
+        NavWorld mNavWorld;
+        std::vector<NavPoint> mDebugPath;
+        HotReloader mHotReloader;
+        DrawQueue mDrawQueue;
+        DynamicResolution mResolution{1.0f / 60.0f};
+        TextureAsset mWorldTarget;
+        std::future<StartupFiles> mStartupReader;
+        StartupFiles mStartupFiles;
+        LoadPhase mLoadPhase = LoadPhase::Reading;
+        bool mDebugRendering = false;
+        int mWindowWidth;
+        int mWindowHeight;
+    };
+
+} // namespace zuul
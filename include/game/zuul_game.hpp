@@ -3,15 +3,12 @@
 #include <memory>
 #include <string>
 #include <engine/game.hpp>
-#include <game/tilemap.hpp>
-#include <game/player.hpp>
-#include <game/camera.hpp>
-#include <game/ui.hpp>
-#include <game/title_screen.hpp>
+#include <engine/scene.hpp>
 
 namespace zuul
 {
 
+    // Shows the title screen while the world loads behind it, then the world
     class ZuulGame : public Game
     {
     public:
@@ -19,19 +16,13 @@ namespace zuul
         ~ZuulGame() = default;
 
         bool initialize(int windowWidth, int windowHeight, const std::string &windowTitle) override;
+        void beginFrame() override;
         void update(float deltaTime) override;
         void render() override;
 
     private:
-        std::unique_ptr<TileMap> mTileMap;
-        std::unique_ptr<Player> mPlayer;
-        std::unique_ptr<Camera> mCamera;
-        std::unique_ptr<UI> mUI;
-        std::unique_ptr<TitleScreen> mTitleScreen;
-        bool mDebugRendering = false;
-        bool mGameStarted = false;
-        int mWindowWidth;
-        int mWindowHeight;
+        std::unique_ptr<SceneStack> mScenes;
+        bool mInteractive = false;
     };
 
-} // namespace zuul
\ No newline at end of file
+} // namespace zuul
@@ -0,0 +1,101 @@
+# Generates asset_manifest.hpp from assets/assets.json, run by meson at build time:
+#   python3 gen_asset_manifest.py <assets.json> <output header> <source root>
+# Fails if a listed asset doesn't exist, so a missing asset breaks the build.
+import json
+import os
+import posixpath
+import sys
+
+TYPES = {
+    ".tmj": "Map",
+    ".tsj": "Tileset",
+    ".world": "World",
+    ".png": "Image",
+    ".ttf": "Font",
+}
+
+
+# Same hash as hashAssetPath in include/engine/asset_id.hpp
+def hash_path(path):
+    value = 0xcbf29ce484222325
+    for byte in path.encode("utf-8"):
+        value ^= byte
+        value = (value * 0x100000001b3) & 0xFFFFFFFFFFFFFFFF
+    return value
+
+
+def main():
+    manifest_path, output_path, source_root = sys.argv[1:4]
+    with open(manifest_path) as file:
+        entries = json.load(file)["assets"]
+
+    assets = []
+    groups = {}
+    hashes = {}
+    for index, entry in enumerate(entries):
+        path = posixpath.normpath(posixpath.join(entry["path"], entry["name"]))
+        if not os.path.isfile(os.path.join(source_root, path)):
+            sys.exit(f"{manifest_path}: {path} does not exist")
+
+        value = hash_path(path)
+        if value in hashes:
+            sys.exit(f"{manifest_path}: {path} and {hashes[value]} have the same hash")
+        hashes[value] = path
+
+        name = entry["id"].upper()
+        asset_type = TYPES.get(posixpath.splitext(path)[1], "Data")
+        assets.append((name, value, index, asset_type, path))
+        if "group" in entry:
+            groups.setdefault(entry["group"].upper(), []).append(name)
+
+    lines = [
+        "#pragma once",
+        "",
+        "// Generated from assets/assets.json by scripts/gen_asset_manifest.py, do not edit",
+        "",
+        "#include <engine/asset_id.hpp>",
+        "#include <array>",
+        "#include <cstddef>",
+        "",
+        "namespace zuul::manifest",
+        "{",
+    ]
+    for name, value, index, asset_type, path in assets:
+        lines.append(f'    inline constexpr AssetId {name}{{0x{value:016x}ull, {index}, AssetType::{asset_type}, "{path}"}};')
+    lines.append("")
+
+    lines.append(f"    inline constexpr size_t COUNT = {len(assets)};")
+    lines.append("    inline constexpr std::array<AssetId, COUNT> ASSETS = {")
+    for name, *_ in assets:
+        lines.append(f"        {name},")
+    lines.append("    };")
+
+    for group, names in groups.items():
+        lines.append("")
+        lines.append(f"    inline constexpr std::array<AssetId, {len(names)}> {group} = {{{', '.join(names)}}};")
+
+    lines += [
+        "",
+        "    // The generator and the C++ hash must agree, or runtime paths would not find these",
+        "    static_assert([]",
+        "                  {",
+        "                      for (const AssetId &asset : ASSETS)",
+        "                      {",
+        "                          if (hashAssetPath(asset.path) != asset.hash)",
+        "                          {",
+        "                              return false;",
+        "                          }",
+        "                      }",
+        "                      return true;",
+        "                  }());",
+        "",
+        "} // namespace zuul::manifest",
+        "",
+    ]
+
+    with open(output_path, "w") as file:
+        file.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
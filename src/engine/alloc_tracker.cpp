@@ -0,0 +1,252 @@
+#include "engine/alloc_tracker.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#if defined(ZUUL_ALLOC_TRACKING) && __has_include(<execinfo.h>)
+#include <execinfo.h>
+#include <unistd.h>
+#define ZUUL_ALLOC_BACKTRACE
+#endif
+
+namespace zuul
+{
+    namespace
+    {
+        // Caches such as text textures and the frame arena fill up during the first frames
+        constexpr uint64_t WARMUP_FRAMES = 120;
+        constexpr int MAX_STACK_DEPTH = 32;
+
+        // Written by operator new on any thread, so everything here is plain atomics or
+        // thread_local PODs that need no constructor. Frames are counted from the thread
+        // totals of the thread that calls endFrame, so worker threads don't show up in them.
+        std::atomic<uint64_t> gThreshold{UINT64_MAX};
+        thread_local uint64_t tThreadCount = 0;
+        thread_local uint64_t tThreadBytes = 0;
+        thread_local bool tFrameThread = false;
+        thread_local uint64_t tFrameStartCount = 0;
+        thread_local uint64_t tFrameStartBytes = 0;
+
+#if defined(ZUUL_ALLOC_BACKTRACE)
+        std::atomic<bool> gStackCaptured{false};
+        void *gStack[MAX_STACK_DEPTH];
+        int gStackDepth = 0;
+        thread_local bool tInBacktrace = false;
+
+        void captureStack()
+        {
+            // backtrace() may allocate itself, which would end up back here
+            if (tInBacktrace || gStackCaptured.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            tInBacktrace = true;
+            gStackDepth = backtrace(gStack, MAX_STACK_DEPTH);
+            tInBacktrace = false;
+            gStackCaptured.store(true, std::memory_order_release);
+        }
+#endif
+
+        void recordAllocation(size_t size)
+        {
+            tThreadCount++;
+            tThreadBytes += size;
+#if defined(ZUUL_ALLOC_BACKTRACE)
+            if (tFrameThread && tThreadCount - tFrameStartCount == gThreshold.load(std::memory_order_relaxed) + 1)
+            {
+                captureStack();
+            }
+#endif
+        }
+    }
+
+    AllocTracker::AllocTracker()
+        : mFrames(0),
+          mFlaggedFrames(0),
+          mZoneCount(0)
+    {
+        if (!ENABLED)
+        {
+            return;
+        }
+
+        const char *threshold = std::getenv("ZUUL_ALLOC_THRESHOLD");
+        gThreshold.store(threshold ? std::strtoull(threshold, nullptr, 10) : 0, std::memory_order_relaxed);
+
+#if defined(ZUUL_ALLOC_BACKTRACE)
+        // The first backtrace() call loads the unwinder, get that out of the way now
+        void *stack[1];
+        tInBacktrace = true;
+        backtrace(stack, 1);
+        tInBacktrace = false;
+#endif
+    }
+
+    void AllocTracker::endFrame()
+    {
+        if (!ENABLED)
+        {
+            return;
+        }
+
+        // The first frame also holds the allocations made at startup, it is part of the warmup
+        tFrameThread = true;
+        mLastFrame.count = tThreadCount - tFrameStartCount;
+        mLastFrame.bytes = tThreadBytes - tFrameStartBytes;
+        tFrameStartCount = tThreadCount;
+        tFrameStartBytes = tThreadBytes;
+        mTotal.count += mLastFrame.count;
+        mTotal.bytes += mLastFrame.bytes;
+        mFrames++;
+
+        for (size_t i = 0; i < mZoneCount; ++i)
+        {
+            mZones[i].total.count += mZones[i].frame.count;
+            mZones[i].total.bytes += mZones[i].frame.bytes;
+        }
+
+        uint64_t threshold = gThreshold.load(std::memory_order_relaxed);
+        if (mFrames > WARMUP_FRAMES && mLastFrame.count > threshold)
+        {
+            mFlaggedFrames++;
+            if (mLastFrame.count > mPeakFrame.count)
+            {
+                mPeakFrame = mLastFrame;
+            }
+
+            std::cerr << "Frame " << mFrames << " made " << mLastFrame.count << " allocations ("
+                      << mLastFrame.bytes << " bytes), threshold is " << threshold << std::endl;
+            for (size_t i = 0; i < mZoneCount; ++i)
+            {
+                if (mZones[i].frame.count > 0)
+                {
+                    std::cerr << "  " << mZones[i].name << ": " << mZones[i].frame.count << " allocations ("
+                              << mZones[i].frame.bytes << " bytes)" << std::endl;
+                }
+            }
+#if defined(ZUUL_ALLOC_BACKTRACE)
+            if (gStackCaptured.load(std::memory_order_acquire))
+            {
+                std::cerr << "  Allocation " << threshold + 1 << " was made from:" << std::endl;
+                backtrace_symbols_fd(gStack, gStackDepth, STDERR_FILENO);
+            }
+#endif
+        }
+
+#if defined(ZUUL_ALLOC_BACKTRACE)
+        gStackCaptured.store(false, std::memory_order_release);
+#endif
+
+        // Zones that do not run in a frame report 0 for it
+        for (size_t i = 0; i < mZoneCount; ++i)
+        {
+            mZones[i].frame = {};
+        }
+    }
+
+    void AllocTracker::endZone(const char *name, const AllocStats &allocs)
+    {
+        for (size_t i = 0; i < mZoneCount; ++i)
+        {
+            if (mZones[i].name == name)
+            {
+                mZones[i].frame.count += allocs.count;
+                mZones[i].frame.bytes += allocs.bytes;
+                return;
+            }
+        }
+
+        if (mZoneCount < MAX_ZONES)
+        {
+            mZones[mZoneCount++] = {name, allocs, {}};
+        }
+    }
+
+    void AllocTracker::printSummary() const
+    {
+        if (!ENABLED || mFrames == 0)
+        {
+            return;
+        }
+
+        std::cout << "Allocations over " << mFrames << " frames: " << mTotal.count << " ("
+                  << mTotal.bytes << " bytes), " << static_cast<double>(mTotal.count) / mFrames << " per frame" << std::endl;
+        std::cout << "Frames over the threshold after warmup: " << mFlaggedFrames
+                  << ", worst " << mPeakFrame.count << " allocations (" << mPeakFrame.bytes << " bytes)" << std::endl;
+        for (size_t i = 0; i < mZoneCount; ++i)
+        {
+            std::cout << "  " << mZones[i].name << ": " << mZones[i].total.count << " allocations ("
+                      << mZones[i].total.bytes << " bytes)" << std::endl;
+        }
+    }
+
+    AllocTracker &getAllocTracker()
+    {
+        static AllocTracker tracker;
+        return tracker;
+    }
+
+    AllocStats getThreadAllocs()
+    {
+        return {tThreadCount, tThreadBytes};
+    }
+
+} // namespace zuul
+
+#if defined(ZUUL_ALLOC_TRACKING)
+
+// Replacements for the global allocation functions. Everything goes through malloc,
+// so all delete variants can simply free().
+namespace
+{
+    void *trackedAllocate(size_t size, size_t alignment = 0)
+    {
+        if (size == 0)
+        {
+            size = 1;
+        }
+        zuul::recordAllocation(size);
+        if (alignment > alignof(std::max_align_t))
+        {
+            // aligned_alloc wants the size to be a multiple of the alignment
+            return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+        }
+        return std::malloc(size);
+    }
+
+    void *trackedNew(size_t size, size_t alignment = 0)
+    {
+        void *ptr = trackedAllocate(size, alignment);
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}
+
+void *operator new(size_t size) { return trackedNew(size); }
+void *operator new[](size_t size) { return trackedNew(size); }
+void *operator new(size_t size, std::align_val_t alignment) { return trackedNew(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment) { return trackedNew(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return trackedAllocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return trackedAllocate(size); }
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return trackedAllocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return trackedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+#endif
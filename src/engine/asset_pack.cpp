@@ -0,0 +1,195 @@
+#include "engine/asset_pack.hpp"
+#include "engine/log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(ZUUL_HAVE_LZ4)
+#include <lz4.h>
+#endif
+
+namespace zuul
+{
+#if !defined(__unix__) && !defined(__APPLE__)
+    namespace
+    {
+        // Reads the whole file where memory mapping isn't available
+        bool readWholeFile(const std::string &filepath, std::vector<std::byte> &buffer)
+        {
+            std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+            {
+                return false;
+            }
+            buffer.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            return static_cast<bool>(file.read(reinterpret_cast<char *>(buffer.data()), buffer.size()));
+        }
+    }
+#endif
+
+    AssetPack::~AssetPack()
+    {
+        close();
+    }
+
+    bool AssetPack::open(const std::string &filepath)
+    {
+        close();
+
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                mData = static_cast<const std::byte *>(mapping);
+                mSize = static_cast<size_t>(info.st_size);
+                mMapped = true;
+            }
+        }
+        // The mapping stays valid after the file is closed
+        ::close(fd);
+        if (!mMapped)
+        {
+            return false;
+        }
+#else
+        if (!readWholeFile(filepath, mBuffer))
+        {
+            return false;
+        }
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+#endif
+
+        PackHeader header;
+        if (mSize < sizeof(header))
+        {
+            ZUUL_LOG_ERROR(Assets, "{} is not an asset pack", filepath);
+            close();
+            return false;
+        }
+        std::memcpy(&header, mData, sizeof(header));
+        if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION)
+        {
+            ZUUL_LOG_ERROR(Assets, "{} is not an asset pack of version {}", filepath, PACK_VERSION);
+            close();
+            return false;
+        }
+
+        const size_t entriesSize = static_cast<size_t>(header.entryCount) * sizeof(PackEntry);
+        if (sizeof(header) + entriesSize + header.namesSize > mSize)
+        {
+            ZUUL_LOG_ERROR(Assets, "The index of {} is truncated", filepath);
+            close();
+            return false;
+        }
+        mEntries = {reinterpret_cast<const PackEntry *>(mData + sizeof(header)), header.entryCount};
+        mNames = {reinterpret_cast<const char *>(mData + sizeof(header) + entriesSize), header.namesSize};
+
+        // Checked once here, so lookups can trust the index
+        for (size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const PackEntry &entry = mEntries[i];
+            bool valid = entry.offset <= mSize && entry.size <= mSize - entry.offset &&
+                         static_cast<uint64_t>(entry.nameOffset) + entry.nameLength <= mNames.size() &&
+                         (entry.type != PackEntryType::Image ||
+                          entry.rawSize == static_cast<uint64_t>(entry.width) * entry.height * sizeof(uint32_t));
+            if (!valid || (i > 0 && !(getName(mEntries[i - 1]) < getName(entry))))
+            {
+                ZUUL_LOG_ERROR(Assets, "{} has an invalid entry", filepath);
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void AssetPack::close()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mMapped)
+        {
+            munmap(const_cast<std::byte *>(mData), mSize);
+        }
+#endif
+        mData = nullptr;
+        mSize = 0;
+        mEntries = {};
+        mNames = {};
+        mMapped = false;
+        mBuffer.clear();
+    }
+
+    std::string_view AssetPack::getName(const PackEntry &entry) const
+    {
+        return mNames.substr(entry.nameOffset, entry.nameLength);
+    }
+
+    const PackEntry *AssetPack::find(std::string_view name) const
+    {
+        auto it = std::lower_bound(mEntries.begin(), mEntries.end(), name,
+                                   [this](const PackEntry &entry, std::string_view key)
+                                   { return getName(entry) < key; });
+        return it != mEntries.end() && getName(*it) == name ? &*it : nullptr;
+    }
+
+    std::span<const std::byte> AssetPack::getData(const PackEntry &entry) const
+    {
+        return {mData + entry.offset, static_cast<size_t>(entry.size)};
+    }
+
+    bool AssetPack::readImage(const PackEntry &entry, PackImage &image) const
+    {
+        if (entry.type != PackEntryType::Image)
+        {
+            return false;
+        }
+
+        image.width = static_cast<int>(entry.width);
+        image.height = static_cast<int>(entry.height);
+        std::span<const std::byte> data = getData(entry);
+
+        if (entry.compression == PackCompression::None)
+        {
+            if (entry.size != entry.rawSize || entry.offset % alignof(uint32_t) != 0)
+            {
+                return false;
+            }
+            image.storage.clear();
+            image.pixels = reinterpret_cast<const uint32_t *>(data.data());
+            return true;
+        }
+
+#if defined(ZUUL_HAVE_LZ4)
+        image.storage.resize(static_cast<size_t>(entry.width) * entry.height);
+        int result = LZ4_decompress_safe(reinterpret_cast<const char *>(data.data()),
+                                         reinterpret_cast<char *>(image.storage.data()),
+                                         static_cast<int>(data.size()), static_cast<int>(entry.rawSize));
+        if (result < 0 || static_cast<uint64_t>(result) != entry.rawSize)
+        {
+            return false;
+        }
+        image.pixels = image.storage.data();
+        return true;
+#else
+        ZUUL_LOG_ERROR(Assets, "The pack has LZ4 compressed images, but zuul was built without LZ4 support");
+        return false;
+#endif
+    }
+
+} // namespace zuul
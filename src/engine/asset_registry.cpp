@@ -0,0 +1,192 @@
+#include "engine/asset_registry.hpp"
+#include "engine/log.hpp"
+#include "asset_manifest.hpp"
+#include <utility>
+
+namespace zuul
+{
+    TextureAsset::~TextureAsset()
+    {
+        reset();
+    }
+
+    TextureAsset::TextureAsset(const TextureAsset &other)
+        : mRegistry(other.mRegistry),
+          mHandle(other.mHandle)
+    {
+        if (mRegistry)
+        {
+            mRegistry->addReference(mHandle);
+        }
+    }
+
+    TextureAsset::TextureAsset(TextureAsset &&other) noexcept
+        : mRegistry(std::exchange(other.mRegistry, nullptr)),
+          mHandle(std::exchange(other.mHandle, {}))
+    {
+    }
+
+    TextureAsset &TextureAsset::operator=(const TextureAsset &other)
+    {
+        if (this != &other)
+        {
+            // Reference first, so assigning a copy of the same texture cannot destroy it
+            if (other.mRegistry)
+            {
+                other.mRegistry->addReference(other.mHandle);
+            }
+            reset();
+            mRegistry = other.mRegistry;
+            mHandle = other.mHandle;
+        }
+        return *this;
+    }
+
+    TextureAsset &TextureAsset::operator=(TextureAsset &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            mRegistry = std::exchange(other.mRegistry, nullptr);
+            mHandle = std::exchange(other.mHandle, {});
+        }
+        return *this;
+    }
+
+    void TextureAsset::reset()
+    {
+        if (mRegistry)
+        {
+            mRegistry->release(mHandle);
+        }
+        mRegistry = nullptr;
+        mHandle = {};
+    }
+
+    AssetRegistry::AssetRegistry(Renderer &renderer)
+        : mRenderer(renderer),
+          mTextureCount(0)
+    {
+        // Every image of the manifest fits without rehashing
+        mPaths.reserve(manifest::COUNT);
+    }
+
+    AssetRegistry::~AssetRegistry()
+    {
+        if (mTextureCount > 0)
+        {
+            ZUUL_LOG_WARN(Assets, "{} textures are still referenced when the asset registry is destroyed", mTextureCount);
+        }
+    }
+
+    TextureAsset AssetRegistry::adopt(TextureHandle handle, uint64_t hash, std::string path)
+    {
+        if (!handle)
+        {
+            return {};
+        }
+
+        if (mEntries.size() <= handle.getIndex())
+        {
+            mEntries.resize(handle.getIndex() + 1);
+        }
+        Entry &entry = mEntries[handle.getIndex()];
+        entry.references = 1;
+        entry.hash = hash;
+        entry.path = std::move(path);
+        mTextureCount++;
+        return TextureAsset(this, handle);
+    }
+
+    TextureAsset AssetRegistry::loadTexture(AssetId asset)
+    {
+        return loadTexture(asset.hash, asset.path);
+    }
+
+    TextureAsset AssetRegistry::loadTexture(const std::string &path)
+    {
+        return loadTexture(hashAssetPath(path), path);
+    }
+
+    TextureAsset AssetRegistry::loadTexture(const std::string &path, int width, int height, const uint32_t *pixels)
+    {
+        return loadTexture(hashAssetPath(path), path, width, height, pixels);
+    }
+
+    TextureHandle AssetRegistry::createImageTexture(const std::string &path, int width, int height, const uint32_t *pixels)
+    {
+        return pixels ? mRenderer.createTexture(width, height, pixels) : mRenderer.loadTexture(path);
+    }
+
+    TextureAsset AssetRegistry::loadTexture(uint64_t hash, const std::string &path, int width, int height,
+                                            const uint32_t *pixels)
+    {
+        auto it = mPaths.find(hash);
+        if (it != mPaths.end())
+        {
+            // Two paths with the same hash are astronomically unlikely, but would share a texture
+            if (mEntries[it->second.getIndex()].path == path)
+            {
+                addReference(it->second);
+                return TextureAsset(this, it->second);
+            }
+            ZUUL_LOG_WARN(Assets, "{} has the same hash as {}, it is not shared", path, mEntries[it->second.getIndex()].path);
+            return adopt(createImageTexture(path, width, height, pixels), 0, {});
+        }
+
+        TextureAsset texture = adopt(createImageTexture(path, width, height, pixels), hash, path);
+        if (texture)
+        {
+            mPaths.emplace(hash, texture.get());
+        }
+        return texture;
+    }
+
+    TextureAsset AssetRegistry::createTexture(int width, int height, const uint32_t *pixels)
+    {
+        return adopt(mRenderer.createTexture(width, height, pixels), 0, {});
+    }
+
+    TextureAsset AssetRegistry::createRenderTarget(int width, int height, bool linearFilter)
+    {
+        return adopt(mRenderer.createRenderTarget(width, height, linearFilter), 0, {});
+    }
+
+    bool AssetRegistry::reloadTexture(const std::string &path, int width, int height, const uint32_t *pixels)
+    {
+        auto it = mPaths.find(hashAssetPath(path));
+        if (it == mPaths.end() || mEntries[it->second.getIndex()].path != path)
+        {
+            return true;
+        }
+        if (!mRenderer.reloadTexture(it->second, width, height, pixels))
+        {
+            ZUUL_LOG_ERROR(Assets, "Failed to reload texture: {}", path);
+            return false;
+        }
+        return true;
+    }
+
+    void AssetRegistry::addReference(TextureHandle handle)
+    {
+        mEntries[handle.getIndex()].references++;
+    }
+
+    void AssetRegistry::release(TextureHandle handle)
+    {
+        Entry &entry = mEntries[handle.getIndex()];
+        if (--entry.references > 0)
+        {
+            return;
+        }
+
+        if (!entry.path.empty())
+        {
+            mPaths.erase(entry.hash);
+            entry.path.clear();
+        }
+        mRenderer.destroyTexture(handle);
+        mTextureCount--;
+    }
+
+} // namespace zuul
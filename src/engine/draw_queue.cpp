@@ -0,0 +1,158 @@
+#include "engine/draw_queue.hpp"
+#include "engine/alloc_tracker.hpp"
+#include <cstring>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int RADIX_BITS = 8;
+        constexpr int RADIX_BUCKETS = 1 << RADIX_BITS;
+        constexpr int RADIX_PASSES = 64 / RADIX_BITS;
+        constexpr uint32_t TEXTURE_SLOT_MASK = 0xFFFFFF;
+    }
+
+    DrawQueue::DrawQueue()
+        : mLastTextureSlot(0)
+    {
+    }
+
+    uint64_t DrawQueue::makeKey(uint8_t layer, int32_t depth, uint32_t textureSlot)
+    {
+        // Flip the sign bit so negative depths sort before positive ones
+        uint32_t biasedDepth = static_cast<uint32_t>(depth) ^ 0x80000000u;
+
+        return (static_cast<uint64_t>(layer) << 56) |
+               (static_cast<uint64_t>(biasedDepth) << 24) |
+               (textureSlot & TEXTURE_SLOT_MASK);
+    }
+
+    void DrawQueue::reserve(size_t count)
+    {
+        mQuads.reserve(count);
+        mEntries.reserve(count);
+        mScratch.reserve(count);
+    }
+
+    void DrawQueue::clear()
+    {
+        // clear() keeps the capacity, so steady-state frames reuse the same storage
+        mQuads.clear();
+        mEntries.clear();
+        mTextures.clear();
+        mLastTextureSlot = 0;
+    }
+
+    uint32_t DrawQueue::getTextureSlot(TextureHandle texture)
+    {
+        // Consecutive pushes nearly always use the same texture
+        if (mLastTextureSlot < mTextures.size() && mTextures[mLastTextureSlot] == texture)
+        {
+            return mLastTextureSlot;
+        }
+
+        for (uint32_t slot = 0; slot < mTextures.size(); ++slot)
+        {
+            if (mTextures[slot] == texture)
+            {
+                mLastTextureSlot = slot;
+                return slot;
+            }
+        }
+
+        mTextures.push_back(texture);
+        mLastTextureSlot = static_cast<uint32_t>(mTextures.size() - 1);
+        return mLastTextureSlot;
+    }
+
+    void DrawQueue::push(uint8_t layer, int32_t depth, TextureHandle texture,
+                         int srcX, int srcY, int srcW, int srcH,
+                         int destX, int destY, int destW, int destH)
+    {
+        if (!texture)
+        {
+            return;
+        }
+
+        uint32_t slot = getTextureSlot(texture);
+        uint32_t index = static_cast<uint32_t>(mQuads.size());
+
+        mQuads.push_back({slot, srcX, srcY, srcW, srcH, destX, destY, destW, destH});
+        mEntries.push_back({makeKey(layer, depth, slot), index});
+    }
+
+    void DrawQueue::sort()
+    {
+        const size_t count = mEntries.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        if (mScratch.size() < count)
+        {
+            mScratch.resize(count);
+        }
+
+        // Build the histograms for all digits in a single pass
+        uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS];
+        std::memset(histograms, 0, sizeof(histograms));
+        for (const auto &entry : mEntries)
+        {
+            for (int pass = 0; pass < RADIX_PASSES; ++pass)
+            {
+                histograms[pass][(entry.key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+            }
+        }
+
+        SortEntry *src = mEntries.data();
+        SortEntry *dst = mScratch.data();
+
+        for (int pass = 0; pass < RADIX_PASSES; ++pass)
+        {
+            uint32_t *histogram = histograms[pass];
+            const int shift = pass * RADIX_BITS;
+
+            // Skip digits that are identical for every entry, e.g. unused layers
+            if (histogram[(src[0].key >> shift) & (RADIX_BUCKETS - 1)] == count)
+            {
+                continue;
+            }
+
+            // Turn counts into starting offsets
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+            {
+                uint32_t bucketCount = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketCount;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                dst[histogram[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+            }
+
+            std::swap(src, dst);
+        }
+
+        // An odd number of scatter passes leaves the result in the scratch buffer
+        if (src != mEntries.data())
+        {
+            std::memcpy(mEntries.data(), src, count * sizeof(SortEntry));
+        }
+    }
+
+    void DrawQueue::submit(Renderer &renderer) const
+    {
+        ZUUL_ALLOC_ZONE("DrawQueue::submit");
+        for (const auto &entry : mEntries)
+        {
+            const DrawQuad &quad = mQuads[entry.index];
+            renderer.renderTexture(mTextures[quad.textureSlot],
+                                   quad.srcX, quad.srcY, quad.srcW, quad.srcH,
+                                   quad.destX, quad.destY, quad.destW, quad.destH);
+        }
+    }
+
+} // namespace zuul
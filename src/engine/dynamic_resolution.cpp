@@ -0,0 +1,54 @@
+#include "engine/dynamic_resolution.hpp"
+#include <algorithm>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr float SMOOTHING = 0.1f;         // Weight of the newest frame in the moving average
+        constexpr float DOWNSCALE_RATIO = 1.1f;   // Lower the scale above 110% of the budget
+        constexpr float UPSCALE_RATIO = 0.6f;     // Raise it again below 60% of the budget
+        constexpr int DOWNSCALE_COOLDOWN = 15;    // Frames to wait between changes
+        constexpr int UPSCALE_COOLDOWN = 120;
+    }
+
+    DynamicResolution::DynamicResolution(float frameBudget, int minScale, int maxScale)
+        : mFrameBudget(frameBudget),
+          mAverageFrameTime(frameBudget * 0.5f),
+          mScale(maxScale),
+          mMinScale(minScale),
+          mMaxScale(maxScale),
+          mFramesSinceChange(0)
+    {
+    }
+
+    void DynamicResolution::setScaleRange(int minScale, int maxScale)
+    {
+        // A scale that is not being throttled follows the top of the range
+        bool atMaximum = mScale >= mMaxScale;
+
+        mMinScale = std::max(1, minScale);
+        mMaxScale = std::max(mMinScale, maxScale);
+        mScale = atMaximum ? mMaxScale : std::clamp(mScale, mMinScale, mMaxScale);
+    }
+
+    void DynamicResolution::update(float frameTime)
+    {
+        mAverageFrameTime += (frameTime - mAverageFrameTime) * SMOOTHING;
+        mFramesSinceChange++;
+
+        if (mAverageFrameTime > mFrameBudget * DOWNSCALE_RATIO &&
+            mFramesSinceChange >= DOWNSCALE_COOLDOWN && mScale > mMinScale)
+        {
+            mScale--;
+            mFramesSinceChange = 0;
+        }
+        else if (mAverageFrameTime < mFrameBudget * UPSCALE_RATIO &&
+                 mFramesSinceChange >= UPSCALE_COOLDOWN && mScale < mMaxScale)
+        {
+            mScale++;
+            mFramesSinceChange = 0;
+        }
+    }
+
+} // namespace zuul
@@ -0,0 +1,94 @@
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include <SDL2/SDL.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace zuul
+{
+    bool FileSystem::mount(const std::string &packPath)
+    {
+        if (!mPack.open(packPath))
+        {
+            return false;
+        }
+        ZUUL_LOG_INFO(Assets, "Mounted {} with {} files", packPath, mPack.getEntryCount());
+        return true;
+    }
+
+    const PackEntry *FileSystem::findEntry(const std::string &path) const
+    {
+        if (!mPack.isOpen())
+        {
+            return nullptr;
+        }
+
+        // The pack is indexed by the same normal form the loaders build their paths in
+        std::string name = std::filesystem::path(path).lexically_normal().generic_string();
+        {
+            std::lock_guard<std::mutex> lock(mDiskCopiesMutex);
+            if (mDiskCopies.contains(name))
+            {
+                return nullptr;
+            }
+        }
+        return mPack.find(name);
+    }
+
+    bool FileSystem::exists(const std::string &path) const
+    {
+        std::error_code error;
+        return findEntry(path) || std::filesystem::exists(path, error);
+    }
+
+    bool FileSystem::readFile(const std::string &path, std::string &contents) const
+    {
+        if (const PackEntry *entry = findEntry(path); entry && entry->type == PackEntryType::File)
+        {
+            std::span<const std::byte> data = mPack.getData(*entry);
+            contents.assign(reinterpret_cast<const char *>(data.data()), data.size());
+            return true;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        contents = std::move(stream).str();
+        return true;
+    }
+
+    SDL_RWops *FileSystem::openFile(const std::string &path) const
+    {
+        if (const PackEntry *entry = findEntry(path); entry && entry->type == PackEntryType::File)
+        {
+            std::span<const std::byte> data = mPack.getData(*entry);
+            return SDL_RWFromConstMem(data.data(), static_cast<int>(data.size()));
+        }
+        return SDL_RWFromFile(path.c_str(), "rb");
+    }
+
+    bool FileSystem::readImage(const std::string &path, PackImage &image) const
+    {
+        const PackEntry *entry = findEntry(path);
+        return entry && mPack.readImage(*entry, image);
+    }
+
+    void FileSystem::useDiskCopy(const std::string &path)
+    {
+        std::string name = std::filesystem::path(path).lexically_normal().generic_string();
+        std::lock_guard<std::mutex> lock(mDiskCopiesMutex);
+        mDiskCopies.insert(std::move(name));
+    }
+
+    FileSystem &getFileSystem()
+    {
+        static FileSystem fileSystem;
+        return fileSystem;
+    }
+
+} // namespace zuul
@@ -0,0 +1,164 @@
+#include "engine/file_watcher.hpp"
+#include "engine/log.hpp"
+#include <cerrno>
+#include <filesystem>
+#include <set>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int QUIET_PERIOD_MS = 100; // Report once the directory was quiet this long
+        constexpr int STOP_CHECK_MS = 250;   // Longest wait before the stop flag is seen without a wake
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        stop();
+    }
+
+#if defined(__linux__)
+    bool FileWatcher::start(const std::vector<std::string> &directories, Callback callback)
+    {
+        stop();
+
+        mNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (mNotifyFd < 0 || pipe(mWakeFds) != 0)
+        {
+            ZUUL_LOG_ERROR(Engine, "Failed to create file watcher");
+            stop();
+            return false;
+        }
+
+        // inotify is not recursive, so every subdirectory gets its own watch
+        auto addWatch = [this](const std::filesystem::path &directory)
+        {
+            int wd = inotify_add_watch(mNotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0)
+            {
+                ZUUL_LOG_ERROR(Engine, "Failed to watch {}", directory.string());
+                return;
+            }
+            if (mWatchedDirectories.size() <= static_cast<size_t>(wd))
+            {
+                mWatchedDirectories.resize(wd + 1);
+            }
+            mWatchedDirectories[wd] = directory.lexically_normal().string();
+        };
+
+        std::error_code error;
+        for (const auto &directory : directories)
+        {
+            addWatch(directory);
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(directory, error))
+            {
+                if (entry.is_directory())
+                {
+                    addWatch(entry.path());
+                }
+            }
+        }
+
+        mCallback = std::move(callback);
+        mStopping = false;
+        mThread = std::thread(&FileWatcher::run, this);
+        return true;
+    }
+
+    void FileWatcher::stop()
+    {
+        if (mThread.joinable())
+        {
+            // The wake only makes the thread notice sooner; if it can't be written, the
+            // thread still sees the flag within STOP_CHECK_MS. It must be joined before
+            // the descriptors it polls are closed.
+            mStopping = true;
+            char wake = 0;
+            while (write(mWakeFds[1], &wake, 1) < 0 && errno == EINTR)
+            {
+            }
+            mThread.join();
+        }
+
+        for (int *fd : {&mNotifyFd, &mWakeFds[0], &mWakeFds[1]})
+        {
+            if (*fd >= 0)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+        mWatchedDirectories.clear();
+    }
+
+    void FileWatcher::run()
+    {
+        alignas(inotify_event) char buffer[4096];
+        std::set<std::string> pending;
+
+        while (!mStopping)
+        {
+            pollfd fds[2] = {{mNotifyFd, POLLIN, 0}, {mWakeFds[0], POLLIN, 0}};
+            int ready = poll(fds, 2, pending.empty() ? STOP_CHECK_MS : QUIET_PERIOD_MS);
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (ready < 0 || (fds[1].revents & POLLIN) || mStopping)
+            {
+                return;
+            }
+
+            // Timed out with changes collected: the burst of writes is over
+            if (ready == 0)
+            {
+                if (pending.empty())
+                {
+                    continue;
+                }
+                mCallback(std::vector<std::string>(pending.begin(), pending.end()));
+                pending.clear();
+                continue;
+            }
+
+            ssize_t length;
+            while ((length = read(mNotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *pos = buffer; pos < buffer + length;)
+                {
+                    const auto *event = reinterpret_cast<const inotify_event *>(pos);
+                    pos += sizeof(inotify_event) + event->len;
+
+                    if (event->len == 0 || (event->mask & IN_ISDIR) ||
+                        static_cast<size_t>(event->wd) >= mWatchedDirectories.size())
+                    {
+                        continue;
+                    }
+                    pending.insert((std::filesystem::path(mWatchedDirectories[event->wd]) / event->name).lexically_normal().string());
+                }
+            }
+        }
+    }
+#else
+    bool FileWatcher::start(const std::vector<std::string> &, Callback)
+    {
+        ZUUL_LOG_WARN(Engine, "File watching is not supported on this platform");
+        return false;
+    }
+
+    void FileWatcher::stop()
+    {
+    }
+
+    void FileWatcher::run()
+    {
+    }
+#endif
+
+} // namespace zuul
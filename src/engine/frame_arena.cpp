@@ -0,0 +1,54 @@
+#include "engine/frame_arena.hpp"
+#include <bit>
+#include <cstdint>
+
+namespace zuul
+{
+
+    FrameArena::FrameArena(size_t capacity)
+        : mBuffer(std::make_unique<std::byte[]>(capacity)),
+          mCapacity(capacity),
+          mUsed(0),
+          mOverflowBytes(0)
+    {
+    }
+
+    void *FrameArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        uintptr_t base = reinterpret_cast<uintptr_t>(mBuffer.get());
+        uintptr_t aligned = (base + mUsed + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        if (aligned + bytes <= base + mCapacity)
+        {
+            mUsed = aligned + bytes - base;
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        // Out of space: serve this frame from the heap and remember how much was missing
+        auto block = std::make_unique<std::byte[]>(bytes + alignment);
+        uintptr_t blockAligned = (reinterpret_cast<uintptr_t>(block.get()) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        mOverflowBytes += bytes + alignment;
+        mOverflow.push_back(std::move(block));
+        return reinterpret_cast<void *>(blockAligned);
+    }
+
+    void FrameArena::reset()
+    {
+        if (!mOverflow.empty())
+        {
+            // Grow so the next frame of this size fits in the buffer
+            mCapacity = std::bit_ceil(mUsed + mOverflowBytes);
+            mBuffer = std::make_unique<std::byte[]>(mCapacity);
+            mOverflow.clear();
+            mOverflow.shrink_to_fit();
+        }
+        mUsed = 0;
+        mOverflowBytes = 0;
+    }
+
+    FrameArena &getFrameArena()
+    {
+        static FrameArena arena;
+        return arena;
+    }
+
+} // namespace zuul
@@ -1,22 +1,52 @@
 #include "engine/game.hpp"
+#include "engine/alloc_tracker.hpp"
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include "engine/frame_arena.hpp"
 #include "engine/sdl_renderer.hpp"
+#include "engine/software_renderer.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_timer.h>
 #include <memory>
-#include <iostream>
+#include <cstdlib>
+#include <cstring>
 
 namespace zuul
 {
 
-    Game::Game() : mIsRunning(false) {}
+    Game::Game() : mIsRunning(false), mFrameWorkTime(0.0f), mStartCounter(SDL_GetPerformanceCounter()) {}
+
+    float Game::getMillisecondsSinceStart() const
+    {
+        return static_cast<float>(SDL_GetPerformanceCounter() - mStartCounter) * 1000.0f / SDL_GetPerformanceFrequency();
+    }
 
     bool Game::initialize(int windowWidth, int windowHeight, const ::std::string &windowTitle)
     {
-        mRenderer = ::std::make_shared<SDLRenderer>();
+        // Files in a pack built by zuul_pack are read from it instead of the assets directory.
+        // ZUUL_PACK names the pack, by default assets.pack is used if there is one.
+        const char *pack = ::std::getenv("ZUUL_PACK");
+        if (!getFileSystem().mount(pack ? pack : "assets.pack") && pack)
+        {
+            ZUUL_LOG_ERROR(Engine, "Failed to mount asset pack: {}", pack);
+            return false;
+        }
+
+        // ZUUL_RENDERER=software selects the CPU rasterizer, e.g. for headless CI
+        const char *backend = ::std::getenv("ZUUL_RENDERER");
+        if (backend && ::std::strcmp(backend, "software") == 0)
+        {
+            mRenderer = ::std::make_unique<SoftwareRenderer>();
+        }
+        else
+        {
+            mRenderer = ::std::make_unique<SDLRenderer>();
+        }
         if (!mRenderer->initialize(windowWidth, windowHeight, windowTitle))
         {
             return false;
         }
+        mAssets = ::std::make_unique<AssetRegistry>(*mRenderer);
 
         mIsRunning = true;
         return true;
@@ -26,9 +56,11 @@ namespace zuul
     {
         uint32_t previousTime = SDL_GetTicks();
         float lag = 0.0f;
+        bool firstFrame = true;
 
         while (mIsRunning)
         {
+            uint64_t frameStart = SDL_GetPerformanceCounter();
             uint32_t currentTime = SDL_GetTicks();
             float deltaTime = (currentTime - previousTime) / 1000.0f;
             previousTime = currentTime;
@@ -43,18 +75,41 @@ namespace zuul
                 }
             }
 
+            beginFrame();
+
             // Update game logic at fixed time step
-            while (lag >= FRAME_TIME)
             {
-                update(FRAME_TIME);
-                lag -= FRAME_TIME;
+                ZUUL_ALLOC_ZONE("update");
+                while (lag >= FRAME_TIME)
+                {
+                    update(FRAME_TIME);
+                    lag -= FRAME_TIME;
+                }
             }
 
             // Render at whatever rate we can
-            mRenderer->clear();
-            render();
-            mRenderer->present();
+            {
+                ZUUL_ALLOC_ZONE("render");
+                mRenderer->clear();
+                render();
+            }
+            mFrameWorkTime = static_cast<float>(SDL_GetPerformanceCounter() - frameStart) / SDL_GetPerformanceFrequency();
+            {
+                ZUUL_ALLOC_ZONE("present");
+                mRenderer->present();
+            }
+            if (firstFrame)
+            {
+                ZUUL_LOG_INFO(Engine, "Time to first frame: {:.1f} ms", getMillisecondsSinceStart());
+                firstFrame = false;
+            }
+
+            // Everything allocated from the frame arena is gone after this
+            getFrameArena().reset();
+            getAllocTracker().endFrame();
         }
+
+        getAllocTracker().printSummary();
     }
 
     void Game::stop()
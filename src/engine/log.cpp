@@ -0,0 +1,81 @@
+#include "engine/log.hpp"
+#include <spdlog/async.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <array>
+#include <cstdlib>
+#include <memory>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr size_t QUEUE_SIZE = 8192;
+        constexpr size_t CHANNEL_COUNT = static_cast<size_t>(LogChannel::Count);
+        constexpr const char *CHANNEL_NAMES[CHANNEL_COUNT] = {"engine", "render", "assets", "map", "game"};
+
+        struct Logging
+        {
+            // Declared first, so it is destroyed last: its destructor drains the queue
+            std::shared_ptr<spdlog::details::thread_pool> threadPool;
+            std::array<std::shared_ptr<spdlog::logger>, CHANNEL_COUNT> loggers;
+
+            Logging()
+                : threadPool(std::make_shared<spdlog::details::thread_pool>(QUEUE_SIZE, 1))
+            {
+                auto sink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+                sink->set_pattern("[%H:%M:%S.%e] [%n] [%^%l%$] %v");
+
+                spdlog::level::level_enum level = spdlog::level::info;
+                if (const char *name = std::getenv("ZUUL_LOG_LEVEL"))
+                {
+                    level = spdlog::level::from_str(name);
+                }
+
+                for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+                {
+                    loggers[i] = std::make_shared<spdlog::async_logger>(CHANNEL_NAMES[i], sink, threadPool,
+                                                                        spdlog::async_overflow_policy::overrun_oldest);
+                    loggers[i]->set_level(level);
+                    loggers[i]->flush_on(spdlog::level::warn);
+                }
+            }
+
+            ~Logging()
+            {
+                for (auto &logger : loggers)
+                {
+                    logger->flush();
+                }
+            }
+        };
+
+        Logging &getLogging()
+        {
+            static Logging logging;
+            return logging;
+        }
+    }
+
+    spdlog::logger &getLogger(LogChannel channel)
+    {
+        return *getLogging().loggers[static_cast<size_t>(channel)];
+    }
+
+    void setLogLevel(spdlog::level::level_enum level)
+    {
+        for (auto &logger : getLogging().loggers)
+        {
+            logger->set_level(level);
+        }
+    }
+
+    void flushLogs()
+    {
+        for (auto &logger : getLogging().loggers)
+        {
+            logger->flush();
+        }
+    }
+
+} // namespace zuul
@@ -1,4 +1,8 @@
 #include "engine/renderer.hpp"
+#include "engine/log.hpp"
+#include "engine/file_system.hpp"
+#include "engine/frame_arena.hpp"
+#include <string>
 
 namespace zuul
 {
@@ -12,4 +16,179 @@ namespace zuul
     {
     }
 
+    namespace
+    {
+        constexpr uint64_t TEXT_TEXTURE_FRAMES = 120;
+        constexpr uint32_t GENERATION_MASK = (1u << (32 - TextureHandle::INDEX_BITS)) - 1;
+    }
+
+    TextureHandle Renderer::addTexture(std::unique_ptr<Texture> texture)
+    {
+        if (!texture)
+        {
+            return {};
+        }
+
+        uint32_t index;
+        if (!mFreeSlots.empty())
+        {
+            index = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            if (mTextures.size() > TextureHandle::INDEX_MASK)
+            {
+                ZUUL_LOG_ERROR(Render, "Too many textures, the limit is {}", TextureHandle::INDEX_MASK + 1);
+                return {};
+            }
+            index = static_cast<uint32_t>(mTextures.size());
+            mTextures.emplace_back();
+        }
+
+        TextureSlot &slot = mTextures[index];
+        slot.texture = std::move(texture);
+        return {(slot.generation << TextureHandle::INDEX_BITS) | index};
+    }
+
+    std::unique_ptr<Texture> Renderer::loadImage(const std::string &path)
+    {
+        // Images in the pack are stored decoded and go straight to the texture
+        PackImage image;
+        if (getFileSystem().readImage(path, image))
+        {
+            return createPixelTexture(image.width, image.height, image.pixels);
+        }
+        return loadTextureFile(path);
+    }
+
+    TextureHandle Renderer::loadTexture(const std::string &path)
+    {
+        return addTexture(loadImage(path));
+    }
+
+    TextureHandle Renderer::createTexture(int width, int height, const uint32_t *pixels)
+    {
+        return addTexture(createPixelTexture(width, height, pixels));
+    }
+
+    TextureHandle Renderer::createRenderTarget(int width, int height, bool linearFilter)
+    {
+        return addTexture(createTargetTexture(width, height, linearFilter));
+    }
+
+    bool Renderer::reloadTexture(TextureHandle texture, int width, int height, const uint32_t *pixels)
+    {
+        if (!getTexture(texture))
+        {
+            return false;
+        }
+
+        std::unique_ptr<Texture> replacement = createPixelTexture(width, height, pixels);
+        if (!replacement)
+        {
+            return false;
+        }
+
+        // The old image may still be referenced by draws of this frame
+        TextureSlot &slot = mTextures[texture.getIndex()];
+        mRetiredTextures.push_back(std::move(slot.texture));
+        slot.texture = std::move(replacement);
+        return true;
+    }
+
+    void Renderer::destroyTexture(TextureHandle texture)
+    {
+        if (!getTexture(texture))
+        {
+            return;
+        }
+
+        TextureSlot &slot = mTextures[texture.getIndex()];
+        mRetiredTextures.push_back(std::move(slot.texture));
+
+        // Generation 0 would make the handle of slot 0 look like the default handle
+        slot.generation = (slot.generation + 1) & GENERATION_MASK;
+        if (slot.generation == 0)
+        {
+            slot.generation = 1;
+        }
+        mFreeSlots.push_back(texture.getIndex());
+    }
+
+    bool Renderer::getTextureSize(TextureHandle texture, int &width, int &height) const
+    {
+        const Texture *data = getTexture(texture);
+        if (!data)
+        {
+            return false;
+        }
+        width = data->getWidth();
+        height = data->getHeight();
+        return true;
+    }
+
+    void Renderer::renderText(std::string_view text, int x, int y, const Color &color)
+    {
+        if (!mFont || text.empty())
+        {
+            return;
+        }
+
+        // The key also serves as the 0 terminated string for SDL_ttf
+        std::pmr::string key(text, &getFrameArena());
+        key.push_back('\0');
+        key.append({static_cast<char>(color.r), static_cast<char>(color.g), static_cast<char>(color.b), static_cast<char>(color.a)});
+
+        auto it = mTextTextures.find(std::string_view(key));
+        if (it == mTextTextures.end())
+        {
+            SDL_Color sdlColor = {color.r, color.g, color.b, color.a};
+            SDL_Surface *surface = TTF_RenderText_Blended(mFont, key.c_str(), sdlColor);
+            if (!surface)
+            {
+                ZUUL_LOG_ERROR(Render, "Unable to render text surface! SDL_ttf Error: {}", TTF_GetError());
+                return;
+            }
+
+            int width = surface->w;
+            int height = surface->h;
+            TextureHandle texture = addTexture(createTextTexture(surface));
+            SDL_FreeSurface(surface);
+            if (!texture)
+            {
+                return;
+            }
+            it = mTextTextures.emplace(std::string(key), TextTexture{texture, width, height, 0}).first;
+        }
+
+        TextTexture &cached = it->second;
+        cached.lastFrame = mTextFrame;
+        renderTexture(cached.texture, 0, 0, cached.width, cached.height, x, y, cached.width, cached.height);
+    }
+
+    void Renderer::endFrame()
+    {
+        mTextFrame++;
+        std::erase_if(mTextTextures, [this](const auto &entry)
+                      {
+            if (mTextFrame - entry.second.lastFrame <= TEXT_TEXTURE_FRAMES)
+            {
+                return false;
+            }
+            destroyTexture(entry.second.texture);
+            return true; });
+
+        // clear() keeps the capacity, so destroying textures does not allocate in steady state
+        mRetiredTextures.clear();
+    }
+
+    void Renderer::destroyAllTextures()
+    {
+        mTextTextures.clear();
+        mRetiredTextures.clear();
+        mTextures.clear();
+        mFreeSlots.clear();
+    }
+
 } // namespace zuul
\ No newline at end of file
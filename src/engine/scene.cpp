@@ -0,0 +1,128 @@
+#include "engine/scene.hpp"
+#include "engine/log.hpp"
+
+namespace zuul
+{
+    SceneStack::SceneStack(AssetRegistry &assets)
+        : mAssets(assets)
+    {
+    }
+
+    void SceneStack::push(std::unique_ptr<Scene> scene)
+    {
+        setNext(std::move(scene), false);
+    }
+
+    void SceneStack::replace(std::unique_ptr<Scene> scene)
+    {
+        setNext(std::move(scene), true);
+    }
+
+    void SceneStack::setNext(std::unique_ptr<Scene> scene, bool replace)
+    {
+        // Only one scene loads at a time; a scene that was still waiting is dropped
+        mNext = {std::move(scene), {}};
+        mNextPrefetched = 0;
+        mNextLoaded = false;
+        mNextReplaces = replace;
+    }
+
+    void SceneStack::pop()
+    {
+        if (!mScenes.empty())
+        {
+            mScenes.pop_back();
+        }
+    }
+
+    SceneLoad SceneStack::loadNext()
+    {
+        // One image per step, so a long list doesn't stall the frame it is loaded in
+        std::span<const AssetId> assets = mNext.scene->getAssets();
+        while (mNextPrefetched < assets.size())
+        {
+            AssetId asset = assets[mNextPrefetched++];
+            if (asset.type != AssetType::Image)
+            {
+                continue;
+            }
+
+            TextureAsset texture = mAssets.loadTexture(asset);
+            if (!texture)
+            {
+                return SceneLoad::Failed;
+            }
+            mNext.textures.push_back(std::move(texture));
+            return SceneLoad::Loading;
+        }
+
+        return mNext.scene->load(mAssets);
+    }
+
+    void SceneStack::switchScenes()
+    {
+        bool topFinished = !mScenes.empty() && mScenes.back().scene->isFinished();
+        if (mNext.scene && mNextLoaded && (!mNextReplaces || mScenes.empty() || topFinished))
+        {
+            if (mNextReplaces)
+            {
+                pop();
+            }
+            mScenes.push_back(std::move(mNext));
+            mNext = {};
+            mNextLoaded = false;
+        }
+        else if (!mNext.scene && topFinished)
+        {
+            pop();
+        }
+    }
+
+    bool SceneStack::beginFrame()
+    {
+        if (mNext.scene && !mNextLoaded)
+        {
+            SceneLoad state = loadNext();
+            if (state == SceneLoad::Failed)
+            {
+                ZUUL_LOG_ERROR(Engine, "Failed to load the next scene");
+                mNext = {};
+                return false;
+            }
+            mNextLoaded = state == SceneLoad::Ready;
+        }
+
+        switchScenes();
+        return true;
+    }
+
+    bool SceneStack::finishLoading()
+    {
+        while (isLoading())
+        {
+            if (!beginFrame())
+            {
+                return false;
+            }
+        }
+        switchScenes();
+        return true;
+    }
+
+    void SceneStack::update(float deltaTime)
+    {
+        if (!mScenes.empty())
+        {
+            mScenes.back().scene->update(deltaTime);
+        }
+    }
+
+    void SceneStack::render(Renderer &renderer)
+    {
+        if (!mScenes.empty())
+        {
+            mScenes.back().scene->render(renderer);
+        }
+    }
+
+} // namespace zuul
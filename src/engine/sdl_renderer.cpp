@@ -1,6 +1,8 @@
 #include "engine/sdl_renderer.hpp"
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include "asset_manifest.hpp"
 #include <SDL2/SDL_image.h>
-#include <iostream>
 
 namespace zuul
 {
@@ -47,7 +49,7 @@ namespace zuul
         // Initialize SDL
         if (SDL_Init(SDL_INIT_VIDEO) < 0)
         {
-            std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "SDL could not initialize! SDL_Error: {}", SDL_GetError());
             return false;
         }
 
@@ -55,14 +57,14 @@ namespace zuul
         int imgFlags = IMG_INIT_PNG;
         if (!(IMG_Init(imgFlags) & imgFlags))
         {
-            std::cerr << "SDL_image could not initialize! SDL_image Error: " << IMG_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "SDL_image could not initialize! SDL_image Error: {}", IMG_GetError());
             return false;
         }
 
         // Initialize SDL_ttf
         if (TTF_Init() == -1)
         {
-            std::cerr << "SDL_ttf could not initialize! SDL_ttf Error: " << TTF_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "SDL_ttf could not initialize! SDL_ttf Error: {}", TTF_GetError());
             return false;
         }
 
@@ -71,23 +73,23 @@ namespace zuul
                                    windowWidth, windowHeight, SDL_WINDOW_SHOWN);
         if (!mWindow)
         {
-            std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "Window could not be created! SDL_Error: {}", SDL_GetError());
             return false;
         }
 
         // Create renderer
-        mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
         if (!mRenderer)
         {
-            std::cerr << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "Renderer could not be created! SDL_Error: {}", SDL_GetError());
             return false;
         }
 
         // Load font
-        mFont = TTF_OpenFont("assets/fonts/OpenSans-Regular.ttf", 16);
+        mFont = TTF_OpenFontRW(getFileSystem().openFile(manifest::FONT.path), 1, 16);
         if (!mFont)
         {
-            std::cerr << "Failed to load font! SDL_ttf Error: " << TTF_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "Failed to load font! SDL_ttf Error: {}", TTF_GetError());
             return false;
         }
 
@@ -96,6 +98,9 @@ namespace zuul
 
     void SDLRenderer::cleanup()
     {
+        mRenderTarget = {};
+        destroyAllTextures();
+
         if (mFont)
         {
             TTF_CloseFont(mFont);
@@ -119,23 +124,24 @@ namespace zuul
         SDL_Quit();
     }
 
-    void SDLRenderer::clear()
+    void SDLRenderer::clear(const Color &color)
     {
-        SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 255);
+        SDL_SetRenderDrawColor(mRenderer, color.r, color.g, color.b, color.a);
         SDL_RenderClear(mRenderer);
     }
 
     void SDLRenderer::present()
     {
         SDL_RenderPresent(mRenderer);
+        endFrame();
     }
 
-    std::shared_ptr<Texture> SDLRenderer::loadTexture(const std::string &path)
+    std::unique_ptr<Texture> SDLRenderer::loadTextureFile(const std::string &path)
     {
         SDL_Surface *surface = IMG_Load(path.c_str());
         if (!surface)
         {
-            std::cerr << "Unable to load image " << path << "! SDL_image Error: " << IMG_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "Unable to load image {}! SDL_image Error: {}", path, IMG_GetError());
             return nullptr;
         }
 
@@ -144,17 +150,32 @@ namespace zuul
 
         if (!texture)
         {
-            std::cerr << "Unable to create texture from " << path << "! SDL Error: " << SDL_GetError() << std::endl;
+            ZUUL_LOG_ERROR(Render, "Unable to create texture from {}! SDL Error: {}", path, SDL_GetError());
+            return nullptr;
+        }
+
+        return std::make_unique<SDLTexture>(texture);
+    }
+
+    std::unique_ptr<Texture> SDLRenderer::createPixelTexture(int width, int height, const uint32_t *pixels)
+    {
+        SDL_Texture *texture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+        if (!texture)
+        {
+            ZUUL_LOG_ERROR(Render, "Unable to create texture! SDL Error: {}", SDL_GetError());
             return nullptr;
         }
 
-        return std::make_shared<SDLTexture>(texture);
+        SDL_UpdateTexture(texture, nullptr, pixels, width * static_cast<int>(sizeof(uint32_t)));
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+        return std::make_unique<SDLTexture>(texture);
     }
 
-    void SDLRenderer::renderTexture(std::shared_ptr<Texture> texture, int srcX, int srcY, int srcW, int srcH,
+    void SDLRenderer::renderTexture(TextureHandle texture, int srcX, int srcY, int srcW, int srcH,
                                     int destX, int destY, int destW, int destH)
     {
-        auto sdlTexture = std::dynamic_pointer_cast<SDLTexture>(texture);
+        auto *sdlTexture = static_cast<SDLTexture *>(getTexture(texture));
         if (!sdlTexture)
         {
             return;
@@ -166,41 +187,77 @@ namespace zuul
         SDL_RenderCopy(mRenderer, sdlTexture->getSDLTexture(), &srcRect, &destRect);
     }
 
-    void SDLRenderer::renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    std::unique_ptr<Texture> SDLRenderer::createTargetTexture(int width, int height, bool linearFilter)
     {
-        SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
-        SDL_Rect rect = {x, y, w, h};
-        SDL_RenderDrawRect(mRenderer, &rect);
+        SDL_Texture *texture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!texture)
+        {
+            ZUUL_LOG_ERROR(Render, "Unable to create render target! SDL Error: {}", SDL_GetError());
+            return nullptr;
+        }
+
+        // Straight alpha blended into a transparent target comes out premultiplied
+        SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                                 SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+        if (SDL_SetTextureBlendMode(texture, premultiplied) != 0)
+        {
+            ZUUL_LOG_WARN(Render, "Premultiplied blending not supported, translucent target pixels will be darker: {}", SDL_GetError());
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        }
+        SDL_SetTextureScaleMode(texture, linearFilter ? SDL_ScaleModeLinear : SDL_ScaleModeNearest);
+
+        return std::make_unique<SDLTexture>(texture);
     }
 
-    void SDLRenderer::renderText(const std::string &text, int x, int y, const Color &color)
+    bool SDLRenderer::setRenderTarget(TextureHandle target)
     {
-        if (!mFont)
+        SDL_Texture *sdlTarget = nullptr;
+        if (target)
         {
-            return;
+            auto *sdlTexture = static_cast<SDLTexture *>(getTexture(target));
+            if (!sdlTexture)
+            {
+                return false;
+            }
+            sdlTarget = sdlTexture->getSDLTexture();
         }
 
-        SDL_Color sdlColor = {color.r, color.g, color.b, color.a};
-        SDL_Surface *surface = TTF_RenderText_Blended(mFont, text.c_str(), sdlColor);
-        if (!surface)
+        if (SDL_SetRenderTarget(mRenderer, sdlTarget) != 0)
         {
-            std::cerr << "Unable to render text surface! SDL_ttf Error: " << TTF_GetError() << std::endl;
-            return;
+            ZUUL_LOG_ERROR(Render, "Unable to set render target! SDL Error: {}", SDL_GetError());
+            return false;
         }
 
-        SDL_Texture *texture = SDL_CreateTextureFromSurface(mRenderer, surface);
-        if (!texture)
+        mRenderTarget = target;
+        return true;
+    }
+
+    void SDLRenderer::getOutputSize(int &width, int &height) const
+    {
+        if (getTextureSize(mRenderTarget, width, height))
         {
-            std::cerr << "Unable to create texture from rendered text! SDL Error: " << SDL_GetError() << std::endl;
-            SDL_FreeSurface(surface);
             return;
         }
 
-        SDL_Rect destRect = {x, y, surface->w, surface->h};
-        SDL_RenderCopy(mRenderer, texture, nullptr, &destRect);
+        SDL_GetRendererOutputSize(mRenderer, &width, &height);
+    }
 
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+    void SDLRenderer::renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    {
+        SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
+        SDL_Rect rect = {x, y, w, h};
+        SDL_RenderDrawRect(mRenderer, &rect);
+    }
+
+    std::unique_ptr<Texture> SDLRenderer::createTextTexture(SDL_Surface *surface)
+    {
+        SDL_Texture *texture = SDL_CreateTextureFromSurface(mRenderer, surface);
+        if (!texture)
+        {
+            ZUUL_LOG_ERROR(Render, "Unable to create texture from rendered text! SDL Error: {}", SDL_GetError());
+            return nullptr;
+        }
+        return std::make_unique<SDLTexture>(texture);
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,771 @@
+#include "engine/software_renderer.hpp"
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include "asset_manifest.hpp"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int TILE_SIZE = 128;
+        constexpr int MAX_WORKERS = 8;
+
+        // Approximates x / 255 for x in [0, 255 * 255]
+        inline uint32_t div255(uint32_t x)
+        {
+            x += 128;
+            return (x + (x >> 8)) >> 8;
+        }
+
+        // Straight alpha "over", matching SDL_BLENDMODE_BLEND:
+        // rgb = src.rgb * a + dst.rgb * (1 - a), alpha = a + dst.a * (1 - a)
+        // Premultiplied sources, i.e. render targets, skip the first product: rgb = src.rgb + dst.rgb * (1 - a)
+        template <bool Premultiplied>
+        inline uint32_t blendPixel(uint32_t src, uint32_t dst)
+        {
+            uint32_t a = src >> 24;
+            if (a == 255)
+            {
+                return src;
+            }
+            if (a == 0)
+            {
+                return dst;
+            }
+
+            uint32_t ia = 255 - a;
+            uint32_t sa = Premultiplied ? 255 : a;
+            uint32_t r = div255(((src >> 16) & 0xFF) * sa + ((dst >> 16) & 0xFF) * ia);
+            uint32_t g = div255(((src >> 8) & 0xFF) * sa + ((dst >> 8) & 0xFF) * ia);
+            uint32_t b = div255((src & 0xFF) * sa + (dst & 0xFF) * ia);
+            uint32_t outA = div255(a * 255 + (dst >> 24) * ia);
+            return (outA << 24) | (r << 16) | (g << 8) | b;
+        }
+
+#if defined(__SSE2__)
+        // Blends four ARGB pixels. Pixels are widened to 16 bits per channel; the alpha
+        // lane uses 255 as its source factor so it ends up as a + dst.a * (1 - a).
+        // Premultiplied sources use 255 for every lane.
+        template <bool Premultiplied>
+        inline __m128i blend4(__m128i src, __m128i dst)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i c255 = _mm_set1_epi16(255);
+            const __m128i c128 = _mm_set1_epi16(128);
+            const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+            __m128i srcLo = _mm_unpacklo_epi8(src, zero);
+            __m128i srcHi = _mm_unpackhi_epi8(src, zero);
+            __m128i dstLo = _mm_unpacklo_epi8(dst, zero);
+            __m128i dstHi = _mm_unpackhi_epi8(dst, zero);
+
+            __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLo, 0xFF), 0xFF);
+            __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHi, 0xFF), 0xFF);
+
+            __m128i factorLo = Premultiplied ? c255 : _mm_or_si128(_mm_andnot_si128(alphaLanes, alphaLo), _mm_and_si128(alphaLanes, c255));
+            __m128i factorHi = Premultiplied ? c255 : _mm_or_si128(_mm_andnot_si128(alphaLanes, alphaHi), _mm_and_si128(alphaLanes, c255));
+
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(srcLo, factorLo), _mm_mullo_epi16(dstLo, _mm_sub_epi16(c255, alphaLo)));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(srcHi, factorHi), _mm_mullo_epi16(dstHi, _mm_sub_epi16(c255, alphaHi)));
+
+            lo = _mm_add_epi16(lo, c128);
+            hi = _mm_add_epi16(hi, c128);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+            return _mm_packus_epi16(lo, hi);
+        }
+#endif
+
+#if defined(__AVX2__)
+        template <bool Premultiplied>
+        inline __m256i blend8(__m256i src, __m256i dst)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i c255 = _mm256_set1_epi16(255);
+            const __m256i c128 = _mm256_set1_epi16(128);
+            const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+
+            // Unpack and pack both work within 128-bit lanes, so pixel order is preserved
+            __m256i srcLo = _mm256_unpacklo_epi8(src, zero);
+            __m256i srcHi = _mm256_unpackhi_epi8(src, zero);
+            __m256i dstLo = _mm256_unpacklo_epi8(dst, zero);
+            __m256i dstHi = _mm256_unpackhi_epi8(dst, zero);
+
+            __m256i alphaLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcLo, 0xFF), 0xFF);
+            __m256i alphaHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcHi, 0xFF), 0xFF);
+
+            __m256i factorLo = Premultiplied ? c255 : _mm256_blendv_epi8(alphaLo, c255, alphaLanes);
+            __m256i factorHi = Premultiplied ? c255 : _mm256_blendv_epi8(alphaHi, c255, alphaLanes);
+
+            __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(srcLo, factorLo), _mm256_mullo_epi16(dstLo, _mm256_sub_epi16(c255, alphaLo)));
+            __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(srcHi, factorHi), _mm256_mullo_epi16(dstHi, _mm256_sub_epi16(c255, alphaHi)));
+
+            lo = _mm256_add_epi16(lo, c128);
+            hi = _mm256_add_epi16(hi, c128);
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+            return _mm256_packus_epi16(lo, hi);
+        }
+#endif
+
+        void copyRow(uint32_t *dst, const uint32_t *src, int count)
+        {
+            int i = 0;
+#if defined(__AVX2__)
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)));
+            }
+#endif
+#if defined(__SSE2__)
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+            }
+#elif defined(__ARM_NEON)
+            for (; i + 4 <= count; i += 4)
+            {
+                vst1q_u32(dst + i, vld1q_u32(src + i));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                dst[i] = src[i];
+            }
+        }
+
+        template <bool Premultiplied>
+        void blendRow(uint32_t *dst, const uint32_t *src, int count)
+        {
+            int i = 0;
+#if defined(__AVX2__)
+            const __m256i opaque8 = _mm256_set1_epi32(255);
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                __m256i alpha = _mm256_srli_epi32(s, 24);
+
+                // Whole blocks of opaque or empty pixels are common in tiles and text
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, opaque8)) == -1)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), s);
+                    continue;
+                }
+                if (_mm256_testz_si256(alpha, alpha))
+                {
+                    continue;
+                }
+
+                __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), blend8<Premultiplied>(s, d));
+            }
+#endif
+#if defined(__SSE2__)
+            const __m128i opaque4 = _mm_set1_epi32(255);
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                __m128i alpha = _mm_srli_epi32(s, 24);
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque4)) == 0xFFFF)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), s);
+                    continue;
+                }
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF)
+                {
+                    continue;
+                }
+
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), blend4<Premultiplied>(s, d));
+            }
+#elif defined(__ARM_NEON)
+            for (; i + 8 <= count; i += 8)
+            {
+                // De-interleave eight pixels into B, G, R and A planes
+                uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t *>(src + i));
+                uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t *>(dst + i));
+                uint8x8_t alpha = s.val[3];
+                uint8x8_t inverse = vmvn_u8(alpha);
+                uint8x8_t factor = Premultiplied ? vdup_n_u8(255) : alpha;
+                uint8x8x4_t out;
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint16x8_t t = vmlal_u8(vmull_u8(s.val[c], factor), d.val[c], inverse);
+                    out.val[c] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+                }
+                uint16x8_t t = vmlal_u8(vmull_u8(alpha, vdup_n_u8(255)), d.val[3], inverse);
+                out.val[3] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+
+                vst4_u8(reinterpret_cast<uint8_t *>(dst + i), out);
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                dst[i] = blendPixel<Premultiplied>(src[i], dst[i]);
+            }
+        }
+
+        // Nearest-neighbour horizontal scaling: picks the source column for each destination pixel
+        void gatherRow(uint32_t *dst, const uint32_t *srcRow, const int *columns, int count)
+        {
+            int i = 0;
+#if defined(__AVX2__)
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columns + i));
+                __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int *>(srcRow), index, 4);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), pixels);
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                dst[i] = srcRow[columns[i]];
+            }
+        }
+
+        void blendSpan(uint32_t *dst, int count, uint32_t color)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                dst[i] = blendPixel<false>(color, dst[i]);
+            }
+        }
+
+        bool clipRect(const SDL_Rect &rect, int x0, int y0, int x1, int y1, SDL_Rect &out)
+        {
+            int left = std::max(rect.x, x0);
+            int top = std::max(rect.y, y0);
+            int right = std::min(rect.x + rect.w, x1);
+            int bottom = std::min(rect.y + rect.h, y1);
+            if (left >= right || top >= bottom)
+            {
+                return false;
+            }
+            out = {left, top, right - left, bottom - top};
+            return true;
+        }
+    }
+
+    SoftwareTexture::SoftwareTexture(int width, int height)
+        : mPixels(static_cast<size_t>(width) * height, 0),
+          mWidth(width),
+          mHeight(height),
+          mOpaque(false),
+          mPremultiplied(false)
+    {
+    }
+
+    void SoftwareTexture::updateOpacity()
+    {
+        mOpaque = std::all_of(mPixels.begin(), mPixels.end(), [](uint32_t pixel)
+                              { return (pixel >> 24) == 255; });
+    }
+
+    SoftwareRenderer::SoftwareRenderer()
+        : Renderer(),
+          mWindow(nullptr),
+          mStreamingTexture(nullptr),
+          mTarget(nullptr),
+          mTilesX(0),
+          mTilesY(0),
+          mGeneration(0),
+          mBusyWorkers(0),
+          mShuttingDown(false),
+          mNextTile(0)
+    {
+    }
+
+    SoftwareRenderer::~SoftwareRenderer()
+    {
+        cleanup();
+    }
+
+    bool SoftwareRenderer::initialize(int windowWidth, int windowHeight, const std::string &windowTitle)
+    {
+        // Initialize SDL
+        if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        {
+            ZUUL_LOG_ERROR(Render, "SDL could not initialize! SDL_Error: {}", SDL_GetError());
+            return false;
+        }
+
+        // Initialize SDL_image
+        int imgFlags = IMG_INIT_PNG;
+        if (!(IMG_Init(imgFlags) & imgFlags))
+        {
+            ZUUL_LOG_ERROR(Render, "SDL_image could not initialize! SDL_image Error: {}", IMG_GetError());
+            return false;
+        }
+
+        // Initialize SDL_ttf
+        if (TTF_Init() == -1)
+        {
+            ZUUL_LOG_ERROR(Render, "SDL_ttf could not initialize! SDL_ttf Error: {}", TTF_GetError());
+            return false;
+        }
+
+        // Create window
+        mWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                   windowWidth, windowHeight, SDL_WINDOW_SHOWN);
+        if (!mWindow)
+        {
+            ZUUL_LOG_ERROR(Render, "Window could not be created! SDL_Error: {}", SDL_GetError());
+            return false;
+        }
+
+        // The SDL renderer only presents one streaming texture per frame, so any backend will do
+        mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (!mRenderer)
+        {
+            mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_SOFTWARE);
+        }
+        if (!mRenderer)
+        {
+            ZUUL_LOG_ERROR(Render, "Renderer could not be created! SDL_Error: {}", SDL_GetError());
+            return false;
+        }
+
+        mStreamingTexture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                              windowWidth, windowHeight);
+        if (!mStreamingTexture)
+        {
+            ZUUL_LOG_ERROR(Render, "Streaming texture could not be created! SDL_Error: {}", SDL_GetError());
+            return false;
+        }
+
+        mFramebuffer = std::make_unique<SoftwareTexture>(windowWidth, windowHeight);
+        mTarget = mFramebuffer.get();
+
+        // Load font
+        mFont = TTF_OpenFontRW(getFileSystem().openFile(manifest::FONT.path), 1, 16);
+        if (!mFont)
+        {
+            ZUUL_LOG_ERROR(Render, "Failed to load font! SDL_ttf Error: {}", TTF_GetError());
+            return false;
+        }
+
+        // The main thread rasterizes tiles too, so start one worker less than there are cores
+        int workerCount = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0, MAX_WORKERS - 1);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            mWorkers.emplace_back(&SoftwareRenderer::workerLoop, this);
+        }
+
+        return true;
+    }
+
+    void SoftwareRenderer::cleanup()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShuttingDown = true;
+        }
+        mWorkAvailable.notify_all();
+        for (auto &worker : mWorkers)
+        {
+            worker.join();
+        }
+        mWorkers.clear();
+
+        mCommands.clear();
+        destroyAllTextures();
+        mTarget = nullptr;
+        mFramebuffer.reset();
+
+        if (mFont)
+        {
+            TTF_CloseFont(mFont);
+            mFont = nullptr;
+        }
+
+        if (mStreamingTexture)
+        {
+            SDL_DestroyTexture(mStreamingTexture);
+            mStreamingTexture = nullptr;
+        }
+
+        if (mRenderer)
+        {
+            SDL_DestroyRenderer(mRenderer);
+            mRenderer = nullptr;
+        }
+
+        if (mWindow)
+        {
+            SDL_DestroyWindow(mWindow);
+            mWindow = nullptr;
+        }
+
+        TTF_Quit();
+        IMG_Quit();
+        SDL_Quit();
+    }
+
+    void SoftwareRenderer::clear(const Color &color)
+    {
+        if (!mTarget)
+        {
+            return;
+        }
+
+        // Anything queued for this target would be overwritten anyway
+        mCommands.clear();
+
+        uint32_t argb = (static_cast<uint32_t>(color.a) << 24) | (color.r << 16) | (color.g << 8) | color.b;
+        uint32_t *pixels = mTarget->getPixels();
+        std::fill(pixels, pixels + static_cast<size_t>(mTarget->getWidth()) * mTarget->getHeight(), argb);
+    }
+
+    void SoftwareRenderer::present()
+    {
+        setRenderTarget({});
+        flush();
+
+        SDL_UpdateTexture(mStreamingTexture, nullptr, mFramebuffer->getPixels(),
+                          mFramebuffer->getWidth() * static_cast<int>(sizeof(uint32_t)));
+        SDL_RenderCopy(mRenderer, mStreamingTexture, nullptr, nullptr);
+        SDL_RenderPresent(mRenderer);
+
+        // Textures are only freed here, after the commands pointing at them were rasterized
+        endFrame();
+    }
+
+    std::unique_ptr<SoftwareTexture> SoftwareRenderer::createFromSurface(SDL_Surface *surface)
+    {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!converted)
+        {
+            return nullptr;
+        }
+
+        auto texture = std::make_unique<SoftwareTexture>(converted->w, converted->h);
+
+        SDL_LockSurface(converted);
+        const auto *srcBytes = static_cast<const uint8_t *>(converted->pixels);
+        for (int y = 0; y < converted->h; ++y)
+        {
+            std::memcpy(texture->getPixels() + static_cast<size_t>(y) * converted->w,
+                        srcBytes + static_cast<size_t>(y) * converted->pitch,
+                        converted->w * sizeof(uint32_t));
+        }
+        SDL_UnlockSurface(converted);
+        SDL_FreeSurface(converted);
+
+        texture->updateOpacity();
+        return texture;
+    }
+
+    std::unique_ptr<Texture> SoftwareRenderer::loadTextureFile(const std::string &path)
+    {
+        SDL_Surface *surface = IMG_Load(path.c_str());
+        if (!surface)
+        {
+            ZUUL_LOG_ERROR(Render, "Unable to load image {}! SDL_image Error: {}", path, IMG_GetError());
+            return nullptr;
+        }
+
+        auto texture = createFromSurface(surface);
+        SDL_FreeSurface(surface);
+
+        if (!texture)
+        {
+            ZUUL_LOG_ERROR(Render, "Unable to convert image {}! SDL Error: {}", path, SDL_GetError());
+            return nullptr;
+        }
+
+        return texture;
+    }
+
+    std::unique_ptr<Texture> SoftwareRenderer::createPixelTexture(int width, int height, const uint32_t *pixels)
+    {
+        auto texture = std::make_unique<SoftwareTexture>(width, height);
+        std::memcpy(texture->getPixels(), pixels, static_cast<size_t>(width) * height * sizeof(uint32_t));
+        texture->updateOpacity();
+        return texture;
+    }
+
+    void SoftwareRenderer::renderTexture(TextureHandle texture, int srcX, int srcY, int srcW, int srcH,
+                                         int destX, int destY, int destW, int destH)
+    {
+        const auto *softwareTexture = static_cast<const SoftwareTexture *>(getTexture(texture));
+        if (!softwareTexture || srcW <= 0 || srcH <= 0 || destW <= 0 || destH <= 0)
+        {
+            return;
+        }
+
+        mCommands.push_back({softwareTexture, {srcX, srcY, srcW, srcH}, {destX, destY, destW, destH}, 0});
+    }
+
+    std::unique_ptr<Texture> SoftwareRenderer::createTargetTexture(int width, int height, bool linearFilter)
+    {
+        // Scaling is always nearest-neighbour in this backend, so linearFilter has no effect
+        auto texture = std::make_unique<SoftwareTexture>(width, height);
+        texture->setPremultiplied(true);
+        return texture;
+    }
+
+    bool SoftwareRenderer::setRenderTarget(TextureHandle target)
+    {
+        SoftwareTexture *newTarget = mFramebuffer.get();
+        if (target)
+        {
+            newTarget = static_cast<SoftwareTexture *>(getTexture(target));
+            if (!newTarget)
+            {
+                return false;
+            }
+        }
+
+        if (newTarget != mTarget)
+        {
+            flush();
+            mTarget = newTarget;
+        }
+        return true;
+    }
+
+    void SoftwareRenderer::getOutputSize(int &width, int &height) const
+    {
+        width = mTarget ? mTarget->getWidth() : 0;
+        height = mTarget ? mTarget->getHeight() : 0;
+    }
+
+    void SoftwareRenderer::renderRect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    {
+        if (w <= 0 || h <= 0)
+        {
+            return;
+        }
+
+        uint32_t color = (static_cast<uint32_t>(a) << 24) | (r << 16) | (g << 8) | b;
+        mCommands.push_back({nullptr, {0, 0, 0, 0}, {x, y, w, h}, color});
+    }
+
+    std::unique_ptr<Texture> SoftwareRenderer::createTextTexture(SDL_Surface *surface)
+    {
+        return createFromSurface(surface);
+    }
+
+    void SoftwareRenderer::flush()
+    {
+        if (mCommands.empty() || !mTarget)
+        {
+            mCommands.clear();
+            return;
+        }
+
+        int targetWidth = mTarget->getWidth();
+        int targetHeight = mTarget->getHeight();
+        mTilesX = (targetWidth + TILE_SIZE - 1) / TILE_SIZE;
+        mTilesY = (targetHeight + TILE_SIZE - 1) / TILE_SIZE;
+        int tileCount = mTilesX * mTilesY;
+
+        // Bin each command into the tiles it touches, keeping submission order within a tile
+        if (static_cast<int>(mTileBins.size()) < tileCount)
+        {
+            mTileBins.resize(tileCount);
+        }
+        for (int i = 0; i < tileCount; ++i)
+        {
+            mTileBins[i].clear();
+        }
+
+        for (uint32_t i = 0; i < mCommands.size(); ++i)
+        {
+            SDL_Rect clipped;
+            if (!clipRect(mCommands[i].dest, 0, 0, targetWidth, targetHeight, clipped))
+            {
+                continue;
+            }
+
+            int firstX = clipped.x / TILE_SIZE;
+            int firstY = clipped.y / TILE_SIZE;
+            int lastX = (clipped.x + clipped.w - 1) / TILE_SIZE;
+            int lastY = (clipped.y + clipped.h - 1) / TILE_SIZE;
+            for (int ty = firstY; ty <= lastY; ++ty)
+            {
+                for (int tx = firstX; tx <= lastX; ++tx)
+                {
+                    mTileBins[ty * mTilesX + tx].push_back(i);
+                }
+            }
+        }
+
+        // Tiles never overlap, so they can be rasterized in any order on any thread
+        mNextTile = 0;
+        if (!mWorkers.empty() && tileCount > 1)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mGeneration++;
+                mBusyWorkers = static_cast<int>(mWorkers.size());
+            }
+            mWorkAvailable.notify_all();
+        }
+
+        int tile;
+        while ((tile = mNextTile.fetch_add(1)) < tileCount)
+        {
+            rasterizeTile(tile);
+        }
+
+        if (!mWorkers.empty() && tileCount > 1)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkDone.wait(lock, [this]
+                           { return mBusyWorkers == 0; });
+        }
+
+        mCommands.clear();
+    }
+
+    void SoftwareRenderer::workerLoop()
+    {
+        uint64_t seenGeneration = 0;
+
+        while (true)
+        {
+            int tileCount;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWorkAvailable.wait(lock, [&]
+                                    { return mShuttingDown || mGeneration != seenGeneration; });
+                if (mShuttingDown)
+                {
+                    return;
+                }
+                seenGeneration = mGeneration;
+                tileCount = mTilesX * mTilesY;
+            }
+
+            int tile;
+            while ((tile = mNextTile.fetch_add(1)) < tileCount)
+            {
+                rasterizeTile(tile);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (--mBusyWorkers == 0)
+                {
+                    mWorkDone.notify_one();
+                }
+            }
+        }
+    }
+
+    void SoftwareRenderer::rasterizeTile(int tileIndex)
+    {
+        const int targetWidth = mTarget->getWidth();
+        const int targetHeight = mTarget->getHeight();
+        const int clipX0 = (tileIndex % mTilesX) * TILE_SIZE;
+        const int clipY0 = (tileIndex / mTilesX) * TILE_SIZE;
+        const int clipX1 = std::min(clipX0 + TILE_SIZE, targetWidth);
+        const int clipY1 = std::min(clipY0 + TILE_SIZE, targetHeight);
+        uint32_t *framebuffer = mTarget->getPixels();
+
+        int columns[TILE_SIZE];
+        uint32_t scaledRow[TILE_SIZE];
+
+        for (uint32_t commandIndex : mTileBins[tileIndex])
+        {
+            const DrawCommand &command = mCommands[commandIndex];
+            SDL_Rect clip;
+            if (!clipRect(command.dest, clipX0, clipY0, clipX1, clipY1, clip))
+            {
+                continue;
+            }
+
+            // Rectangle outline, one pixel wide like SDL_RenderDrawRect
+            if (!command.texture)
+            {
+                const SDL_Rect &rect = command.dest;
+                for (int y = clip.y; y < clip.y + clip.h; ++y)
+                {
+                    uint32_t *row = framebuffer + static_cast<size_t>(y) * targetWidth;
+                    if (y == rect.y || y == rect.y + rect.h - 1)
+                    {
+                        blendSpan(row + clip.x, clip.w, command.color);
+                        continue;
+                    }
+                    if (rect.x >= clip.x)
+                    {
+                        blendSpan(row + rect.x, 1, command.color);
+                    }
+                    if (rect.x + rect.w - 1 < clip.x + clip.w && rect.w > 1)
+                    {
+                        blendSpan(row + rect.x + rect.w - 1, 1, command.color);
+                    }
+                }
+                continue;
+            }
+
+            const SoftwareTexture *texture = command.texture;
+            const SDL_Rect &src = command.src;
+            const SDL_Rect &dest = command.dest;
+            const int textureWidth = texture->getWidth();
+            const int textureHeight = texture->getHeight();
+
+            // 16.16 fixed point steps, sampling at the centre of each destination pixel
+            const int64_t stepX = (static_cast<int64_t>(src.w) << 16) / dest.w;
+            const int64_t stepY = (static_cast<int64_t>(src.h) << 16) / dest.h;
+
+            const int firstColumn = src.x + (clip.x - dest.x);
+            const bool unscaledX = src.w == dest.w && firstColumn >= 0 && firstColumn + clip.w <= textureWidth;
+            if (!unscaledX)
+            {
+                for (int i = 0; i < clip.w; ++i)
+                {
+                    int64_t u = src.x + ((((clip.x - dest.x) + i) * stepX + stepX / 2) >> 16);
+                    columns[i] = static_cast<int>(std::clamp<int64_t>(u, 0, textureWidth - 1));
+                }
+            }
+
+            for (int y = clip.y; y < clip.y + clip.h; ++y)
+            {
+                int64_t v = src.y + (((y - dest.y) * stepY + stepY / 2) >> 16);
+                v = std::clamp<int64_t>(v, 0, textureHeight - 1);
+                const uint32_t *srcRow = texture->getPixels() + v * textureWidth;
+
+                const uint32_t *span = srcRow + firstColumn;
+                if (!unscaledX)
+                {
+                    gatherRow(scaledRow, srcRow, columns, clip.w);
+                    span = scaledRow;
+                }
+
+                uint32_t *dst = framebuffer + static_cast<size_t>(y) * targetWidth + clip.x;
+                if (texture->isOpaque())
+                {
+                    copyRow(dst, span, clip.w);
+                }
+                else if (texture->isPremultiplied())
+                {
+                    blendRow<true>(dst, span, clip.w);
+                }
+                else
+                {
+                    blendRow<false>(dst, span, clip.w);
+                }
+            }
+        }
+    }
+
+} // namespace zuul
@@ -28,8 +28,8 @@ namespace zuul
         // Store old zoom for position adjustment
         float oldZoom = mZoom;
 
-        // Clamp zoom between 1.0 and 3.0
-        mZoom = std::clamp(zoom, 1.0f, 3.0f);
+        // Clamp zoom between 1/8, where maps are drawn from their smallest chunk images, and 3.0
+        mZoom = std::clamp(zoom, 0.125f, 3.0f);
 
         // Adjust offset to maintain center point when zooming
         if (oldZoom != mZoom)
@@ -49,6 +49,13 @@ namespace zuul
         setZoom(mZoom + delta);
     }
 
+    void Camera::setMapSize(int mapWidth, int mapHeight)
+    {
+        mMapWidth = mapWidth;
+        mMapHeight = mapHeight;
+        clampOffset();
+    }
+
     void Camera::worldToScreen(float worldX, float worldY, float &screenX, float &screenY) const
     {
         screenX = (worldX - mOffsetX) * mZoom;
@@ -67,8 +74,9 @@ namespace zuul
         float maxOffsetX = mMapWidth - mWindowWidth / mZoom;
         float maxOffsetY = mMapHeight - mWindowHeight / mZoom;
 
-        mOffsetX = std::clamp(mOffsetX, 0.0f, maxOffsetX);
-        mOffsetY = std::clamp(mOffsetY, 0.0f, maxOffsetY);
+        // A map smaller than the view is centered instead
+        mOffsetX = maxOffsetX < 0.0f ? maxOffsetX / 2.0f : std::clamp(mOffsetX, 0.0f, maxOffsetX);
+        mOffsetY = maxOffsetY < 0.0f ? maxOffsetY / 2.0f : std::clamp(mOffsetY, 0.0f, maxOffsetY);
     }
 
 } // namespace zuul
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include <game/collision_world.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr uint32_t LEAF_SIZE = 4;
+        constexpr float INFINITE_TIME = std::numeric_limits<float>::infinity();
+
+        // Entry and exit time of a box [minX, maxX) x [minY, maxY) moving by (dx, dy)
+        // through a static box, along one axis at a time (slab test). Entry is the later
+        // of the axis entries; the axis it came from gives the contact normal.
+        struct SlabResult
+        {
+            float entry;
+            float exit;
+            bool entryOnX;
+        };
+
+        inline bool slabAxis(float movingMin, float movingMax, float staticMin, float staticMax, float delta,
+                             float &entry, float &exit)
+        {
+            if (delta == 0.0f)
+            {
+                // Not moving on this axis: it has to overlap the whole time
+                entry = -INFINITE_TIME;
+                exit = INFINITE_TIME;
+                return movingMax > staticMin && movingMin < staticMax;
+            }
+
+            float toEnter = delta > 0.0f ? staticMin - movingMax : staticMax - movingMin;
+            float toExit = delta > 0.0f ? staticMax - movingMin : staticMin - movingMax;
+            entry = toEnter / delta;
+            exit = toExit / delta;
+            return true;
+        }
+
+        inline bool slab(float minX, float minY, float maxX, float maxY, float dx, float dy,
+                         float staticMinX, float staticMinY, float staticMaxX, float staticMaxY, SlabResult &result)
+        {
+            float entryX, exitX, entryY, exitY;
+            if (!slabAxis(minX, maxX, staticMinX, staticMaxX, dx, entryX, exitX) ||
+                !slabAxis(minY, maxY, staticMinY, staticMaxY, dy, entryY, exitY))
+            {
+                return false;
+            }
+
+            result.entry = std::max(entryX, entryY);
+            result.exit = std::min(exitX, exitY);
+            result.entryOnX = entryX > entryY;
+            return result.entry < result.exit;
+        }
+    }
+
+    void CollisionWorld::build(std::vector<CollisionBox> colliders)
+    {
+        mColliders = std::move(colliders);
+        mNodes.clear();
+        if (mColliders.empty())
+        {
+            return;
+        }
+        mNodes.reserve(mColliders.size() * 2 / LEAF_SIZE + 1);
+        buildNode(0, static_cast<uint32_t>(mColliders.size()));
+    }
+
+    uint32_t CollisionWorld::buildNode(uint32_t first, uint32_t count)
+    {
+        const uint32_t index = static_cast<uint32_t>(mNodes.size());
+        mNodes.push_back({});
+
+        float minX = INFINITE_TIME, minY = INFINITE_TIME, maxX = -INFINITE_TIME, maxY = -INFINITE_TIME;
+        float centerMinX = INFINITE_TIME, centerMinY = INFINITE_TIME, centerMaxX = -INFINITE_TIME, centerMaxY = -INFINITE_TIME;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const CollisionBox &box = mColliders[i];
+            minX = std::min(minX, box.x);
+            minY = std::min(minY, box.y);
+            maxX = std::max(maxX, box.x + box.width);
+            maxY = std::max(maxY, box.y + box.height);
+
+            float centerX = box.x + box.width * 0.5f;
+            float centerY = box.y + box.height * 0.5f;
+            centerMinX = std::min(centerMinX, centerX);
+            centerMinY = std::min(centerMinY, centerY);
+            centerMaxX = std::max(centerMaxX, centerX);
+            centerMaxY = std::max(centerMaxY, centerY);
+        }
+
+        if (count <= LEAF_SIZE)
+        {
+            mNodes[index] = {minX, minY, maxX, maxY, first, count};
+            return index;
+        }
+
+        // Split at the median along the axis where the centers spread the most
+        bool splitX = centerMaxX - centerMinX >= centerMaxY - centerMinY;
+        auto begin = mColliders.begin() + first;
+        auto middle = begin + count / 2;
+        std::nth_element(begin, middle, begin + count, [splitX](const CollisionBox &a, const CollisionBox &b)
+                         { return splitX ? a.x * 2 + a.width < b.x * 2 + b.width
+                                         : a.y * 2 + a.height < b.y * 2 + b.height; });
+
+        buildNode(first, count / 2);
+        uint32_t right = buildNode(first + count / 2, count - count / 2);
+        mNodes[index] = {minX, minY, maxX, maxY, right, 0};
+        return index;
+    }
+
+    bool CollisionWorld::overlaps(const CollisionBox &box) const
+    {
+        return findOverlaps(box, nullptr);
+    }
+
+    void CollisionWorld::queryOverlaps(const CollisionBox &box, std::vector<int> &colliders) const
+    {
+        findOverlaps(box, &colliders);
+    }
+
+    bool CollisionWorld::findOverlaps(const CollisionBox &box, std::vector<int> *colliders) const
+    {
+        if (mNodes.empty())
+        {
+            return false;
+        }
+
+        bool found = false;
+        const float maxX = box.x + box.width;
+        const float maxY = box.y + box.height;
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node &node = mNodes[stack[--top]];
+            if (box.x >= node.maxX || maxX <= node.minX || box.y >= node.maxY || maxY <= node.minY)
+            {
+                continue;
+            }
+
+            if (node.count == 0)
+            {
+                stack[top++] = node.first;
+                stack[top++] = static_cast<uint32_t>(&node - mNodes.data()) + 1;
+                continue;
+            }
+
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                const CollisionBox &other = mColliders[i];
+                if (box.x < other.x + other.width && maxX > other.x && box.y < other.y + other.height && maxY > other.y)
+                {
+                    // Without an output list the first overlap answers the query
+                    if (!colliders)
+                    {
+                        return true;
+                    }
+                    colliders->push_back(static_cast<int>(i));
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    bool CollisionWorld::castBox(const CollisionBox &box, float dx, float dy, CollisionHit &hit) const
+    {
+        return sweep(box.x, box.y, box.x + box.width, box.y + box.height, dx, dy, hit);
+    }
+
+    bool CollisionWorld::raycast(float x, float y, float dx, float dy, CollisionHit &hit) const
+    {
+        return sweep(x, y, x, y, dx, dy, hit);
+    }
+
+    bool CollisionWorld::sweep(float minX, float minY, float maxX, float maxY, float dx, float dy, CollisionHit &hit) const
+    {
+        if (mNodes.empty() || (dx == 0.0f && dy == 0.0f))
+        {
+            return false;
+        }
+
+        bool found = false;
+        float bestTime = 1.0f;
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node &node = mNodes[stack[--top]];
+
+            // Skip subtrees the motion never reaches, or only reaches after the best hit so far
+            SlabResult bounds;
+            if (!slab(minX, minY, maxX, maxY, dx, dy, node.minX, node.minY, node.maxX, node.maxY, bounds) ||
+                bounds.exit < 0.0f || bounds.entry > bestTime)
+            {
+                continue;
+            }
+
+            if (node.count == 0)
+            {
+                stack[top++] = node.first;
+                stack[top++] = static_cast<uint32_t>(&node - mNodes.data()) + 1;
+                continue;
+            }
+
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                const CollisionBox &other = mColliders[i];
+                SlabResult result;
+                if (!slab(minX, minY, maxX, maxY, dx, dy, other.x, other.y, other.x + other.width, other.y + other.height, result) ||
+                    result.entry < 0.0f || result.entry > bestTime || (found && result.entry == bestTime))
+                {
+                    continue;
+                }
+
+                found = true;
+                bestTime = result.entry;
+                hit.time = result.entry;
+                hit.normalX = result.entryOnX ? (dx > 0.0f ? -1.0f : 1.0f) : 0.0f;
+                hit.normalY = result.entryOnX ? 0.0f : (dy > 0.0f ? -1.0f : 1.0f);
+                hit.collider = static_cast<int>(i);
+            }
+        }
+        return found;
+    }
+
+} // namespace zuul
@@ -0,0 +1,161 @@
+#include <game/hot_reload.hpp>
+#include <engine/file_system.hpp>
+#include <engine/log.hpp>
+#include <game/tileset_data.hpp>
+#include <filesystem>
+
+namespace zuul
+{
+
+    HotReloader::~HotReloader()
+    {
+        stop();
+    }
+
+    void HotReloader::addMap(TileMap *map, bool bakeComposites)
+    {
+        mMaps.push_back({map, map->getFilepath(), map->getTileLayout(), bakeComposites});
+    }
+
+    bool HotReloader::start(const std::string &directory)
+    {
+        if (!mWatcher.start({directory}, [this](const std::vector<std::string> &paths)
+                            { onFilesChanged(paths); }))
+        {
+            return false;
+        }
+
+        ZUUL_LOG_INFO(Assets, "Watching {} for changes", directory);
+        return true;
+    }
+
+    void HotReloader::stop()
+    {
+        mWatcher.stop();
+    }
+
+    void HotReloader::update(AssetRegistry &assets)
+    {
+        std::vector<std::function<void(AssetRegistry &)>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            pending.swap(mPending);
+        }
+
+        for (auto &apply : pending)
+        {
+            apply(assets);
+        }
+    }
+
+    void HotReloader::onFilesChanged(const std::vector<std::string> &paths)
+    {
+        for (const auto &path : paths)
+        {
+            // Edited files take precedence over their copies in the asset pack
+            getFileSystem().useDiskCopy(path);
+
+            for (const auto &watched : mMaps)
+            {
+                if (watched.filepath == path)
+                {
+                    reloadMap(watched);
+                }
+            }
+
+            std::string extension = std::filesystem::path(path).extension().string();
+            if (extension == ".tsj")
+            {
+                reloadTileset(path);
+            }
+            else if (extension == ".png")
+            {
+                reloadImage(path);
+            }
+        }
+    }
+
+    void HotReloader::reloadMap(const WatchedMap &watched)
+    {
+        // Parsed here; a map that fails to parse (e.g. saved halfway) stays as it is
+        std::shared_ptr<MapSnapshot> snapshot = TileMap::readSnapshot(watched.filepath, watched.layout);
+        if (!snapshot)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        mPending.push_back([this, watched, snapshot](AssetRegistry &assets)
+                           {
+            if (watched.map->patchFromSnapshot(std::move(*snapshot), assets))
+            {
+                finishReload(watched, assets);
+            } });
+    }
+
+    void HotReloader::reloadTileset(const std::string &path)
+    {
+        auto tileset = std::make_shared<TilesetData>();
+        if (!tileset->readFromFile(path))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        mPending.push_back([this, path, tileset](AssetRegistry &assets)
+                           {
+            for (const auto &watched : mMaps)
+            {
+                bool used = false;
+                for (const auto &mapTileset : watched.map->getTilesets())
+                {
+                    if (mapTileset.data->getSourcePath() == path)
+                    {
+                        mapTileset.data->patchFrom(*tileset, assets);
+                        used = true;
+                    }
+                }
+                if (used)
+                {
+                    watched.map->refreshTilesets();
+                    finishReload(watched, assets);
+                }
+            }
+            ZUUL_LOG_INFO(Assets, "Reloaded tileset {}", path); });
+    }
+
+    void HotReloader::reloadImage(const std::string &path)
+    {
+        // Textures can only be created on the main thread
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        mPending.push_back([this, path](AssetRegistry &assets)
+                           {
+            for (const auto &watched : mMaps)
+            {
+                bool used = false;
+                for (const auto &mapTileset : watched.map->getTilesets())
+                {
+                    if (mapTileset.data->getImagePath() == path)
+                    {
+                        mapTileset.data->reloadImage(assets);
+                        used = true;
+                    }
+                }
+                if (used)
+                {
+                    watched.map->refreshTilesets();
+                    finishReload(watched, assets);
+                    ZUUL_LOG_INFO(Assets, "Reloaded image {}", path);
+                }
+            } });
+    }
+
+    void HotReloader::finishReload(const WatchedMap &watched, AssetRegistry &assets)
+    {
+        if (watched.bakeComposites)
+        {
+            watched.map->bakeCompositeTiles(assets);
+        }
+    }
+
+} // namespace zuul
@@ -3,15 +3,14 @@
 
 namespace zuul
 {
-    Item::Item(int tileId, float x, float y, std::shared_ptr<TilesetData> tilesetData, std::shared_ptr<Texture> texture)
+    Item::Item(int tileId, float x, float y, std::shared_ptr<TilesetData> tilesetData)
         : mTileId(tileId),
           mX(x),
           mY(y),
           mWidth(tilesetData->getTilesetInfo().tileWidth),
           mHeight(tilesetData->getTilesetInfo().tileHeight),
           mCollected(false),
-          mTilesetData(tilesetData),
-          mTexture(texture)
+          mTilesetData(tilesetData)
     {
     }
 
@@ -20,9 +19,10 @@ namespace zuul
         // No need to update TilesetData here as it's handled by TileMap
     }
 
-    void Item::render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void Item::queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom) const
     {
-        if (!mCollected && mTexture)
+        TextureHandle texture = mTilesetData->getTexture();
+        if (!mCollected && texture)
         {
             // Calculate screen position with zoom
             float screenX = std::floor((mX - offsetX) * zoom);
@@ -38,12 +38,12 @@ namespace zuul
             int srcX = (currentTileId % tilesetInfo.columns) * mWidth;
             int srcY = (currentTileId / tilesetInfo.columns) * mHeight;
 
-            // Render the item
-            renderer->renderTexture(mTexture,
-                                    srcX, srcY, mWidth, mHeight,
-                                    static_cast<int>(screenX),
-                                    static_cast<int>(screenY),
-                                    destW, destH);
+            // Items are sorted by their bottom edge, like the player
+            queue.push(layer, static_cast<int32_t>(mY + mHeight), texture,
+                       srcX, srcY, mWidth, mHeight,
+                       static_cast<int>(screenX),
+                       static_cast<int>(screenY),
+                       destW, destH);
         }
     }
 
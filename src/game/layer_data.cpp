@@ -0,0 +1,236 @@
+#include "game/layer_data.hpp"
+#include "engine/log.hpp"
+#include <zlib.h>
+#include <array>
+#include <bit>
+
+#if defined(ZUUL_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+// The SSSE3 decoder is built whatever the -m flags and picked at runtime
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define ZUUL_BASE64_SSSE3
+#endif
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int8_t BASE64_INVALID = -1;
+        constexpr int8_t BASE64_SPACE = -2;
+        constexpr int8_t BASE64_PAD = -3;
+
+        constexpr std::array<int8_t, 256> makeBase64Table()
+        {
+            std::array<int8_t, 256> table{};
+            table.fill(BASE64_INVALID);
+            const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 64; ++i)
+            {
+                table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+            }
+            table[' '] = table['\n'] = table['\r'] = table['\t'] = BASE64_SPACE;
+            table['='] = BASE64_PAD;
+            return table;
+        }
+
+        constexpr std::array<int8_t, 256> BASE64_TABLE = makeBase64Table();
+
+#if defined(ZUUL_BASE64_SSSE3)
+        // Decodes 16 characters into 12 bytes, written as a 16 byte store. Returns false
+        // without writing if any character is outside the alphabet (whitespace, padding).
+        // Classifies characters by their nibbles with pshufb lookups, as in Muła and Lemire,
+        // "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+        __attribute__((target("ssse3"))) inline bool decodeBlock16(const char *in, uint8_t *out)
+        {
+            const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                                  0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i mask2F = _mm_set1_epi8(0x2F);
+
+            __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+            __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), mask2F);
+            __m128i loNibbles = _mm_and_si128(chars, mask2F);
+            __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+            __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+            {
+                return false;
+            }
+
+            // Map characters to their 6 bit values: '/' is the one character needing its own offset
+            __m128i eq2F = _mm_cmpeq_epi8(chars, mask2F);
+            __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+            __m128i values = _mm_add_epi8(chars, roll);
+
+            // Pack 4 x 6 bits into 3 bytes per group
+            __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i packed = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+            return true;
+        }
+
+        // Decodes blocks from the start of text while they are unpadded runs of the
+        // alphabet. Returns the characters consumed; written is advanced by the bytes.
+        __attribute__((target("ssse3"))) size_t decodeBlocks16(std::string_view text, uint8_t *out, size_t capacity, size_t &written)
+        {
+            size_t pos = 0;
+            while (pos + 16 <= text.size() && written + 16 <= capacity && decodeBlock16(text.data() + pos, out + written))
+            {
+                pos += 16;
+                written += 12;
+            }
+            return pos;
+        }
+
+        bool hasSsse3()
+        {
+#if defined(__SSSE3__)
+            return true;
+#else
+            static const bool supported = __builtin_cpu_supports("ssse3");
+            return supported;
+#endif
+        }
+#endif
+
+        bool inflateData(const std::vector<uint8_t> &compressed, bool gzip, uint8_t *out, size_t size)
+        {
+            z_stream stream{};
+            stream.next_in = const_cast<Bytef *>(compressed.data());
+            stream.avail_in = static_cast<uInt>(compressed.size());
+            stream.next_out = out;
+            stream.avail_out = static_cast<uInt>(size);
+
+            if (inflateInit2(&stream, gzip ? MAX_WBITS + 16 : MAX_WBITS) != Z_OK)
+            {
+                return false;
+            }
+            int result = inflate(&stream, Z_FINISH);
+            inflateEnd(&stream);
+            return result == Z_STREAM_END && stream.total_out == size;
+        }
+    }
+
+    size_t decodeBase64(std::string_view text, uint8_t *out, size_t capacity)
+    {
+        size_t pos = 0;
+        size_t written = 0;
+
+#if defined(ZUUL_BASE64_SSSE3)
+        // Unpadded runs of the alphabet take the vector path; anything else falls through
+        if (hasSsse3())
+        {
+            pos = decodeBlocks16(text, out, capacity, written);
+        }
+#endif
+
+        uint32_t accumulator = 0;
+        int bits = 0;
+        bool padding = false;
+        for (; pos < text.size(); ++pos)
+        {
+            int8_t value = BASE64_TABLE[static_cast<uint8_t>(text[pos])];
+            if (value == BASE64_SPACE)
+            {
+                continue;
+            }
+            if (value == BASE64_PAD)
+            {
+                padding = true;
+                continue;
+            }
+            if (value == BASE64_INVALID || padding)
+            {
+                return BASE64_ERROR;
+            }
+
+            accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8)
+            {
+                if (written >= capacity)
+                {
+                    return BASE64_ERROR;
+                }
+                bits -= 8;
+                out[written++] = static_cast<uint8_t>(accumulator >> bits);
+                accumulator &= (1u << bits) - 1;
+            }
+        }
+        return written;
+    }
+
+    bool decodeLayerData(std::string_view text, const std::string &compression,
+                         size_t cellCount, std::vector<uint32_t> &gids)
+    {
+        const size_t size = cellCount * sizeof(uint32_t);
+        gids.resize(cellCount);
+        uint8_t *out = reinterpret_cast<uint8_t *>(gids.data());
+
+        if (compression.empty())
+        {
+            // Uncompressed data is decoded straight into the gid buffer
+            if (decodeBase64(text, out, size) != size)
+            {
+                ZUUL_LOG_ERROR(Assets, "Invalid base64 layer data");
+                return false;
+            }
+        }
+        else
+        {
+            std::vector<uint8_t> compressed(text.size() / 4 * 3 + 3);
+            size_t compressedSize = decodeBase64(text, compressed.data(), compressed.size());
+            if (compressedSize == BASE64_ERROR)
+            {
+                ZUUL_LOG_ERROR(Assets, "Invalid base64 layer data");
+                return false;
+            }
+            compressed.resize(compressedSize);
+
+            bool decompressed = false;
+            if (compression == "zlib" || compression == "gzip")
+            {
+                decompressed = inflateData(compressed, compression == "gzip", out, size);
+            }
+            else if (compression == "zstd")
+            {
+#if defined(ZUUL_HAVE_ZSTD)
+                size_t result = ZSTD_decompress(out, size, compressed.data(), compressed.size());
+                decompressed = !ZSTD_isError(result) && result == size;
+#else
+                ZUUL_LOG_ERROR(Assets, "Layer data uses zstd, but zuul was built without zstd support");
+                return false;
+#endif
+            }
+            else
+            {
+                ZUUL_LOG_ERROR(Assets, "Unsupported layer compression: {}", compression);
+                return false;
+            }
+
+            if (!decompressed)
+            {
+                ZUUL_LOG_ERROR(Assets, "Failed to decompress {} layer data", compression);
+                return false;
+            }
+        }
+
+        // Tiled stores gids little endian
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            for (uint32_t &gid : gids)
+            {
+                gid = std::byteswap(gid);
+            }
+        }
+        return true;
+    }
+
+} // namespace zuul
@@ -0,0 +1,372 @@
+#include "game/map_lod.hpp"
+#include "engine/frame_arena.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+
+namespace zuul
+{
+    namespace
+    {
+        // Source-over blend of straight alpha ARGB pixels
+        inline uint32_t blendOver(uint32_t dst, uint32_t src)
+        {
+            uint32_t srcA = src >> 24;
+            if (srcA == 255)
+            {
+                return src;
+            }
+            if (srcA == 0)
+            {
+                return dst;
+            }
+
+            uint32_t dstA = (dst >> 24) * (255 - srcA) / 255;
+            uint32_t outA = srcA + dstA;
+            uint32_t out = outA << 24;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                uint32_t channel = (((src >> shift) & 0xFF) * srcA + ((dst >> shift) & 0xFF) * dstA) / outA;
+                out |= channel << shift;
+            }
+            return out;
+        }
+
+        // Halves an image with a 2x2 box filter weighted by alpha, so transparent
+        // pixels don't darken the edges of tiles
+        std::vector<uint32_t> downsample(const std::vector<uint32_t> &pixels, int width, int height)
+        {
+            const int halfWidth = width / 2;
+            const int halfHeight = height / 2;
+            std::vector<uint32_t> half(static_cast<size_t>(halfWidth) * halfHeight);
+            for (int y = 0; y < halfHeight; ++y)
+            {
+                const uint32_t *row0 = &pixels[static_cast<size_t>(y * 2) * width];
+                const uint32_t *row1 = row0 + width;
+                for (int x = 0; x < halfWidth; ++x)
+                {
+                    const uint32_t quad[4] = {row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1]};
+                    uint32_t alpha = 0;
+                    uint32_t sums[3] = {0, 0, 0};
+                    for (uint32_t pixel : quad)
+                    {
+                        uint32_t a = pixel >> 24;
+                        alpha += a;
+                        sums[0] += (pixel & 0xFF) * a;
+                        sums[1] += ((pixel >> 8) & 0xFF) * a;
+                        sums[2] += ((pixel >> 16) & 0xFF) * a;
+                    }
+
+                    uint32_t out = 0;
+                    if (alpha > 0)
+                    {
+                        out = ((alpha + 2) / 4) << 24 | (sums[2] / alpha) << 16 | (sums[1] / alpha) << 8 | sums[0] / alpha;
+                    }
+                    half[static_cast<size_t>(y) * halfWidth + x] = out;
+                }
+            }
+            return half;
+        }
+    }
+
+    MapLod::MapLod(TileMap &map, MapLodWorker &worker)
+        : mMap(map),
+          mWorker(worker),
+          mClient(worker.addClient()),
+          mAlive(std::make_shared<bool>(true)),
+          mContentGeneration(map.getContentGeneration())
+    {
+        std::weak_ptr<bool> alive = mAlive;
+        mMap.addTileChangeCallback([this, alive](std::span<const TileChange> changes)
+                                   {
+            if (alive.lock())
+            {
+                onTilesChanged(changes);
+            } });
+    }
+
+    MapLod::~MapLod()
+    {
+        mWorker.removeClient(mClient);
+    }
+
+    int MapLod::levelForZoom(float zoom)
+    {
+        // The coarsest level that still has at least one texel per screen pixel
+        if (zoom >= 1.0f)
+        {
+            return 0;
+        }
+        if (zoom <= 0.0f)
+        {
+            return LEVEL_COUNT;
+        }
+        return std::min(LEVEL_COUNT, static_cast<int>(std::floor(std::log2(1.0f / zoom))));
+    }
+
+    void MapLod::onTilesChanged(std::span<const TileChange> changes)
+    {
+        for (const auto &change : changes)
+        {
+            auto it = mChunks.find(keyOf(change.x >> 4, change.y >> 4));
+            if (it != mChunks.end())
+            {
+                it->second.generation++;
+                it->second.requested = false;
+            }
+        }
+    }
+
+    void MapLod::update(AssetRegistry &assets, int maxUploads)
+    {
+        // Reloaded tilesets change every chunk
+        if (mMap.getContentGeneration() != mContentGeneration)
+        {
+            mContentGeneration = mMap.getContentGeneration();
+            for (auto &[key, images] : mChunks)
+            {
+                images.generation++;
+                images.requested = false;
+            }
+        }
+
+        // Only the results of this call; the vector lives in the frame arena
+        std::pmr::vector<Result> results(&getFrameArena());
+        mWorker.takeResults(mClient, static_cast<size_t>(std::max(0, maxUploads)), results);
+
+        for (const auto &result : results)
+        {
+            auto it = mChunks.find(keyOf(result.chunkX, result.chunkY));
+            if (it == mChunks.end() || it->second.generation != result.generation)
+            {
+                continue;
+            }
+
+            it->second.width = result.width;
+            it->second.height = result.height;
+            for (int level = 0; level < LEVEL_COUNT; ++level)
+            {
+                int width = result.width >> level;
+                int height = result.height >> level;
+                if (width > 0 && height > 0)
+                {
+                    it->second.levels[level] = assets.createTexture(width, height, result.levels[level].data());
+                }
+            }
+        }
+    }
+
+    void MapLod::queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom,
+                       int viewWidth, int viewHeight, int level)
+    {
+        level = std::clamp(level, 1, LEVEL_COUNT);
+        const int chunkWidth = TileGrid::CHUNK_SIZE * mMap.getTileWidth();
+        const int chunkHeight = TileGrid::CHUNK_SIZE * mMap.getTileHeight();
+        if (chunkWidth <= 0 || chunkHeight <= 0)
+        {
+            return;
+        }
+
+        // Visible tile range, clamped to the map like TileMap::queueTiles
+        int startTileX = std::max(0, static_cast<int>(std::floor(offsetX / mMap.getTileWidth())));
+        int startTileY = std::max(0, static_cast<int>(std::floor(offsetY / mMap.getTileHeight())));
+        int endTileX = std::min(mMap.getWidth(), static_cast<int>((offsetX + viewWidth / zoom) / mMap.getTileWidth()) + 1);
+        int endTileY = std::min(mMap.getHeight(), static_cast<int>((offsetY + viewHeight / zoom) / mMap.getTileHeight()) + 1);
+
+        mMap.getTileGrid().forEachChunk(startTileX, startTileY, endTileX, endTileY, [&](const TileGrid::Chunk &chunk)
+        {
+            ChunkImages &images = mChunks[keyOf(chunk.chunkX, chunk.chunkY)];
+            if (!images.requested)
+            {
+                request(chunk, images);
+            }
+
+            // Fall back to another level of the chunk while the wanted one is missing
+            int drawn = level - 1;
+            for (int other = 0; !images.levels[drawn] && other < LEVEL_COUNT; ++other)
+            {
+                drawn = other;
+            }
+            if (!images.levels[drawn])
+            {
+                return;
+            }
+
+            // Chunks share their screen edges like tiles do
+            int worldX = chunk.chunkX * chunkWidth;
+            int worldY = chunk.chunkY * chunkHeight;
+            int destX = static_cast<int>(std::floor((worldX - offsetX) * zoom));
+            int destY = static_cast<int>(std::floor((worldY - offsetY) * zoom));
+            int destW = static_cast<int>(std::floor((worldX + chunkWidth - offsetX) * zoom)) - destX;
+            int destH = static_cast<int>(std::floor((worldY + chunkHeight - offsetY) * zoom)) - destY;
+            queue.push(layer, 0, images.levels[drawn].get(), 0, 0, images.width >> drawn, images.height >> drawn,
+                       destX, destY, destW, destH);
+        });
+    }
+
+    void MapLod::request(const TileGrid::Chunk &chunk, ChunkImages &images)
+    {
+        images.requested = true;
+
+        Job job{chunk.chunkX, chunk.chunkY, images.generation, mMap.getTileWidth(), mMap.getTileHeight(), {}, {}};
+        for (const auto &tileset : mMap.getTilesets())
+        {
+            job.tilesets.push_back({tileset.data->getImage(), tileset.columns, tileset.tileWidth, tileset.tileHeight});
+        }
+
+        // Animated tiles are drawn with their first frame
+        const TileGrid &grid = mMap.getTileGrid();
+        const auto &layers = mMap.getLayers();
+        for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex)
+        {
+            if (!layers[layerIndex].visible)
+            {
+                continue;
+            }
+            for (int cell = 0; cell < TileGrid::CHUNK_CELLS; ++cell)
+            {
+                int localId = 0;
+                const MapTileset *tileset = mMap.resolveTile(grid.getTile(chunk, static_cast<int>(layerIndex), cell), localId);
+                if (tileset)
+                {
+                    job.tiles.push_back({static_cast<uint16_t>(tileset - mMap.getTilesets().data()),
+                                         static_cast<uint16_t>(localId), static_cast<uint16_t>(cell)});
+                }
+            }
+        }
+
+        mWorker.push(mClient, std::move(job));
+    }
+
+    MapLod::Result MapLod::generate(const Job &job)
+    {
+        // Composite the chunk at full size, then halve it once per level
+        const int width = TileGrid::CHUNK_SIZE * job.tileWidth;
+        const int height = TileGrid::CHUNK_SIZE * job.tileHeight;
+        std::vector<uint32_t> pixels(static_cast<size_t>(width) * height, 0);
+
+        for (const auto &tile : job.tiles)
+        {
+            const JobTileset &tileset = job.tilesets[tile.tileset];
+            if (!tileset.image || tileset.columns <= 0)
+            {
+                continue;
+            }
+            const TilesetImage &image = *tileset.image;
+
+            int srcX = (tile.localId % tileset.columns) * tileset.tileWidth;
+            int srcY = (tile.localId / tileset.columns) * tileset.tileHeight;
+
+            // Larger tiles are anchored at the bottom left of their cell and cut off at the chunk edge
+            int destX = (tile.cell % TileGrid::CHUNK_SIZE) * job.tileWidth;
+            int destY = (tile.cell / TileGrid::CHUNK_SIZE + 1) * job.tileHeight - tileset.tileHeight;
+
+            int rows = std::min({tileset.tileHeight, image.height - srcY, height - destY});
+            int columns = std::min({tileset.tileWidth, image.width - srcX, width - destX});
+            for (int y = std::max(0, -destY); y < rows; ++y)
+            {
+                const uint32_t *src = &image.pixels[static_cast<size_t>(srcY + y) * image.width + srcX];
+                uint32_t *dest = &pixels[static_cast<size_t>(destY + y) * width + destX];
+                for (int x = 0; x < columns; ++x)
+                {
+                    dest[x] = blendOver(dest[x], src[x]);
+                }
+            }
+        }
+
+        Result result{job.chunkX, job.chunkY, job.generation, {}, width / 2, height / 2};
+        result.levels[0] = downsample(pixels, width, height);
+        for (int level = 1; level < LEVEL_COUNT; ++level)
+        {
+            result.levels[level] = downsample(result.levels[level - 1], width >> level, height >> level);
+        }
+        return result;
+    }
+
+    MapLodWorker::~MapLodWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShuttingDown = true;
+        }
+        mJobAvailable.notify_all();
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+    uint32_t MapLodWorker::addClient()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mThread.joinable())
+        {
+            mThread = std::thread(&MapLodWorker::workerLoop, this);
+        }
+        uint32_t client = mNextClient++;
+        mResults[client];
+        return client;
+    }
+
+    void MapLodWorker::removeClient(uint32_t client)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::erase_if(mJobs, [client](const QueuedJob &queued)
+                      { return queued.client == client; });
+        mResults.erase(client);
+    }
+
+    void MapLodWorker::push(uint32_t client, MapLod::Job &&job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back({client, std::move(job)});
+        }
+        mJobAvailable.notify_one();
+    }
+
+    void MapLodWorker::takeResults(uint32_t client, size_t maxResults, std::pmr::vector<MapLod::Result> &results)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mResults.find(client);
+        if (it == mResults.end())
+        {
+            return;
+        }
+
+        std::vector<MapLod::Result> &finished = it->second;
+        size_t count = std::min(finished.size(), maxResults);
+        results.assign(std::make_move_iterator(finished.begin()), std::make_move_iterator(finished.begin() + count));
+        finished.erase(finished.begin(), finished.begin() + count);
+    }
+
+    void MapLodWorker::workerLoop()
+    {
+        while (true)
+        {
+            QueuedJob queued;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobAvailable.wait(lock, [this]
+                                   { return mShuttingDown || !mJobs.empty(); });
+                if (mShuttingDown)
+                {
+                    return;
+                }
+                queued = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+
+            MapLod::Result result = MapLod::generate(queued.job);
+
+            // The client may have gone while the job ran
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mResults.find(queued.client);
+            if (it != mResults.end())
+            {
+                it->second.push_back(std::move(result));
+            }
+        }
+    }
+
+} // namespace zuul
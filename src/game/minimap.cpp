@@ -0,0 +1,47 @@
+#include <game/minimap.hpp>
+#include <engine/alloc_tracker.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace zuul
+{
+
+    Minimap::Minimap(int width, int height, int margin)
+        : mWidth(width), mHeight(height), mMargin(margin)
+    {
+    }
+
+    void Minimap::render(Renderer &renderer, World &world, float playerX, float playerY, int windowWidth)
+    {
+        ZUUL_ALLOC_ZONE("Minimap::render");
+        const int worldWidth = world.getMaxX() - world.getMinX();
+        const int worldHeight = world.getMaxY() - world.getMinY();
+        if (worldWidth <= 0 || worldHeight <= 0)
+        {
+            return;
+        }
+
+        // Fit the world into the minimap, keeping its aspect ratio
+        float zoom = std::min(static_cast<float>(mWidth) / worldWidth, static_cast<float>(mHeight) / worldHeight);
+        int drawWidth = static_cast<int>(std::ceil(worldWidth * zoom));
+        int drawHeight = static_cast<int>(std::ceil(worldHeight * zoom));
+        int left = windowWidth - mMargin - drawWidth;
+        int top = mMargin;
+
+        // The world is queued as if the screen started at the minimap's world origin
+        float offsetX = world.getMinX() - left / zoom;
+        float offsetY = world.getMinY() - top / zoom;
+
+        mDrawQueue.clear();
+        world.queue(mDrawQueue, offsetX, offsetY, zoom, left + drawWidth, top + drawHeight);
+        mDrawQueue.sort();
+        mDrawQueue.submit(renderer);
+
+        renderer.renderRect(left - 1, top - 1, drawWidth + 2, drawHeight + 2, 255, 255, 255, 255);
+
+        int markerX = static_cast<int>((playerX - offsetX) * zoom);
+        int markerY = static_cast<int>((playerY - offsetY) * zoom);
+        renderer.renderRect(markerX - 1, markerY - 1, 3, 3, 255, 0, 0, 255);
+    }
+
+} // namespace zuul
@@ -0,0 +1,512 @@
+#include <game/nav_grid.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int CLUSTER_SIZE = TileGrid::CHUNK_SIZE;
+        constexpr size_t MAX_CACHED_PATHS = 256;
+        constexpr size_t MAX_FLOW_FIELDS = 16;
+        constexpr float DIAGONAL_COST = 1.41421356f;
+        constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+        // Straight neighbours first, then diagonals; each direction is followed by its opposite
+        constexpr int DIRECTION_X[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+        constexpr int DIRECTION_Y[8] = {0, 0, 1, -1, 1, -1, -1, 1};
+
+        float octile(int dx, int dy)
+        {
+            dx = std::abs(dx);
+            dy = std::abs(dy);
+            return static_cast<float>(std::max(dx, dy)) + (DIAGONAL_COST - 1.0f) * static_cast<float>(std::min(dx, dy));
+        }
+
+        int sign(int value)
+        {
+            return (value > 0) - (value < 0);
+        }
+
+        using OpenEntry = NavOpenEntry;
+        using OpenList = std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>>;
+    }
+
+    FlowField::FlowField(int width, int height, NavCell goal)
+        : mWidth(width), mHeight(height), mGoal(goal),
+          mDistance(static_cast<size_t>(width) * height, UNREACHABLE),
+          mDirection(static_cast<size_t>(width) * height, -1)
+    {
+    }
+
+    bool FlowField::getDirection(int x, int y, int &dx, int &dy) const
+    {
+        if (x < 0 || y < 0 || x >= mWidth || y >= mHeight)
+        {
+            return false;
+        }
+
+        int8_t direction = mDirection[static_cast<size_t>(y) * mWidth + x];
+        if (direction < 0)
+        {
+            return false;
+        }
+        dx = DIRECTION_X[direction];
+        dy = DIRECTION_Y[direction];
+        return true;
+    }
+
+    float FlowField::getDistance(int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= mWidth || y >= mHeight)
+        {
+            return UNREACHABLE;
+        }
+        return mDistance[static_cast<size_t>(y) * mWidth + x];
+    }
+
+    NavGrid::NavGrid(TileMap &map)
+        : mMap(map),
+          mAlive(std::make_shared<bool>(true)),
+          mWidth(0), mHeight(0),
+          mMapGeneration(0),
+          mGeneration(0),
+          mClustersX(0),
+          mCachedPaths(0)
+    {
+        std::weak_ptr<bool> alive = mAlive;
+        mMap.addTileChangeCallback([this, alive](std::span<const TileChange> changes)
+                                   {
+            if (alive.lock())
+            {
+                onTilesChanged(changes);
+            } });
+        rebuild();
+    }
+
+    uint32_t NavGrid::getClusterGeneration(int clusterX, int clusterY) const
+    {
+        return mClusterGenerations[static_cast<size_t>(clusterY) * mClustersX + clusterX];
+    }
+
+    void NavGrid::update()
+    {
+        if (mMap.getContentGeneration() != mMapGeneration)
+        {
+            rebuild();
+            return;
+        }
+        if (mPendingChunks.empty())
+        {
+            return;
+        }
+
+        // Edits arrive per tile; colliders may reach past their tile, so the whole
+        // chunk around each edit is re-read
+        bool changed = false;
+        for (uint64_t chunk : mPendingChunks)
+        {
+            int minX = static_cast<int32_t>(chunk >> 32) * CLUSTER_SIZE - 1;
+            int minY = static_cast<int32_t>(chunk & 0xFFFFFFFFu) * CLUSTER_SIZE - 1;
+            changed |= updateArea(minX, minY, minX + CLUSTER_SIZE + 2, minY + CLUSTER_SIZE + 2);
+        }
+        mPendingChunks.clear();
+
+        if (changed)
+        {
+            invalidate();
+        }
+    }
+
+    void NavGrid::rebuild()
+    {
+        mMapGeneration = mMap.getContentGeneration();
+        mWidth = mMap.getWidth();
+        mHeight = mMap.getHeight();
+        mWalkable.assign(static_cast<size_t>(mWidth) * mHeight, 0);
+        mClustersX = (mWidth + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        int clustersY = (mHeight + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+        // Keep counting up, so cluster data cached by a NavWorld never matches by accident
+        uint32_t clusterGeneration = 1;
+        for (uint32_t generation : mClusterGenerations)
+        {
+            clusterGeneration = std::max(clusterGeneration, generation + 1);
+        }
+        mClusterGenerations.assign(static_cast<size_t>(mClustersX) * clustersY, clusterGeneration);
+        mPendingChunks.clear();
+        updateArea(0, 0, mWidth, mHeight);
+        invalidate();
+    }
+
+    void NavGrid::onTilesChanged(std::span<const TileChange> changes)
+    {
+        // Read by the next query, once the map has merged its colliders again
+        for (const auto &change : changes)
+        {
+            mPendingChunks.insert(keyOf({change.x >> 4, change.y >> 4}));
+        }
+    }
+
+    bool NavGrid::updateArea(int minX, int minY, int maxX, int maxY)
+    {
+        const CollisionWorld &collision = mMap.getCollisionWorld();
+        const float tileWidth = static_cast<float>(mMap.getTileWidth());
+        const float tileHeight = static_cast<float>(mMap.getTileHeight());
+
+        bool changed = false;
+        for (int y = std::max(0, minY); y < std::min(mHeight, maxY); ++y)
+        {
+            for (int x = std::max(0, minX); x < std::min(mWidth, maxX); ++x)
+            {
+                uint8_t walkable = !collision.overlaps({x * tileWidth, y * tileHeight, tileWidth, tileHeight});
+                uint8_t &cell = mWalkable[static_cast<size_t>(y) * mWidth + x];
+                if (cell != walkable)
+                {
+                    cell = walkable;
+                    mClusterGenerations[static_cast<size_t>(y / CLUSTER_SIZE) * mClustersX + x / CLUSTER_SIZE]++;
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+
+    void NavGrid::invalidate()
+    {
+        mGeneration++;
+        mPathCache.clear();
+        mFlowFields.clear();
+        mCachedPaths = 0;
+    }
+
+    bool NavGrid::canStep(int x, int y, int dx, int dy) const
+    {
+        // Diagonal steps need both straight neighbours free, so paths never clip corners
+        return isWalkable(x + dx, y + dy) && (dx == 0 || dy == 0 || (isWalkable(x + dx, y) && isWalkable(x, y + dy)));
+    }
+
+    bool NavGrid::jump(int x, int y, int dx, int dy, NavCell goal, NavCell &jumpPoint) const
+    {
+        // Follows one direction until a tile is found where the path could turn
+        // (Harabor and Grastien's jump point search, for moves that never cut corners)
+        while (true)
+        {
+            if (!canStep(x, y, dx, dy))
+            {
+                return false;
+            }
+            x += dx;
+            y += dy;
+
+            if (x == goal.x && y == goal.y)
+            {
+                jumpPoint = {x, y};
+                return true;
+            }
+
+            NavCell ignored;
+            if (dx != 0 && dy != 0)
+            {
+                // Diagonal moves stop where a straight move from here finds a jump point
+                if (jump(x, y, dx, 0, goal, ignored) || jump(x, y, 0, dy, goal, ignored))
+                {
+                    jumpPoint = {x, y};
+                    return true;
+                }
+            }
+            else if (dx != 0)
+            {
+                if ((isWalkable(x, y - 1) && !isWalkable(x - dx, y - 1)) ||
+                    (isWalkable(x, y + 1) && !isWalkable(x - dx, y + 1)))
+                {
+                    jumpPoint = {x, y};
+                    return true;
+                }
+            }
+            else if ((isWalkable(x - 1, y) && !isWalkable(x - 1, y - dy)) ||
+                     (isWalkable(x + 1, y) && !isWalkable(x + 1, y - dy)))
+            {
+                jumpPoint = {x, y};
+                return true;
+            }
+        }
+    }
+
+    void NavGrid::findSuccessors(NavCell cell, NavCell parent, bool hasParent, std::vector<NavCell> &directions) const
+    {
+        directions.clear();
+        if (!hasParent)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                directions.push_back({DIRECTION_X[i], DIRECTION_Y[i]});
+            }
+            return;
+        }
+
+        // Only the natural and forced neighbours of the direction of travel
+        int dx = sign(cell.x - parent.x);
+        int dy = sign(cell.y - parent.y);
+        if (dx != 0 && dy != 0)
+        {
+            directions.push_back({dx, 0});
+            directions.push_back({0, dy});
+            directions.push_back({dx, dy});
+        }
+        else if (dx != 0)
+        {
+            directions.push_back({dx, 0});
+            directions.push_back({dx, 1});
+            directions.push_back({dx, -1});
+            directions.push_back({0, 1});
+            directions.push_back({0, -1});
+        }
+        else
+        {
+            directions.push_back({0, dy});
+            directions.push_back({1, dy});
+            directions.push_back({-1, dy});
+            directions.push_back({1, 0});
+            directions.push_back({-1, 0});
+        }
+    }
+
+    bool NavGrid::findPath(NavCell start, NavCell goal, std::vector<NavCell> &path)
+    {
+        update();
+        path.clear();
+        if (!isWalkable(start.x, start.y) || !isWalkable(goal.x, goal.y))
+        {
+            return false;
+        }
+
+        auto &cachedForGoal = mPathCache[keyOf(goal)];
+        auto cached = cachedForGoal.find(keyOf(start));
+        if (cached != cachedForGoal.end())
+        {
+            path = cached->second;
+            return !path.empty();
+        }
+
+        // Nodes from earlier searches are stale once the stamp moves on
+        const size_t cellCount = static_cast<size_t>(mWidth) * mHeight;
+        if (mSearchNodes.size() != cellCount || ++mSearchStamp == 0)
+        {
+            mSearchNodes.assign(cellCount, {UNREACHABLE, -1, 0});
+            mSearchStamp = 1;
+        }
+        auto node = [this](int index) -> SearchNode &
+        {
+            SearchNode &searchNode = mSearchNodes[index];
+            if (searchNode.stamp != mSearchStamp)
+            {
+                searchNode = {UNREACHABLE, -1, mSearchStamp};
+            }
+            return searchNode;
+        };
+
+        std::vector<NavOpenEntry> &open = mOpenScratch;
+        std::vector<NavCell> &directions = mDirectionScratch;
+        open.clear();
+        const std::greater<NavOpenEntry> order;
+
+        auto indexOf = [this](NavCell cell) { return cell.y * mWidth + cell.x; };
+        auto cellOf = [this](int index) { return NavCell{index % mWidth, index / mWidth}; };
+
+        node(indexOf(start)).cost = 0.0f;
+        open.push_back({octile(goal.x - start.x, goal.y - start.y), 0.0f, indexOf(start)});
+        bool found = false;
+        while (!open.empty())
+        {
+            std::pop_heap(open.begin(), open.end(), order);
+            OpenEntry entry = open.back();
+            open.pop_back();
+            if (entry.cost > node(entry.cell).cost)
+            {
+                continue;
+            }
+
+            NavCell cell = cellOf(entry.cell);
+            if (cell == goal)
+            {
+                found = true;
+                break;
+            }
+
+            int parent = node(entry.cell).parent;
+            findSuccessors(cell, parent >= 0 ? cellOf(parent) : cell, parent >= 0, directions);
+            for (const NavCell &direction : directions)
+            {
+                NavCell jumpPoint;
+                if (!jump(cell.x, cell.y, direction.x, direction.y, goal, jumpPoint))
+                {
+                    continue;
+                }
+
+                float cost = entry.cost + octile(jumpPoint.x - cell.x, jumpPoint.y - cell.y);
+                SearchNode &next = node(indexOf(jumpPoint));
+                if (cost < next.cost)
+                {
+                    next.cost = cost;
+                    next.parent = entry.cell;
+                    open.push_back({cost + octile(goal.x - jumpPoint.x, goal.y - jumpPoint.y), cost, indexOf(jumpPoint)});
+                    std::push_heap(open.begin(), open.end(), order);
+                }
+            }
+        }
+
+        // Jump points are joined by straight or diagonal runs; fill in every tile
+        if (found)
+        {
+            std::vector<NavCell> &jumpPoints = mJumpPointScratch;
+            jumpPoints.clear();
+            for (int index = indexOf(goal); index >= 0; index = mSearchNodes[index].parent)
+            {
+                jumpPoints.push_back(cellOf(index));
+            }
+            std::reverse(jumpPoints.begin(), jumpPoints.end());
+
+            path.push_back(start);
+            for (size_t i = 1; i < jumpPoints.size(); ++i)
+            {
+                NavCell from = jumpPoints[i - 1];
+                NavCell to = jumpPoints[i];
+                int dx = sign(to.x - from.x);
+                int dy = sign(to.y - from.y);
+                while (!(from == to))
+                {
+                    from.x += dx;
+                    from.y += dy;
+                    path.push_back(from);
+                }
+            }
+        }
+
+        // Failed searches are cached too, they are the most expensive ones
+        if (mCachedPaths >= MAX_CACHED_PATHS)
+        {
+            mPathCache.clear();
+            mCachedPaths = 0;
+        }
+        mPathCache[keyOf(goal)][keyOf(start)] = path;
+        mCachedPaths++;
+        return found;
+    }
+
+    float NavGrid::findCost(NavCell start, NavCell goal, int minX, int minY, int maxX, int maxY) const
+    {
+        minX = std::max(minX, 0);
+        minY = std::max(minY, 0);
+        maxX = std::min(maxX, mWidth);
+        maxY = std::min(maxY, mHeight);
+        auto inside = [&](int x, int y) { return x >= minX && y >= minY && x < maxX && y < maxY; };
+        if (!inside(start.x, start.y) || !inside(goal.x, goal.y) ||
+            !isWalkable(start.x, start.y) || !isWalkable(goal.x, goal.y))
+        {
+            return -1.0f;
+        }
+
+        const int areaWidth = maxX - minX;
+        std::vector<float> costs(static_cast<size_t>(areaWidth) * (maxY - minY), UNREACHABLE);
+        auto indexOf = [&](int x, int y) { return (y - minY) * areaWidth + (x - minX); };
+
+        OpenList open;
+        costs[indexOf(start.x, start.y)] = 0.0f;
+        open.push({octile(goal.x - start.x, goal.y - start.y), 0.0f, indexOf(start.x, start.y)});
+        while (!open.empty())
+        {
+            OpenEntry entry = open.top();
+            open.pop();
+            if (entry.cost > costs[entry.cell])
+            {
+                continue;
+            }
+
+            int x = minX + entry.cell % areaWidth;
+            int y = minY + entry.cell / areaWidth;
+            if (x == goal.x && y == goal.y)
+            {
+                return entry.cost;
+            }
+
+            for (int i = 0; i < 8; ++i)
+            {
+                int nextX = x + DIRECTION_X[i];
+                int nextY = y + DIRECTION_Y[i];
+                if (!inside(nextX, nextY) || !canStep(x, y, DIRECTION_X[i], DIRECTION_Y[i]))
+                {
+                    continue;
+                }
+
+                float cost = entry.cost + (i < 4 ? 1.0f : DIAGONAL_COST);
+                int index = indexOf(nextX, nextY);
+                if (cost < costs[index])
+                {
+                    costs[index] = cost;
+                    open.push({cost + octile(goal.x - nextX, goal.y - nextY), cost, index});
+                }
+            }
+        }
+        return -1.0f;
+    }
+
+    std::shared_ptr<const FlowField> NavGrid::getFlowField(NavCell goal)
+    {
+        update();
+        auto cached = mFlowFields.find(keyOf(goal));
+        if (cached != mFlowFields.end())
+        {
+            return cached->second;
+        }
+
+        // Dijkstra outwards from the goal; every reached cell points back along the way it was reached
+        auto field = std::make_shared<FlowField>(mWidth, mHeight, goal);
+        if (isWalkable(goal.x, goal.y))
+        {
+            OpenList open;
+            field->mDistance[static_cast<size_t>(goal.y) * mWidth + goal.x] = 0.0f;
+            open.push({0.0f, 0.0f, goal.y * mWidth + goal.x});
+            while (!open.empty())
+            {
+                OpenEntry entry = open.top();
+                open.pop();
+                if (entry.cost > field->mDistance[entry.cell])
+                {
+                    continue;
+                }
+
+                int x = entry.cell % mWidth;
+                int y = entry.cell / mWidth;
+                for (int i = 0; i < 8; ++i)
+                {
+                    // Moves are symmetric, so stepping from the neighbour to here is allowed too
+                    if (!canStep(x, y, DIRECTION_X[i], DIRECTION_Y[i]))
+                    {
+                        continue;
+                    }
+
+                    int index = (y + DIRECTION_Y[i]) * mWidth + x + DIRECTION_X[i];
+                    float cost = entry.cost + (i < 4 ? 1.0f : DIAGONAL_COST);
+                    if (cost < field->mDistance[index])
+                    {
+                        field->mDistance[index] = cost;
+                        field->mDirection[index] = static_cast<int8_t>(i ^ 1); // The opposite direction
+                        open.push({cost, cost, index});
+                    }
+                }
+            }
+        }
+
+        if (mFlowFields.size() >= MAX_FLOW_FIELDS)
+        {
+            mFlowFields.clear();
+        }
+        mFlowFields[keyOf(goal)] = field;
+        return field;
+    }
+
+} // namespace zuul
@@ -0,0 +1,489 @@
+#include <game/nav_world.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace zuul
+{
+    namespace
+    {
+        constexpr int CLUSTER_SIZE = TileGrid::CHUNK_SIZE;
+        // Border runs at least this long get an entrance at each end instead of one in the middle
+        constexpr int LONG_ENTRANCE = 6;
+        // Paths within one map shorter than this skip the cluster graph
+        constexpr int DIRECT_SEARCH_DISTANCE = CLUSTER_SIZE * 2;
+        constexpr size_t MAX_CACHED_PATHS = 64;
+        constexpr float DIAGONAL_COST = 1.41421356f;
+        constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+        float octile(float dx, float dy)
+        {
+            dx = std::abs(dx);
+            dy = std::abs(dy);
+            return std::max(dx, dy) + (DIAGONAL_COST - 1.0f) * std::min(dx, dy);
+        }
+
+        uint64_t keyOf(const NavPoint &point)
+        {
+            return (static_cast<uint64_t>(point.map) << 48) ^
+                   (static_cast<uint64_t>(static_cast<uint32_t>(point.x)) << 24) ^ static_cast<uint32_t>(point.y);
+        }
+    }
+
+    void NavWorld::build(World &world)
+    {
+        mWorld = &world;
+        mGrids.clear();
+        for (const auto &worldMap : world.getMaps())
+        {
+            mGrids.push_back(std::make_unique<NavGrid>(*worldMap.map));
+        }
+        mGeneration = ~0ull;
+        mClusters.clear();
+        update();
+    }
+
+    void NavWorld::update()
+    {
+        uint64_t generation = 0;
+        for (const auto &grid : mGrids)
+        {
+            grid->update();
+            generation += grid->getGeneration();
+        }
+
+        if (generation != mGeneration)
+        {
+            mGeneration = generation;
+            rebuildGraph();
+        }
+    }
+
+    void NavWorld::rebuildGraph()
+    {
+        const auto &maps = mWorld->getMaps();
+
+        // Clusters keep their cached costs when the map sizes stay the same
+        std::vector<int> offsets;
+        std::vector<int> clustersX;
+        int clusterCount = 0;
+        for (const auto &grid : mGrids)
+        {
+            offsets.push_back(clusterCount);
+            clustersX.push_back((grid->getWidth() + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+            clusterCount += clustersX.back() * ((grid->getHeight() + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+        }
+        if (offsets != mClusterOffsets || clustersX != mClustersX)
+        {
+            mClusters.assign(clusterCount, {});
+            mClusterOffsets = std::move(offsets);
+            mClustersX = std::move(clustersX);
+        }
+        for (Cluster &cluster : mClusters)
+        {
+            cluster.nodes.clear();
+        }
+        mNodes.clear();
+        mNodeIndex.clear();
+        mPathCache.clear();
+
+        // Entrances between the clusters of each map
+        for (int map = 0; map < static_cast<int>(mGrids.size()); ++map)
+        {
+            const NavGrid &grid = *mGrids[map];
+            for (int x = CLUSTER_SIZE; x < grid.getWidth(); x += CLUSTER_SIZE)
+            {
+                scanBorder(map, {x - 1, 0}, map, {x, 0}, 0, 1, grid.getHeight());
+            }
+            for (int y = CLUSTER_SIZE; y < grid.getHeight(); y += CLUSTER_SIZE)
+            {
+                scanBorder(map, {0, y - 1}, map, {0, y}, 1, 0, grid.getWidth());
+            }
+        }
+
+        // Entrances where two maps of the world touch, if their tiles line up
+        for (int a = 0; a < static_cast<int>(maps.size()); ++a)
+        {
+            for (int b = 0; b < static_cast<int>(maps.size()); ++b)
+            {
+                const TileMap &mapA = *maps[a].map;
+                const TileMap &mapB = *maps[b].map;
+                const int tileWidth = mapA.getTileWidth();
+                const int tileHeight = mapA.getTileHeight();
+                if (a == b || tileWidth != mapB.getTileWidth() || tileHeight != mapB.getTileHeight() ||
+                    (maps[b].x - maps[a].x) % tileWidth != 0 || (maps[b].y - maps[a].y) % tileHeight != 0)
+                {
+                    continue;
+                }
+
+                // Offset of map b in tiles of map a
+                const int offsetX = (maps[b].x - maps[a].x) / tileWidth;
+                const int offsetY = (maps[b].y - maps[a].y) / tileHeight;
+                if (offsetX == mGrids[a]->getWidth())
+                {
+                    int first = std::max(0, offsetY);
+                    int last = std::min(mGrids[a]->getHeight(), offsetY + mGrids[b]->getHeight());
+                    scanBorder(a, {offsetX - 1, first}, b, {0, first - offsetY}, 0, 1, last - first);
+                }
+                if (offsetY == mGrids[a]->getHeight())
+                {
+                    int first = std::max(0, offsetX);
+                    int last = std::min(mGrids[a]->getWidth(), offsetX + mGrids[b]->getWidth());
+                    scanBorder(a, {first, offsetY - 1}, b, {first - offsetX, 0}, 1, 0, last - first);
+                }
+            }
+        }
+
+        for (int cluster = 0; cluster < static_cast<int>(mClusters.size()); ++cluster)
+        {
+            connectCluster(cluster);
+        }
+    }
+
+    void NavWorld::scanBorder(int mapA, NavCell a, int mapB, NavCell b, int stepX, int stepY, int length)
+    {
+        // Splits the border into runs of tiles that are open on both sides and don't
+        // cross a cluster boundary on either side
+        int runStart = -1;
+        int64_t runClusters = -1;
+        for (int i = 0; i <= length; ++i)
+        {
+            NavPoint pointA{mapA, a.x + stepX * i, a.y + stepY * i};
+            NavPoint pointB{mapB, b.x + stepX * i, b.y + stepY * i};
+            bool open = i < length && mGrids[mapA]->isWalkable(pointA.x, pointA.y) &&
+                        mGrids[mapB]->isWalkable(pointB.x, pointB.y);
+            int64_t clusters = open ? static_cast<int64_t>(clusterOf(pointA)) * static_cast<int64_t>(mClusters.size()) + clusterOf(pointB) : -1;
+
+            if (runStart >= 0 && clusters != runClusters)
+            {
+                int runEnd = i - 1;
+                if (runEnd - runStart + 1 >= LONG_ENTRANCE)
+                {
+                    addEntrance(mapA, {a.x + stepX * runStart, a.y + stepY * runStart}, mapB, {b.x + stepX * runStart, b.y + stepY * runStart});
+                    addEntrance(mapA, {a.x + stepX * runEnd, a.y + stepY * runEnd}, mapB, {b.x + stepX * runEnd, b.y + stepY * runEnd});
+                }
+                else
+                {
+                    int middle = (runStart + runEnd) / 2;
+                    addEntrance(mapA, {a.x + stepX * middle, a.y + stepY * middle}, mapB, {b.x + stepX * middle, b.y + stepY * middle});
+                }
+                runStart = -1;
+            }
+
+            if (open && runStart < 0)
+            {
+                runStart = i;
+                runClusters = clusters;
+            }
+        }
+    }
+
+    void NavWorld::addEntrance(int mapA, NavCell a, int mapB, NavCell b)
+    {
+        int nodeA = addNode({mapA, a.x, a.y});
+        int nodeB = addNode({mapB, b.x, b.y});
+        mNodes[nodeA].edges.push_back({nodeB, 1.0f});
+        mNodes[nodeB].edges.push_back({nodeA, 1.0f});
+    }
+
+    int NavWorld::addNode(const NavPoint &point)
+    {
+        auto [it, added] = mNodeIndex.try_emplace({point.map, point.x, point.y}, static_cast<int>(mNodes.size()));
+        if (!added)
+        {
+            return it->second;
+        }
+
+        const WorldMap &worldMap = mWorld->getMaps()[point.map];
+        Node node;
+        node.point = point;
+        node.cluster = clusterOf(point);
+        node.worldX = static_cast<float>(worldMap.x) / worldMap.map->getTileWidth() + point.x;
+        node.worldY = static_cast<float>(worldMap.y) / worldMap.map->getTileHeight() + point.y;
+        mNodes.push_back(std::move(node));
+        mClusters[mNodes.back().cluster].nodes.push_back(it->second);
+        return it->second;
+    }
+
+    int NavWorld::clusterOf(const NavPoint &point) const
+    {
+        return mClusterOffsets[point.map] + (point.y / CLUSTER_SIZE) * mClustersX[point.map] + point.x / CLUSTER_SIZE;
+    }
+
+    void NavWorld::connectCluster(int clusterIndex)
+    {
+        Cluster &cluster = mClusters[clusterIndex];
+        if (cluster.nodes.empty())
+        {
+            return;
+        }
+
+        const int map = mNodes[cluster.nodes[0]].point.map;
+        const NavGrid &grid = *mGrids[map];
+        const int local = clusterIndex - mClusterOffsets[map];
+        const int clusterX = local % mClustersX[map];
+        const int clusterY = local / mClustersX[map];
+
+        std::vector<NavCell> cells;
+        for (int node : cluster.nodes)
+        {
+            cells.push_back({mNodes[node].point.x, mNodes[node].point.y});
+        }
+
+        // The searches inside a cluster are the expensive part, so they only rerun when
+        // a tile in it or one of its entrances changed
+        const uint32_t generation = grid.getClusterGeneration(clusterX, clusterY);
+        const size_t count = cells.size();
+        if (cluster.generation != generation || cluster.cells != cells)
+        {
+            cluster.generation = generation;
+            cluster.cells = cells;
+            cluster.costs.assign(count * count, -1.0f);
+            const int minX = clusterX * CLUSTER_SIZE;
+            const int minY = clusterY * CLUSTER_SIZE;
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t j = i + 1; j < count; ++j)
+                {
+                    float cost = grid.findCost(cells[i], cells[j], minX, minY, minX + CLUSTER_SIZE, minY + CLUSTER_SIZE);
+                    cluster.costs[i * count + j] = cost;
+                    cluster.costs[j * count + i] = cost;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                float cost = cluster.costs[i * count + j];
+                if (i != j && cost >= 0.0f)
+                {
+                    mNodes[cluster.nodes[i]].edges.push_back({cluster.nodes[j], cost});
+                }
+            }
+        }
+    }
+
+    bool NavWorld::findPath(NavPoint start, NavPoint goal, std::vector<NavPoint> &path)
+    {
+        path.clear();
+        update();
+        if (start.map < 0 || goal.map < 0 || start.map >= static_cast<int>(mGrids.size()) ||
+            goal.map >= static_cast<int>(mGrids.size()) ||
+            !mGrids[start.map]->isWalkable(start.x, start.y) || !mGrids[goal.map]->isWalkable(goal.x, goal.y))
+        {
+            return false;
+        }
+
+        // Short routes on one map go straight to jump point search, which caches them itself
+        std::vector<NavCell> &cells = mScratchCells;
+        if (start.map == goal.map && std::abs(goal.x - start.x) + std::abs(goal.y - start.y) < DIRECT_SEARCH_DISTANCE)
+        {
+            if (!mGrids[start.map]->findPath({start.x, start.y}, {goal.x, goal.y}, cells))
+            {
+                return false;
+            }
+            for (const NavCell &cell : cells)
+            {
+                path.push_back({start.map, cell.x, cell.y});
+            }
+            return true;
+        }
+
+        auto cached = mPathCache.find({keyOf(start), keyOf(goal)});
+        if (cached != mPathCache.end())
+        {
+            path = cached->second;
+            return !path.empty();
+        }
+
+        // Refine the waypoints tile by tile. Consecutive waypoints on different maps are
+        // the two sides of a map border, one step apart.
+        std::vector<NavPoint> waypoints;
+        bool found = findAbstractPath(start, goal, waypoints);
+        if (found)
+        {
+            path.push_back(start);
+            for (size_t i = 1; i < waypoints.size() && found; ++i)
+            {
+                const NavPoint &from = waypoints[i - 1];
+                const NavPoint &to = waypoints[i];
+                if (from.map != to.map)
+                {
+                    path.push_back(to);
+                    continue;
+                }
+
+                found = mGrids[from.map]->findPath({from.x, from.y}, {to.x, to.y}, cells);
+                for (size_t j = 1; j < cells.size(); ++j)
+                {
+                    path.push_back({from.map, cells[j].x, cells[j].y});
+                }
+            }
+            if (!found)
+            {
+                path.clear();
+            }
+        }
+
+        if (mPathCache.size() >= MAX_CACHED_PATHS)
+        {
+            mPathCache.clear();
+        }
+        mPathCache[{keyOf(start), keyOf(goal)}] = path;
+        return found;
+    }
+
+    bool NavWorld::findAbstractPath(NavPoint start, NavPoint goal, std::vector<NavPoint> &waypoints)
+    {
+        // The start and goal join the graph as two extra nodes, linked to the entrances
+        // of their clusters
+        const int startNode = static_cast<int>(mNodes.size());
+        const int goalNode = startNode + 1;
+        const int startCluster = clusterOf(start);
+        const int goalCluster = clusterOf(goal);
+
+        auto clusterBounds = [this](int map, int cluster, int &minX, int &minY)
+        {
+            int local = cluster - mClusterOffsets[map];
+            minX = (local % mClustersX[map]) * CLUSTER_SIZE;
+            minY = (local / mClustersX[map]) * CLUSTER_SIZE;
+        };
+
+        int minX, minY;
+        std::vector<Edge> startEdges;
+        clusterBounds(start.map, startCluster, minX, minY);
+        for (int node : mClusters[startCluster].nodes)
+        {
+            const NavPoint &point = mNodes[node].point;
+            float cost = mGrids[start.map]->findCost({start.x, start.y}, {point.x, point.y}, minX, minY, minX + CLUSTER_SIZE, minY + CLUSTER_SIZE);
+            if (cost >= 0.0f)
+            {
+                startEdges.push_back({node, cost});
+            }
+        }
+        if (startCluster == goalCluster)
+        {
+            float cost = mGrids[start.map]->findCost({start.x, start.y}, {goal.x, goal.y}, minX, minY, minX + CLUSTER_SIZE, minY + CLUSTER_SIZE);
+            if (cost >= 0.0f)
+            {
+                startEdges.push_back({goalNode, cost});
+            }
+        }
+
+        std::unordered_map<int, float> goalCosts;
+        clusterBounds(goal.map, goalCluster, minX, minY);
+        for (int node : mClusters[goalCluster].nodes)
+        {
+            const NavPoint &point = mNodes[node].point;
+            float cost = mGrids[goal.map]->findCost({point.x, point.y}, {goal.x, goal.y}, minX, minY, minX + CLUSTER_SIZE, minY + CLUSTER_SIZE);
+            if (cost >= 0.0f)
+            {
+                goalCosts[node] = cost;
+            }
+        }
+
+        const WorldMap &goalMap = mWorld->getMaps()[goal.map];
+        const float goalX = static_cast<float>(goalMap.x) / goalMap.map->getTileWidth() + goal.x;
+        const float goalY = static_cast<float>(goalMap.y) / goalMap.map->getTileHeight() + goal.y;
+
+        struct OpenEntry
+        {
+            float priority;
+            float cost;
+            int node;
+
+            bool operator>(const OpenEntry &other) const { return priority > other.priority; }
+        };
+        std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+        std::vector<float> costs(mNodes.size() + 2, UNREACHABLE);
+        std::vector<int> parents(mNodes.size() + 2, -1);
+
+        costs[startNode] = 0.0f;
+        open.push({0.0f, 0.0f, startNode});
+        while (!open.empty())
+        {
+            OpenEntry entry = open.top();
+            open.pop();
+            if (entry.cost > costs[entry.node])
+            {
+                continue;
+            }
+            if (entry.node == goalNode)
+            {
+                break;
+            }
+
+            auto relax = [&](int node, float cost)
+            {
+                if (cost < costs[node])
+                {
+                    costs[node] = cost;
+                    parents[node] = entry.node;
+                    float heuristic = node == goalNode ? 0.0f : octile(goalX - mNodes[node].worldX, goalY - mNodes[node].worldY);
+                    open.push({cost + heuristic, cost, node});
+                }
+            };
+
+            if (entry.node == startNode)
+            {
+                for (const Edge &edge : startEdges)
+                {
+                    relax(edge.node, edge.cost);
+                }
+                continue;
+            }
+
+            for (const Edge &edge : mNodes[entry.node].edges)
+            {
+                relax(edge.node, entry.cost + edge.cost);
+            }
+            auto toGoal = goalCosts.find(entry.node);
+            if (toGoal != goalCosts.end())
+            {
+                relax(goalNode, entry.cost + toGoal->second);
+            }
+        }
+
+        if (parents[goalNode] < 0)
+        {
+            return false;
+        }
+
+        waypoints.clear();
+        for (int node = goalNode; node >= 0; node = parents[node])
+        {
+            waypoints.push_back(node == goalNode ? goal : node == startNode ? start : mNodes[node].point);
+        }
+        std::reverse(waypoints.begin(), waypoints.end());
+        return true;
+    }
+
+    bool NavWorld::locate(float worldX, float worldY, NavPoint &point) const
+    {
+        const auto &maps = mWorld->getMaps();
+        for (int map = 0; map < static_cast<int>(maps.size()); ++map)
+        {
+            const TileMap &tileMap = *maps[map].map;
+            int x = static_cast<int>(std::floor((worldX - maps[map].x) / tileMap.getTileWidth()));
+            int y = static_cast<int>(std::floor((worldY - maps[map].y) / tileMap.getTileHeight()));
+            if (x >= 0 && y >= 0 && x < tileMap.getWidth() && y < tileMap.getHeight())
+            {
+                point = {map, x, y};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void NavWorld::getCenter(const NavPoint &point, float &worldX, float &worldY) const
+    {
+        const WorldMap &worldMap = mWorld->getMaps()[point.map];
+        worldX = worldMap.x + (point.x + 0.5f) * worldMap.map->getTileWidth();
+        worldY = worldMap.y + (point.y + 0.5f) * worldMap.map->getTileHeight();
+    }
+
+} // namespace zuul
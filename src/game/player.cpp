@@ -4,13 +4,19 @@
 #include <engine/renderer.hpp>
 #include <game/player.hpp>
 #include <game/tilemap.hpp>
+#include <asset_manifest.hpp>
 
 namespace zuul
 {
+    namespace
+    {
+        constexpr int MAX_SLIDES = 3;          // Walls hit per frame, enough for any corner
+        constexpr float CONTACT_SKIN = 0.001f; // Gap kept to colliders so the next sweep starts outside
+    }
+
     Player::Player()
         : mDirection(Direction::Down),
           mTilesetData(std::make_shared<TilesetData>()),
-          mTexture(nullptr),
           mX(0),
           mY(0),
           mSpeed(200.0f),
@@ -26,16 +32,16 @@ namespace zuul
     {
     }
 
-    bool Player::initialize(std::shared_ptr<Renderer> renderer)
+    bool Player::initialize(AssetRegistry &assets)
     {
         mTilesetData = std::make_shared<TilesetData>();
-        if (!mTilesetData->loadFromFile("assets/player_tiles.tsj", renderer))
+        if (!mTilesetData->loadFromFile(manifest::PLAYER_TILESET.path, assets))
         {
             return false;
         }
 
-        // Load player texture
-        mTexture = renderer->loadTexture("assets/player_tiles.png");
+        // Load player texture, shared with the tileset by the registry
+        mTexture = assets.loadTexture(manifest::PLAYER_TILES);
         if (!mTexture)
         {
             return false;
@@ -98,27 +104,30 @@ namespace zuul
         // Update collision box before movement checks
         updateCollisionBox();
 
-        // Try X movement first
-        float newX = mX + dx * mSpeed * deltaTime;
-        if (!tileMap.checkCollision(
-                newX + mCollisionBoxOffsetX,
-                mY + mCollisionBoxOffsetY,
-                mCollisionBoxWidth,
-                mCollisionBoxHeight))
-        {
-            mX = newX;
-        }
-
-        // Then try Y movement
-        float newY = mY + dy * mSpeed * deltaTime;
-        if (!tileMap.checkCollision(
-                mX + mCollisionBoxOffsetX,
-                newY + mCollisionBoxOffsetY,
-                mCollisionBoxWidth,
-                mCollisionBoxHeight))
-        {
-            mY = newY;
-        }
+        // Sweep the collision box along the motion and slide along whatever it hits, so
+        // no speed or frame time can carry it through a collider
+        const CollisionWorld &collision = tileMap.getCollisionWorld();
+        CollisionBox box{mX + mCollisionBoxOffsetX, mY + mCollisionBoxOffsetY, mCollisionBoxWidth, mCollisionBoxHeight};
+        float moveX = dx * mSpeed * deltaTime;
+        float moveY = dy * mSpeed * deltaTime;
+        for (int i = 0; i < MAX_SLIDES && (moveX != 0 || moveY != 0); ++i)
+        {
+            CollisionHit hit;
+            if (!collision.castBox(box, moveX, moveY, hit))
+            {
+                box.x += moveX;
+                box.y += moveY;
+                break;
+            }
+
+            // Stop just short of the contact, then keep the motion along the surface
+            box.x += moveX * hit.time + hit.normalX * CONTACT_SKIN;
+            box.y += moveY * hit.time + hit.normalY * CONTACT_SKIN;
+            moveX = hit.normalX != 0 ? 0 : moveX * (1.0f - hit.time);
+            moveY = hit.normalY != 0 ? 0 : moveY * (1.0f - hit.time);
+        }
+        mX = box.x - mCollisionBoxOffsetX;
+        mY = box.y - mCollisionBoxOffsetY;
 
         // Check for item collisions
         tileMap.checkItemCollisions(
@@ -148,7 +157,7 @@ namespace zuul
         }
     }
 
-    void Player::render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void Player::queue(DrawQueue &queue, uint8_t layer, float offsetX, float offsetY, float zoom) const
     {
         // Calculate screen position with zoom
         float screenX = std::floor((mX - offsetX) * zoom);
@@ -171,18 +180,21 @@ namespace zuul
         int srcX = (currentTileId % mTilesetColumns) * mWidth;
         int srcY = (currentTileId / mTilesetColumns) * mHeight;
 
-        // Render the player sprite scaled by zoom
-        renderer->renderTexture(mTexture,
-                                srcX, srcY, mWidth, mHeight,
-                                static_cast<int>(screenX),
-                                static_cast<int>(screenY),
-                                destW, destH);
+        // Depth is the player's feet, so y-sorted tiles further down the map cover the player
+        queue.push(layer, static_cast<int32_t>(mY + mHeight), mTexture.get(),
+                   srcX, srcY, mWidth, mHeight,
+                   static_cast<int>(screenX),
+                   static_cast<int>(screenY),
+                   destW, destH);
+    }
 
+    void Player::renderDebug(Renderer &renderer, float offsetX, float offsetY, float zoom)
+    {
         // Render collision box in debug mode
         if (mDebugRendering)
         {
             // Draw collision box in blue
-            renderer->renderRect(
+            renderer.renderRect(
                 static_cast<int>((mX + mCollisionBoxOffsetX - offsetX) * zoom),
                 static_cast<int>((mY + mCollisionBoxOffsetY - offsetY) * zoom),
                 static_cast<int>(mCollisionBoxWidth * zoom),
@@ -0,0 +1,167 @@
+#include "game/tile_grid.hpp"
+#include <algorithm>
+
+namespace zuul
+{
+    TileGrid::TileGrid()
+        : mPalette{0}, mLayerCount(0), mLayout(Layout::Cell),
+          mMinChunkX(0), mMinChunkY(0), mMaxChunkX(-1), mMaxChunkY(-1)
+    {
+    }
+
+    void TileGrid::reset(int layerCount, Layout layout)
+    {
+        mChunks.clear();
+        mPalette.assign(1, 0);
+        mPaletteTiles.clear();
+        mLayerCount = layerCount;
+        mLayout = layout;
+        mMinChunkX = 0;
+        mMinChunkY = 0;
+        mMaxChunkX = -1;
+        mMaxChunkY = -1;
+    }
+
+    TileGrid::Chunk *TileGrid::findChunk(int chunkX, int chunkY)
+    {
+        auto it = mChunks.find(keyOf(chunkX, chunkY));
+        return it != mChunks.end() ? &it->second : nullptr;
+    }
+
+    const TileGrid::Chunk *TileGrid::findChunk(int chunkX, int chunkY) const
+    {
+        auto it = mChunks.find(keyOf(chunkX, chunkY));
+        return it != mChunks.end() ? &it->second : nullptr;
+    }
+
+    bool TileGrid::setGid(int layer, int x, int y, uint32_t gid)
+    {
+        uint32_t tileId = gid & ~ALL_FLIP_FLAGS;
+        uint16_t tile = 0;
+        if (tileId != 0)
+        {
+            auto it = mPaletteTiles.find(tileId);
+            if (it == mPaletteTiles.end())
+            {
+                if (mPalette.size() >= MAX_PALETTE_SIZE)
+                {
+                    return false;
+                }
+                it = mPaletteTiles.emplace(tileId, static_cast<uint16_t>(mPalette.size())).first;
+                mPalette.push_back(tileId);
+            }
+            tile = it->second;
+        }
+
+        const int chunkX = x >> 4;
+        const int chunkY = y >> 4;
+        Chunk *chunk = findChunk(chunkX, chunkY);
+        if (!chunk)
+        {
+            // Empty cells in missing chunks are already empty
+            if (tileId == 0)
+            {
+                return true;
+            }
+
+            chunk = &mChunks[keyOf(chunkX, chunkY)];
+            chunk->chunkX = chunkX;
+            chunk->chunkY = chunkY;
+            chunk->tiles.assign(static_cast<size_t>(CHUNK_CELLS) * mLayerCount, 0);
+
+            if (mMaxChunkX < mMinChunkX)
+            {
+                mMinChunkX = mMaxChunkX = chunkX;
+                mMinChunkY = mMaxChunkY = chunkY;
+            }
+            mMinChunkX = std::min(mMinChunkX, chunkX);
+            mMinChunkY = std::min(mMinChunkY, chunkY);
+            mMaxChunkX = std::max(mMaxChunkX, chunkX);
+            mMaxChunkY = std::max(mMaxChunkY, chunkY);
+        }
+
+        size_t index = indexOf(layer, cellOf(x, y));
+        chunk->tiles[index] = tile;
+        chunk->dirty = true;
+
+        uint32_t flips = gid >> 29;
+        for (int plane = 0; plane < 3; ++plane)
+        {
+            auto &bits = chunk->flipPlanes[plane];
+            bool set = flips & (4u >> plane);
+            if (bits.empty())
+            {
+                if (!set)
+                {
+                    continue;
+                }
+                bits.assign((chunk->tiles.size() + 63) / 64, 0);
+            }
+
+            uint64_t bit = uint64_t{1} << (index % 64);
+            if (set)
+            {
+                bits[index / 64] |= bit;
+            }
+            else
+            {
+                bits[index / 64] &= ~bit;
+            }
+        }
+        return true;
+    }
+
+    uint8_t TileGrid::getFlips(int layer, int x, int y) const
+    {
+        const Chunk *chunk = findChunk(x >> 4, y >> 4);
+        if (!chunk)
+        {
+            return 0;
+        }
+
+        size_t index = indexOf(layer, cellOf(x, y));
+        uint8_t flips = 0;
+        for (int plane = 0; plane < 3; ++plane)
+        {
+            const auto &bits = chunk->flipPlanes[plane];
+            if (!bits.empty() && (bits[index / 64] >> (index % 64)) & 1)
+            {
+                flips |= 4u >> plane;
+            }
+        }
+        return flips;
+    }
+
+    uint32_t TileGrid::getGid(int layer, int x, int y) const
+    {
+        return mPalette[getTile(layer, x, y)] | (static_cast<uint32_t>(getFlips(layer, x, y)) << 29);
+    }
+
+    bool TileGrid::sameTiles(const Chunk &chunk, const TileGrid &other, const Chunk &otherChunk) const
+    {
+        if (chunk.tiles != otherChunk.tiles ||
+            !std::equal(std::begin(chunk.flipPlanes), std::end(chunk.flipPlanes), std::begin(otherChunk.flipPlanes)))
+        {
+            return false;
+        }
+
+        // Grids loaded from nearly the same file mostly number their gids alike
+        return std::all_of(chunk.tiles.begin(), chunk.tiles.end(),
+                           [&](uint16_t tile) { return mPalette[tile] == other.mPalette[tile]; });
+    }
+
+    size_t TileGrid::getMemoryUsage() const
+    {
+        size_t bytes = mPalette.size() * sizeof(uint32_t) + mPaletteTiles.size() * (sizeof(uint32_t) + sizeof(uint16_t));
+        for (const auto &[key, chunk] : mChunks)
+        {
+            bytes += sizeof(Chunk) + chunk.tiles.size() * sizeof(uint16_t);
+            for (const auto &plane : chunk.flipPlanes)
+            {
+                bytes += plane.size() * sizeof(uint64_t);
+            }
+        }
+        return bytes;
+    }
+
+} // namespace zuul
@@ -0,0 +1,287 @@
+#include "game/tiled_reader.hpp"
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include <charconv>
+#include <future>
+
+using json = nlohmann::json;
+
+namespace zuul
+{
+    namespace
+    {
+        // Data arrays at least this large are parsed on their own thread
+        constexpr size_t PARALLEL_PARSE_BYTES = 64 * 1024;
+
+        // The value of a "data" key that is an array. Numeric arrays span [begin, end)
+        // between their brackets; their numbers end up in gids and the text is blanked.
+        struct DataArray
+        {
+            size_t begin;
+            size_t end;
+            bool numeric;
+            std::vector<uint32_t> gids;
+        };
+
+        // Finds every "data" key with an array value, in document order. Strings are
+        // skipped as a whole, so only real keys match.
+        std::vector<DataArray> findDataArrays(const std::string &text)
+        {
+            std::vector<DataArray> arrays;
+            const char *whitespace = " \t\r\n";
+            size_t pos = 0;
+
+            while ((pos = text.find('"', pos)) != std::string::npos)
+            {
+                size_t end = pos + 1;
+                while (end < text.size() && text[end] != '"')
+                {
+                    end += text[end] == '\\' ? 2 : 1;
+                }
+                if (end >= text.size())
+                {
+                    break;
+                }
+
+                bool isData = end - pos == 5 && text.compare(pos + 1, 4, "data") == 0;
+                pos = end + 1;
+                if (!isData)
+                {
+                    continue;
+                }
+
+                size_t colon = text.find_first_not_of(whitespace, pos);
+                if (colon == std::string::npos || text[colon] != ':')
+                {
+                    continue;
+                }
+                size_t open = text.find_first_not_of(whitespace, colon + 1);
+                if (open == std::string::npos || text[open] != '[')
+                {
+                    continue;
+                }
+
+                size_t close = text.find_first_not_of("0123456789,- \t\r\n", open + 1);
+                bool numeric = close != std::string::npos && text[close] == ']';
+                arrays.push_back({open + 1, numeric ? close : open + 1, numeric, {}});
+                pos = numeric ? close + 1 : open + 1;
+            }
+            return arrays;
+        }
+
+        bool parseGids(const char *begin, const char *end, std::vector<uint32_t> &gids)
+        {
+            gids.reserve(std::count(begin, end, ',') + 1);
+            const char *p = begin;
+            while (true)
+            {
+                while (p < end && (*p == ',' || *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+                {
+                    ++p;
+                }
+                if (p >= end)
+                {
+                    return true;
+                }
+
+                uint32_t gid = 0;
+                auto [next, error] = std::from_chars(p, end, gid);
+                if (error != std::errc())
+                {
+                    return false;
+                }
+                gids.push_back(gid);
+                p = next;
+            }
+        }
+
+        // SAX handler that keeps only the scalar fields of the open objects
+        class ObjectStream : public json::json_sax_t
+        {
+        public:
+            ObjectStream(std::vector<DataArray> &arrays, const TiledObjectHandler &onObject)
+                : mArrays(arrays), mNextArray(0), mOnObject(onObject)
+            {
+            }
+
+            const std::string &getError() const { return mError; }
+
+            bool null() override { return setField(nullptr); }
+            bool boolean(bool value) override { return setField(value); }
+            bool number_integer(number_integer_t value) override { return setField(value); }
+            bool number_unsigned(number_unsigned_t value) override { return setField(value); }
+            bool number_float(number_float_t value, const string_t &) override { return setField(value); }
+            bool string(string_t &value) override { return setField(std::move(value)); }
+            bool binary(binary_t &) override { return true; }
+
+            bool key(string_t &key) override
+            {
+                mKey = std::move(key);
+                return true;
+            }
+
+            bool start_object(std::size_t) override
+            {
+                push(true);
+                return true;
+            }
+
+            bool end_object() override
+            {
+                mOnObject(mPath, mFrames.back().object);
+                pop();
+                return true;
+            }
+
+            bool start_array(std::size_t) override
+            {
+                // Pair the array with the matching entry of findDataArrays
+                if (!mFrames.empty() && mFrames.back().isObject && mKey == "data")
+                {
+                    if (mNextArray >= mArrays.size())
+                    {
+                        mError = "data arrays out of sync";
+                        return false;
+                    }
+
+                    DataArray &array = mArrays[mNextArray++];
+                    if (array.numeric)
+                    {
+                        mFrames.back().object.data = std::move(array.gids);
+                        mFrames.back().object.hasData = true;
+                    }
+                }
+                push(false);
+                return true;
+            }
+
+            bool end_array() override
+            {
+                pop();
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &error) override
+            {
+                mError = error.what();
+                return false;
+            }
+
+        private:
+            struct Frame
+            {
+                bool isObject;
+                bool hasKey;
+                TiledObject object;
+            };
+
+            template <typename T>
+            bool setField(T &&value)
+            {
+                if (mFrames.empty())
+                {
+                    return true;
+                }
+
+                if (mFrames.back().isObject)
+                {
+                    mFrames.back().object.fields[mKey] = std::forward<T>(value);
+                }
+                else if (mFrames.back().hasKey)
+                {
+                    // Plain values in an array, like a wang tile's "wangid", are kept as a
+                    // json array field of the enclosing object
+                    mFrames[mFrames.size() - 2].object.fields[mPath.keys.back()].push_back(std::forward<T>(value));
+                }
+                return true;
+            }
+
+            void push(bool isObject)
+            {
+                // Containers inside arrays have no key of their own
+                bool hasKey = !mFrames.empty() && mFrames.back().isObject;
+                if (hasKey)
+                {
+                    mPath.keys.push_back(mKey);
+                }
+                mFrames.push_back({isObject, hasKey, {}});
+            }
+
+            void pop()
+            {
+                if (mFrames.back().hasKey)
+                {
+                    mPath.keys.pop_back();
+                }
+                mFrames.pop_back();
+            }
+
+            std::vector<DataArray> &mArrays;
+            size_t mNextArray;
+            const TiledObjectHandler &mOnObject;
+            std::vector<Frame> mFrames;
+            TiledPath mPath;
+            std::string mKey;
+            std::string mError;
+        };
+    }
+
+    bool readTiledFile(const std::string &filepath, const TiledObjectHandler &onObject)
+    {
+        std::string text;
+        if (!getFileSystem().readFile(filepath, text))
+        {
+            ZUUL_LOG_ERROR(Assets, "Failed to open file: {}", filepath);
+            return false;
+        }
+
+        // Parse the numeric data arrays first, the large ones in parallel, then blank
+        // them out so the JSON parser only sees the small remainder of the file
+        std::vector<DataArray> arrays = findDataArrays(text);
+        std::vector<std::pair<DataArray *, std::future<bool>>> pending;
+        bool parsed = true;
+
+        for (DataArray &array : arrays)
+        {
+            if (!array.numeric)
+            {
+                continue;
+            }
+
+            const char *begin = text.data() + array.begin;
+            const char *end = text.data() + array.end;
+            if (array.end - array.begin >= PARALLEL_PARSE_BYTES)
+            {
+                pending.emplace_back(&array, std::async(std::launch::async, parseGids, begin, end, std::ref(array.gids)));
+            }
+            else
+            {
+                parsed = parseGids(begin, end, array.gids) && parsed;
+            }
+        }
+
+        for (auto &[array, result] : pending)
+        {
+            parsed = result.get() && parsed;
+        }
+        if (!parsed)
+        {
+            ZUUL_LOG_ERROR(Assets, "Invalid tile data in {}", filepath);
+            return false;
+        }
+
+        for (const DataArray &array : arrays)
+        {
+            std::fill(text.begin() + array.begin, text.begin() + array.end, ' ');
+        }
+
+        ObjectStream stream(arrays, onObject);
+        if (!json::sax_parse(text, &stream))
+        {
+            ZUUL_LOG_ERROR(Assets, "Failed to parse {}: {}", filepath, stream.getError());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace zuul
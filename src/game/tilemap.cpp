@@ -1,19 +1,31 @@
 #include "game/tilemap.hpp"
-#include <nlohmann/json.hpp>
+#include "engine/file_system.hpp"
+#include "engine/log.hpp"
+#include "game/layer_data.hpp"
+#include "game/tiled_reader.hpp"
+#include "engine/alloc_tracker.hpp"
 #include <engine/renderer.hpp>
-#include <fstream>
-#include <iostream>
+#include <filesystem>
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <tuple>
+#include <thread>
 
 using json = nlohmann::json;
 
 namespace zuul
 {
     TileMap::TileMap()
-        : mWidth(0), mHeight(0), mTileWidth(0), mTileHeight(0),
+        : mTileLayout(TileGrid::Layout::Cell),
+          mWidth(0), mHeight(0), mTileWidth(0), mTileHeight(0),
           mWindowWidth(800), mWindowHeight(600), // Default window dimensions
-          mDebugRendering(false)
+          mDebugRendering(false), mEntityLayer(0), mContentGeneration(0),
+          mCompositeColumns(0), mFlattenedLayerEnd(0)
     {
     }
 
@@ -27,121 +39,595 @@ namespace zuul
         }
     }
 
-    bool TileMap::loadFromFile(const std::string &filepath, std::shared_ptr<Renderer> renderer)
+    namespace
     {
-        try
+        // Parts of the map kept while streaming the file. The tile grid needs the layer
+        // count, bounds and tilesets up front, and Tiled writes those after the layers.
+        struct ChunkRecord
+        {
+            int x;
+            int y;
+            int width;
+            int height;
+            TiledObject object;
+        };
+
+        struct LayerRecord
+        {
+            MapLayer layer;
+            TiledObject object;
+            std::vector<ChunkRecord> chunks; // Infinite maps only
+        };
+
+        struct ItemRecord
+        {
+            uint32_t gid;
+            float x;
+            float y;
+        };
+
+        struct TilesetRecord
         {
-            std::ifstream file(filepath);
-            if (!file.is_open())
+            int firstGid;
+            std::string source;                    // Empty for tilesets embedded in the map
+            std::shared_ptr<TilesetData> embedded;
+        };
+
+        // Tileset sources are relative to the map. Tilesets referenced from outside the
+        // assets are looked up next to the map by file name.
+        std::filesystem::path resolveTilesetPath(const std::filesystem::path &directory, const std::string &source)
+        {
+            std::filesystem::path path = (directory / source).lexically_normal();
+            if (!getFileSystem().exists(path.string()))
             {
-                std::cerr << "Failed to open map file: " << filepath << std::endl;
-                return false;
+                path = directory / std::filesystem::path(source).filename();
             }
+            return path;
+        }
 
-            json mapData;
-            file >> mapData;
+        // Base64 layer data is decoded once the layer's encoding is known
+        struct DecodeTask
+        {
+            const json *layerFields;
+            TiledObject *object;
+            size_t cellCount;
+        };
 
-            mWidth = mapData["width"].get<int>();
-            mHeight = mapData["height"].get<int>();
-            mTileWidth = mapData["tileheight"].get<int>();
-            mTileHeight = mapData["tilewidth"].get<int>();
+        bool decodeTileData(const DecodeTask &task)
+        {
+            const json &data = task.object->fields["data"];
+            return data.is_string() &&
+                   decodeLayerData(data.get_ref<const std::string &>(), task.layerFields->value("compression", ""),
+                                   task.cellCount, task.object->data);
+        }
 
-            // Load tilesets
-            int firstGid = 1;
-            std::string tilesetPath;
-            for (const auto &tileset : mapData["tilesets"])
+        // Tiles of a tileset without texture are left empty, so nothing resolves to them
+        void dropTilesetsWithoutTexture(std::vector<GidEntry> &gidTable, const std::vector<MapTileset> &tilesets)
+        {
+            for (auto &entry : gidTable)
             {
-                if (tileset.contains("source"))
+                if (entry.tileset != GidEntry::NO_TILESET && !tilesets[entry.tileset].data->getTexture())
                 {
-                    std::string source = tileset["source"].get<std::string>();
-                    if (source.find("map_tiles.tsj") != std::string::npos)
+                    entry.tileset = GidEntry::NO_TILESET;
+                }
+            }
+        }
+    }
+
+    bool TileMap::loadFromFile(const std::string &filepath, AssetRegistry &assets)
+    {
+        std::shared_ptr<MapSnapshot> snapshot = readSnapshot(filepath, mTileLayout);
+        return snapshot && loadSnapshot(std::move(*snapshot), assets);
+    }
+
+    void MapSnapshot::buildGidTable()
+    {
+        // One table entry per gid, so resolving a tile never searches the tilesets
+        size_t gidCount = 1;
+        for (const auto &tileset : tilesets)
+        {
+            gidCount = std::max(gidCount, static_cast<size_t>(tileset.firstGid + tileset.data->getTilesetInfo().tileCount));
+        }
+        gidTable.assign(gidCount, {GidEntry::NO_TILESET, 0});
+        for (size_t index = 0; index < tilesets.size(); ++index)
+        {
+            const auto &tileset = tilesets[index];
+            size_t end = static_cast<size_t>(tileset.firstGid + tileset.data->getTilesetInfo().tileCount);
+            for (size_t gid = tileset.firstGid; gid < end; ++gid)
+            {
+                gidTable[gid] = {static_cast<uint16_t>(index), static_cast<uint16_t>(gid - tileset.firstGid)};
+            }
+        }
+    }
+
+    std::shared_ptr<MapSnapshot> TileMap::readSnapshot(const std::string &filepath, TileGrid::Layout layout)
+    {
+        try
+        {
+            json mapFields;
+            std::vector<LayerRecord> tileLayers;
+            std::vector<ChunkRecord> chunks;
+            std::vector<ItemRecord> items;
+            std::vector<TilesetRecord> tilesets;
+            std::shared_ptr<TilesetData> embeddedTileset;
+            bool ySorted = false;
+
+            // Child objects complete before their layer, so collect them until it does
+            bool read = readTiledFile(filepath, [&](const TiledPath &path, TiledObject &object)
+            {
+                const json &fields = object.fields;
+
+                if (path.is({"layers", "chunks"}))
+                {
+                    chunks.push_back({fields["x"].get<int>(), fields["y"].get<int>(),
+                                      fields["width"].get<int>(), fields["height"].get<int>(),
+                                      std::move(object)});
+                }
+                else if (path.is({"layers", "properties"}))
+                {
+                    // Load layer properties
+                    if (fields["name"] == "ysort" && fields["type"] == "bool")
                     {
-                        firstGid = tileset["firstgid"].get<int>();
-                        tilesetPath = "assets/map_tiles.tsj";
-                        break;
+                        ySorted = fields["value"].get<bool>();
+                    }
+                }
+                else if (path.is({"layers", "objects"}))
+                {
+                    // Load items
+                    if (fields.value("type", "") == "Item")
+                    {
+                        items.push_back({fields["gid"].get<uint32_t>(), fields["x"].get<float>(), fields["y"].get<float>()});
+                    }
+                }
+                else if (path.is({"layers"}))
+                {
+                    if (fields["type"] == "tilelayer")
+                    {
+                        LayerRecord record;
+                        record.layer.name = fields["name"].get<std::string>();
+                        record.layer.visible = fields["visible"].get<bool>();
+                        record.layer.ySorted = ySorted;
+                        record.object = std::move(object);
+                        record.chunks = std::move(chunks);
+                        tileLayers.push_back(std::move(record));
                     }
+                    chunks.clear();
+                    ySorted = false;
                 }
+                else if (path.is({"tilesets"}))
+                {
+                    // External tilesets are loaded once the map is read, embedded ones are read in place
+                    TilesetRecord record{fields["firstgid"].get<int>(), fields.value("source", ""), nullptr};
+                    if (record.source.empty())
+                    {
+                        record.embedded = embeddedTileset ? embeddedTileset : std::make_shared<TilesetData>();
+                        record.embedded->readObject(TiledPath{}, object);
+                    }
+                    tilesets.push_back(std::move(record));
+                    embeddedTileset.reset();
+                }
+                else if (!path.keys.empty() && path.keys[0] == "tilesets")
+                {
+                    if (!embeddedTileset)
+                    {
+                        embeddedTileset = std::make_shared<TilesetData>();
+                    }
+                    embeddedTileset->readObject(TiledPath{{path.keys.begin() + 1, path.keys.end()}}, object);
+                }
+                else if (path.is({}))
+                {
+                    mapFields = std::move(object.fields);
+                }
+            });
+
+            if (!read)
+            {
+                ZUUL_LOG_ERROR(Map, "Failed to read map file: {}", filepath);
+                return nullptr;
             }
 
-            // Create and load tileset data
-            mTilesetData = std::make_shared<TilesetData>();
-            if (!mTilesetData->loadFromFile(tilesetPath, renderer))
+            auto snapshot = std::make_shared<MapSnapshot>();
+            MapSnapshot &map = *snapshot;
+            map.filepath = std::filesystem::path(filepath).lexically_normal().string();
+            map.width = mapFields["width"].get<int>();
+            map.height = mapFields["height"].get<int>();
+            map.tileWidth = mapFields["tileheight"].get<int>();
+            map.tileHeight = mapFields["tilewidth"].get<int>();
+
+            // Read tilesets; their textures are loaded by loadSnapshot
+            const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+            for (const auto &record : tilesets)
             {
-                std::cerr << "Failed to load tileset data" << std::endl;
-                return false;
+                std::shared_ptr<TilesetData> data = record.embedded;
+                bool loaded = false;
+                if (data)
+                {
+                    data->resolveImagePath(directory.string());
+                    loaded = true;
+                }
+                else if (std::filesystem::path(record.source).extension() != ".tsj" &&
+                         std::filesystem::path(record.source).extension() != ".json")
+                {
+                    ZUUL_LOG_WARN(Map, "Unsupported tileset format: {}", record.source);
+                }
+                else
+                {
+                    data = std::make_shared<TilesetData>();
+                    loaded = data->readFromFile(resolveTilesetPath(directory, record.source).string());
+                }
+
+                // Tiles of a missing tileset are left empty instead of failing the whole map
+                if (!loaded)
+                {
+                    ZUUL_LOG_WARN(Map, "Skipping tileset at gid {}", record.firstGid);
+                    continue;
+                }
+                map.tilesets.push_back({record.firstGid, data});
             }
 
-            // Load tileset texture
-            mTileset = renderer->loadTexture("assets/" + mTilesetData->getTilesetInfo().imagePath);
-            if (!mTileset)
+            if (map.tilesets.empty())
             {
-                std::cerr << "Failed to load tileset texture" << std::endl;
-                return false;
+                ZUUL_LOG_ERROR(Map, "Failed to load tileset data");
+                return nullptr;
             }
 
-            // Clear existing layers and items
-            mLayers.clear();
-            mItems.clear();
+            map.buildGidTable();
 
-            // Load layers
-            for (const auto &layer : mapData["layers"])
+            // Infinite maps store their layers in chunks that may start at negative
+            // coordinates; the used area is shifted to start at 0, 0 so cameras and
+            // collisions stay as-is.
+            int originX = 0;
+            int originY = 0;
+            if (mapFields.value("infinite", false))
             {
-                std::string type = layer["type"].get<std::string>();
+                int minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+                for (const auto &record : tileLayers)
+                {
+                    for (const auto &chunk : record.chunks)
+                    {
+                        minX = std::min(minX, chunk.x);
+                        minY = std::min(minY, chunk.y);
+                        maxX = std::max(maxX, chunk.x + chunk.width);
+                        maxY = std::max(maxY, chunk.y + chunk.height);
+                    }
+                }
 
-                if (type == "tilelayer")
+                if (minX <= maxX)
                 {
-                    MapLayer newLayer;
-                    newLayer.name = layer["name"].get<std::string>();
-                    newLayer.visible = layer["visible"].get<bool>();
+                    originX = minX;
+                    originY = minY;
+                    map.width = maxX - minX;
+                    map.height = maxY - minY;
+                }
+            }
 
-                    // Load tile data
-                    const auto &data = layer["data"];
-                    newLayer.tileData.reserve(data.size());
-                    for (const auto &gid : data)
+            // Decode base64 layers and chunks in parallel; JSON arrays were already parsed by the reader
+            std::vector<DecodeTask> tasks;
+            for (auto &record : tileLayers)
+            {
+                if (record.object.fields.value("encoding", "csv") != "base64")
+                {
+                    continue;
+                }
+                if (record.chunks.empty())
+                {
+                    tasks.push_back({&record.object.fields, &record.object, static_cast<size_t>(map.width) * map.height});
+                }
+                for (auto &chunk : record.chunks)
+                {
+                    tasks.push_back({&record.object.fields, &chunk.object, static_cast<size_t>(chunk.width) * chunk.height});
+                }
+            }
+
+            std::atomic<size_t> nextTask{0};
+            std::atomic<bool> decoded{true};
+            auto decodeTasks = [&]()
+            {
+                for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+                {
+                    if (!decodeTileData(tasks[i]))
                     {
-                        newLayer.tileData.push_back(gid.get<unsigned int>());
+                        decoded = false;
                     }
-
-                    mLayers.push_back(newLayer);
                 }
-                else if (type == "objectgroup")
+            };
+
+            std::vector<std::thread> workers;
+            size_t workerCount = std::min<size_t>(tasks.size(), std::max(1u, std::thread::hardware_concurrency()));
+            for (size_t i = 1; i < workerCount; ++i)
+            {
+                workers.emplace_back(decodeTasks);
+            }
+            decodeTasks();
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+
+            if (!decoded)
+            {
+                ZUUL_LOG_ERROR(Map, "Failed to decode tile data in {}", filepath);
+                return nullptr;
+            }
+
+            // Copies a row-major block of gids into the grid; empty cells allocate nothing.
+            // Gids past every tileset are dropped so the gid table never needs a bounds check.
+            size_t unknownGids = 0;
+            auto loadTileData = [&](const std::vector<uint32_t> &gids, int layerIndex,
+                                    int left, int top, int width, int height)
+            {
+                const size_t cellCount = std::min(gids.size(), static_cast<size_t>(width) * height);
+                for (size_t i = 0; i < cellCount; ++i)
                 {
-                    // Load items
-                    for (const auto &obj : layer["objects"])
+                    int x = left + static_cast<int>(i % width);
+                    int y = top + static_cast<int>(i / width);
+                    if (x < 0 || x >= map.width || y < 0 || y >= map.height)
                     {
-                        if (obj.contains("type") && obj["type"].get<std::string>() == "Item")
-                        {
-                            int gid = obj["gid"].get<int>();
-                            float x = obj["x"].get<float>();
-                            float y = obj["y"].get<float>() - mTileHeight; // Adjust Y position for Tiled's coordinate system
-
-                            // Convert GID to local tile ID by subtracting firstGid
-                            int localTileId = gid - firstGid;
-
-                            mItems.emplace_back(localTileId, x, y, mTilesetData, mTileset);
-                            // Set the collect callback for the newly created item
-                            if (mItemCollectCallback)
-                            {
-                                mItems.back().setCollectCallback(mItemCollectCallback);
-                            }
-                        }
+                        continue;
                     }
+                    uint32_t gid = gids[i];
+                    if ((gid & ~ALL_FLIP_FLAGS) >= map.gidTable.size())
+                    {
+                        gid = 0;
+                        unknownGids++;
+                    }
+                    if (!map.tiles.setGid(layerIndex, x, y, gid))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // Load layers
+            map.tiles.reset(static_cast<int>(tileLayers.size()), layout);
+            for (const auto &record : tileLayers)
+            {
+                const int layerIndex = static_cast<int>(map.layers.size());
+                bool loaded = true;
+                if (record.chunks.empty())
+                {
+                    loaded = loadTileData(record.object.data, layerIndex, 0, 0, map.width, map.height);
+                }
+                for (const auto &chunk : record.chunks)
+                {
+                    loaded = loaded && loadTileData(chunk.object.data, layerIndex, chunk.x - originX, chunk.y - originY,
+                                                    chunk.width, chunk.height);
+                }
+
+                if (!loaded)
+                {
+                    ZUUL_LOG_ERROR(Map, "Invalid tile data in layer {}", record.layer.name);
+                    return nullptr;
                 }
+
+                map.layers.push_back(record.layer);
             }
 
-            return true;
+            if (unknownGids > 0)
+            {
+                ZUUL_LOG_WARN(Map, "{} tiles in {} have no tileset", unknownGids, filepath);
+            }
+
+            // Items use the tileset their gid belongs to
+            for (const auto &record : items)
+            {
+                uint32_t gid = record.gid & ~ALL_FLIP_FLAGS;
+                if (gid >= map.gidTable.size() || map.gidTable[gid].tileset == GidEntry::NO_TILESET)
+                {
+                    continue;
+                }
+
+                map.items.push_back({map.gidTable[gid].tileset, map.gidTable[gid].localId,
+                                     record.x - originX * map.tileWidth,
+                                     record.y - originY * map.tileHeight - map.tileHeight}); // Adjust Y position for Tiled's coordinate system
+            }
+
+            return snapshot;
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Error loading map: " << e.what() << std::endl;
+            ZUUL_LOG_ERROR(Map, "Error loading map: {}", e.what());
+            return nullptr;
+        }
+    }
+
+    bool TileMap::loadSnapshot(MapSnapshot &&snapshot, AssetRegistry &assets)
+    {
+        // Textures are loaded here, on the render thread
+        std::vector<MapTileset> tilesets;
+        bool anyLoaded = false;
+        for (const auto &tileset : snapshot.tilesets)
+        {
+            tilesets.push_back({tileset.firstGid, tileset.data, {}, 0, 0, 0, false});
+            anyLoaded = tileset.data->finishLoading(assets) || anyLoaded;
+        }
+        dropTilesetsWithoutTexture(snapshot.gidTable, tilesets);
+
+        if (!anyLoaded)
+        {
+            ZUUL_LOG_ERROR(Map, "Failed to load tileset textures for {}", snapshot.filepath);
             return false;
         }
+
+        mFilepath = std::move(snapshot.filepath);
+        mWidth = snapshot.width;
+        mHeight = snapshot.height;
+        mTileWidth = snapshot.tileWidth;
+        mTileHeight = snapshot.tileHeight;
+        mTilesets = std::move(tilesets);
+        mGidTable = std::move(snapshot.gidTable);
+        mLayers = std::move(snapshot.layers);
+        mTiles = std::move(snapshot.tiles);
+        refreshTilesets();
+
+        // Clear baked composites
+        mCompositeAtlas.reset();
+        mCompositeStacks.clear();
+        mFlattenedLayerEnd = 0;
+
+        mItems.clear();
+        for (const auto &placement : snapshot.items)
+        {
+            mItems.emplace_back(placement.localId, placement.x, placement.y, mTilesets[placement.tileset].data);
+            // Set the collect callback for the newly created item
+            if (mItemCollectCallback)
+            {
+                mItems.back().setCollectCallback(mItemCollectCallback);
+            }
+        }
+
+        updateEntityLayer();
+        return true;
+    }
+
+    void TileMap::updateEntityLayer()
+    {
+        // Sprites share the first y-sorted layer, or go on top of all layers if there is none
+        mEntityLayer = static_cast<uint8_t>(mLayers.size());
+        for (size_t i = 0; i < mLayers.size(); ++i)
+        {
+            if (mLayers[i].ySorted)
+            {
+                mEntityLayer = static_cast<uint8_t>(i);
+                break;
+            }
+        }
+    }
+
+    void TileMap::refreshTilesets()
+    {
+        for (auto &tileset : mTilesets)
+        {
+            const TilesetInfo &info = tileset.data->getTilesetInfo();
+            tileset.texture = tileset.data->getTexture();
+            tileset.columns = info.columns;
+            tileset.tileWidth = info.tileWidth;
+            tileset.tileHeight = info.tileHeight;
+            tileset.oversized = info.tileWidth != mTileWidth || info.tileHeight != mTileHeight;
+        }
+
+        // Solid flags and collision boxes may have changed along with the tiles
+        rebuildColliders();
+
+        // Opacity, animations and images feed the per-chunk data and the baked composites
+        mContentGeneration++;
+        mChunkCells.clear();
+        mCompositeAtlas.reset();
+        mCompositeStacks.clear();
+    }
+
+    bool TileMap::patchFromSnapshot(MapSnapshot &&snapshot, AssetRegistry &assets)
+    {
+        bool sameStructure = snapshot.width == mWidth && snapshot.height == mHeight &&
+                             snapshot.tileWidth == mTileWidth && snapshot.tileHeight == mTileHeight &&
+                             snapshot.layers.size() == mLayers.size() &&
+                             snapshot.tilesets.size() == mTilesets.size() &&
+                             snapshot.tiles.getLayout() == mTiles.getLayout();
+        for (size_t i = 0; sameStructure && i < mTilesets.size(); ++i)
+        {
+            sameStructure = snapshot.tilesets[i].firstGid == mTilesets[i].firstGid &&
+                            snapshot.tilesets[i].data->getSourcePath() == mTilesets[i].data->getSourcePath();
+        }
+
+        // Resized maps or changed tilesets can't be patched cell by cell
+        if (!sameStructure)
+        {
+            ZUUL_LOG_INFO(Map, "Map structure changed, reloading {}", snapshot.filepath);
+            return loadSnapshot(std::move(snapshot), assets);
+        }
+
+        // Embedded tilesets are part of the map file; external ones reload on their own
+        bool tilesetsChanged = false;
+        for (size_t i = 0; i < mTilesets.size(); ++i)
+        {
+            if (mTilesets[i].data->getSourcePath().empty())
+            {
+                mTilesets[i].data->patchFrom(*snapshot.tilesets[i].data, assets);
+                tilesetsChanged = true;
+            }
+        }
+
+        bool layersChanged = false;
+        for (size_t i = 0; i < mLayers.size(); ++i)
+        {
+            const MapLayer &layer = snapshot.layers[i];
+            if (layer.name != mLayers[i].name || layer.visible != mLayers[i].visible || layer.ySorted != mLayers[i].ySorted)
+            {
+                mLayers[i] = layer;
+                layersChanged = true;
+            }
+        }
+
+        // Diff chunk by chunk; identical chunks are skipped with a single compare
+        std::vector<TileChange> changes;
+        const int layerCount = static_cast<int>(mLayers.size());
+        auto diffChunk = [&](int chunkX, int chunkY)
+        {
+            const TileGrid::Chunk *before = mTiles.findChunk(chunkX, chunkY);
+            const TileGrid::Chunk *after = snapshot.tiles.findChunk(chunkX, chunkY);
+            if (before && after && mTiles.sameTiles(*before, snapshot.tiles, *after))
+            {
+                return;
+            }
+
+            for (int cell = 0; cell < TileGrid::CHUNK_CELLS; ++cell)
+            {
+                int x = chunkX * TileGrid::CHUNK_SIZE + cell % TileGrid::CHUNK_SIZE;
+                int y = chunkY * TileGrid::CHUNK_SIZE + cell / TileGrid::CHUNK_SIZE;
+                for (int layerIndex = 0; layerIndex < layerCount; ++layerIndex)
+                {
+                    uint32_t gid = snapshot.tiles.getGid(layerIndex, x, y);
+                    if (gid != mTiles.getGid(layerIndex, x, y))
+                    {
+                        changes.push_back({layerIndex, x, y, gid});
+                    }
+                }
+            }
+        };
+        snapshot.tiles.forEachChunk([&](const TileGrid::Chunk &chunk) { diffChunk(chunk.chunkX, chunk.chunkY); });
+        mTiles.forEachChunk([&](const TileGrid::Chunk &chunk)
+        {
+            if (!snapshot.tiles.findChunk(chunk.chunkX, chunk.chunkY))
+            {
+                diffChunk(chunk.chunkX, chunk.chunkY);
+            }
+        });
+
+        // The gid table may have grown with the tilesets
+        dropTilesetsWithoutTexture(snapshot.gidTable, mTilesets);
+        mGidTable = std::move(snapshot.gidTable);
+        setTiles(changes);
+
+        if (tilesetsChanged)
+        {
+            refreshTilesets();
+        }
+        else if (layersChanged)
+        {
+            // Hidden layers are left out of the LOD images, so they are regenerated too
+            mContentGeneration++;
+            mChunkCells.clear();
+            uint8_t entityLayer = mEntityLayer;
+            updateEntityLayer();
+            if (entityLayer != mEntityLayer)
+            {
+                mCompositeAtlas.reset();
+                mCompositeStacks.clear();
+            }
+        }
+
+        ZUUL_LOG_INFO(Map, "Patched {} tiles in {}", changes.size(), snapshot.filepath);
+        return true;
     }
 
     void TileMap::update(float deltaTime)
     {
-        // Update animations in tileset
-        mTilesetData->update(deltaTime);
+        // Update animations in tilesets
+        for (auto &tileset : mTilesets)
+        {
+            tileset.data->update(deltaTime);
+        }
 
         // Update items
         for (auto &item : mItems)
@@ -150,13 +636,24 @@ namespace zuul
         }
     }
 
-    void TileMap::render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void TileMap::render(Renderer &renderer, float offsetX, float offsetY, float zoom)
     {
+        ZUUL_ALLOC_ZONE("TileMap::render");
+        mDrawQueue.clear();
+        queueTiles(mDrawQueue, offsetX, offsetY, zoom);
+        queueItems(mDrawQueue, offsetX, offsetY, zoom);
+        mDrawQueue.sort();
+        mDrawQueue.submit(renderer);
+    }
+
+    void TileMap::queueTiles(DrawQueue &queue, float offsetX, float offsetY, float zoom) const
+    {
+        ZUUL_ALLOC_ZONE("TileMap::queueTiles");
         // Calculate visible tile range based on zoom and offset
-        int startTileX = static_cast<int>(offsetX / (mTileWidth * zoom));
-        int startTileY = static_cast<int>(offsetY / (mTileHeight * zoom));
-        int endTileX = static_cast<int>((offsetX + mWindowWidth / zoom) / mTileWidth) + 2;   // Add extra column
-        int endTileY = static_cast<int>((offsetY + mWindowHeight / zoom) / mTileHeight) + 2; // Add extra row
+        int startTileX = static_cast<int>(std::floor(offsetX / mTileWidth));
+        int startTileY = static_cast<int>(std::floor(offsetY / mTileHeight));
+        int endTileX = static_cast<int>((offsetX + mWindowWidth / zoom) / mTileWidth) + 1;   // Add extra column
+        int endTileY = static_cast<int>((offsetY + mWindowHeight / zoom) / mTileHeight) + 1; // Add extra row
 
         // Clamp to map bounds
         startTileX = std::max(0, startTileX);
@@ -164,65 +661,101 @@ namespace zuul
         endTileX = std::min(mWidth, endTileX);
         endTileY = std::min(mHeight, endTileY);
 
-        // Constants for Tiled's tile flags
-        const unsigned FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
-        const unsigned FLIPPED_VERTICALLY_FLAG = 0x40000000;
-        const unsigned FLIPPED_DIAGONALLY_FLAG = 0x20000000;
-        const unsigned ALL_FLAGS = FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG;
+        const int layerCount = static_cast<int>(mLayers.size());
+        constexpr int CHUNK_SIZE = TileGrid::CHUNK_SIZE;
 
-        // Render each visible layer
-        for (const auto &layer : mLayers)
+        // Walk the visible part of each allocated chunk; the draw queue restores layer order afterwards
+        mTiles.forEachChunk(startTileX, startTileY, endTileX, endTileY, [&](const TileGrid::Chunk &chunk)
         {
-            if (layer.visible)
+            const int firstX = std::max(startTileX, chunk.chunkX * CHUNK_SIZE);
+            const int firstY = std::max(startTileY, chunk.chunkY * CHUNK_SIZE);
+            const int lastX = std::min(endTileX, (chunk.chunkX + 1) * CHUNK_SIZE);
+            const int lastY = std::min(endTileY, (chunk.chunkY + 1) * CHUNK_SIZE);
+
+            const ChunkCells &cells = getChunkCells(chunk);
+
+            // Neighbouring tiles share their screen edges, so there are no seams at any zoom
+            int columnEdges[CHUNK_SIZE + 1];
+            for (int x = firstX; x <= lastX; ++x)
+            {
+                columnEdges[x - firstX] = static_cast<int>(std::floor((x * mTileWidth - offsetX) * zoom));
+            }
+
+            for (int y = firstY; y < lastY; ++y)
             {
-                for (int y = startTileY; y < endTileY; ++y)
+                int destY = static_cast<int>(std::floor((y * mTileHeight - offsetY) * zoom));
+                int destH = static_cast<int>(std::floor(((y + 1) * mTileHeight - offsetY) * zoom)) - destY;
+
+                // Y-sorted tiles are ordered by their bottom edge, everything else keeps layer order
+                int32_t rowDepth = (y + 1) * mTileHeight;
+
+                for (int x = firstX; x < lastX; ++x)
                 {
-                    for (int x = startTileX; x < endTileX; ++x)
+                    int destX = columnEdges[x - firstX];
+                    int destW = columnEdges[x - firstX + 1] - destX;
+
+                    // Tiles below an opaque tile on a higher layer are hidden
+                    const int cell = TileGrid::cellOf(x, y);
+                    int firstLayer = cells.firstVisibleLayer[cell];
+
+                    // A baked composite replaces every tile below mFlattenedLayerEnd
+                    if (mCompositeAtlas && cells.composite[cell] != TileGrid::NO_COMPOSITE)
                     {
-                        unsigned int gid = layer.tileData[y * mWidth + x];
-                        if (gid > 0)
+                        int composite = cells.composite[cell];
+                        queue.push(0, 0, mCompositeAtlas.get(),
+                                   (composite % mCompositeColumns) * mTileWidth,
+                                   (composite / mCompositeColumns) * mTileHeight,
+                                   mTileWidth, mTileHeight,
+                                   destX, destY, destW, destH);
+                        firstLayer = std::max<int>(firstLayer, mFlattenedLayerEnd);
+                    }
+
+                    for (int layerIndex = firstLayer; layerIndex < layerCount; ++layerIndex)
+                    {
+                        const auto &layer = mLayers[layerIndex];
+                        int tileId = 0;
+                        const MapTileset *tileset = resolveTile(mTiles.getTile(chunk, layerIndex, cell), tileId);
+                        if (!tileset || !layer.visible)
                         {
-                            // Extract the actual tile ID (remove flip flags)
-                            int tileId = (gid & ~ALL_FLAGS) - 1; // Convert to 0-based
-
-                            // Get current animation frame if tile is animated
-                            if (mTilesetData->hasAnimation(tileId))
-                            {
-                                tileId = mTilesetData->getCurrentTileId(tileId);
-                            }
-
-                            // Calculate source rectangle in tileset
-                            const auto &tilesetInfo = mTilesetData->getTilesetInfo();
-                            int srcX = (tileId % tilesetInfo.columns) * mTileWidth;
-                            int srcY = (tileId / tilesetInfo.columns) * mTileHeight;
-
-                            // Calculate destination rectangle with zoom
-                            // Use floor for position and ceil for dimensions to prevent gaps
-                            float destX = std::floor((x * mTileWidth - offsetX) * zoom);
-                            float destY = std::floor((y * mTileHeight - offsetY) * zoom);
-                            int destW = static_cast<int>(std::ceil((x + 1) * mTileWidth * zoom) - std::floor(x * mTileWidth * zoom));
-                            int destH = static_cast<int>(std::ceil((y + 1) * mTileHeight * zoom) - std::floor(y * mTileHeight * zoom));
-
-                            renderer->renderTexture(mTileset,
-                                                    srcX, srcY, mTileWidth, mTileHeight,
-                                                    static_cast<int>(destX),
-                                                    static_cast<int>(destY),
-                                                    destW, destH);
+                            continue;
                         }
+
+                        // Get current animation frame if tile is animated
+                        if (tileset->data->hasAnimation(tileId))
+                        {
+                            tileId = tileset->data->getCurrentTileId(tileId);
+                        }
+
+                        int srcX = (tileId % tileset->columns) * tileset->tileWidth;
+                        int srcY = (tileId / tileset->columns) * tileset->tileHeight;
+
+                        // The first y-sorted layer has the same index as the entity layer
+                        if (!tileset->oversized)
+                        {
+                            queue.push(static_cast<uint8_t>(layerIndex), layer.ySorted ? rowDepth : 0, tileset->texture,
+                                       srcX, srcY, mTileWidth, mTileHeight,
+                                       destX, destY, destW, destH);
+                            continue;
+                        }
+
+                        // Tiles of a different size are anchored at the bottom left of the cell, like Tiled does
+                        int width = static_cast<int>(tileset->tileWidth * zoom);
+                        int height = static_cast<int>(tileset->tileHeight * zoom);
+                        queue.push(static_cast<uint8_t>(layerIndex), layer.ySorted ? rowDepth : 0, tileset->texture,
+                                   srcX, srcY, tileset->tileWidth, tileset->tileHeight,
+                                   destX, destY + destH - height, width, height);
                     }
                 }
             }
-        }
-
-        // Render items
-        renderItems(renderer, offsetX, offsetY, zoom);
+        });
     }
 
-    void TileMap::renderItems(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void TileMap::queueItems(DrawQueue &queue, float offsetX, float offsetY, float zoom) const
     {
-        for (auto &item : mItems)
+        ZUUL_ALLOC_ZONE("TileMap::queueItems");
+        for (const auto &item : mItems)
         {
-            item.render(renderer, offsetX, offsetY, zoom);
+            item.queue(queue, mEntityLayer, offsetX, offsetY, zoom);
         }
     }
 
@@ -237,11 +770,11 @@ namespace zuul
         }
     }
 
-    void TileMap::renderDebugCollisions(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void TileMap::renderDebugCollisions(Renderer &renderer, float offsetX, float offsetY, float zoom)
     {
         // Calculate visible tile range based on zoom and offset
-        int startTileX = static_cast<int>(offsetX / (mTileWidth * zoom));
-        int startTileY = static_cast<int>(offsetY / (mTileHeight * zoom));
+        int startTileX = static_cast<int>(std::floor(offsetX / mTileWidth));
+        int startTileY = static_cast<int>(std::floor(offsetY / mTileHeight));
         int endTileX = static_cast<int>((offsetX + mWindowWidth / zoom) / mTileWidth) + 1;
         int endTileY = static_cast<int>((offsetY + mWindowHeight / zoom) / mTileHeight) + 1;
 
@@ -251,27 +784,42 @@ namespace zuul
         endTileX = std::min(mWidth, endTileX);
         endTileY = std::min(mHeight, endTileY);
 
+        // Draw green borders for the merged colliders that are actually tested
+        for (const auto &collider : getCollisionWorld().getColliders())
+        {
+            if (collider.x < endTileX * mTileWidth && collider.x + collider.width > startTileX * mTileWidth &&
+                collider.y < endTileY * mTileHeight && collider.y + collider.height > startTileY * mTileHeight)
+            {
+                renderer.renderRect(static_cast<int>((collider.x - offsetX) * zoom),
+                                    static_cast<int>((collider.y - offsetY) * zoom),
+                                    static_cast<int>(collider.width * zoom),
+                                    static_cast<int>(collider.height * zoom),
+                                    0, 255, 0, 255);
+            }
+        }
+
         // Render debug info for each visible layer
-        for (const auto &layer : mLayers)
+        for (size_t layerIndex = 0; layerIndex < mLayers.size(); ++layerIndex)
         {
-            if (!layer.visible)
+            if (!mLayers[layerIndex].visible)
                 continue;
 
             for (int y = startTileY; y < endTileY; ++y)
             {
                 for (int x = startTileX; x < endTileX; ++x)
                 {
-                    int globalTileId = layer.tileData[y * mWidth + x];
-                    if (globalTileId > 0)
+                    int localTileId = 0;
+                    const MapTileset *tileset = resolveTile(mTiles.getTile(static_cast<int>(layerIndex), x, y), localTileId);
+                    if (tileset)
                     {
-                        int localTileId = globalTileId - 1;
                         float tileWorldX = (x * mTileWidth - offsetX) * zoom;
                         float tileWorldY = (y * mTileHeight - offsetY) * zoom;
+                        float imageTop = (y + 1) * mTileHeight - tileset->tileHeight;
 
                         // Draw red border for solid tiles
-                        if (mTilesetData->isSolid(localTileId))
+                        if (tileset->data->isSolid(localTileId))
                         {
-                            renderer->renderRect(
+                            renderer.renderRect(
                                 static_cast<int>(tileWorldX),
                                 static_cast<int>(tileWorldY),
                                 static_cast<int>(mTileWidth * zoom),
@@ -281,12 +829,12 @@ namespace zuul
                         }
 
                         // Draw yellow border for collision boxes
-                        const auto *box = mTilesetData->getCollisionBox(localTileId);
+                        const auto *box = tileset->data->getCollisionBox(localTileId);
                         if (box != nullptr)
                         {
-                            renderer->renderRect(
+                            renderer.renderRect(
                                 static_cast<int>((x * mTileWidth + box->x - offsetX) * zoom),
-                                static_cast<int>((y * mTileHeight + box->y - offsetY) * zoom),
+                                static_cast<int>((imageTop + box->y - offsetY) * zoom),
                                 static_cast<int>(box->width * zoom),
                                 static_cast<int>(box->height * zoom),
                                 255, 255, 0, 255 // Yellow
@@ -300,69 +848,392 @@ namespace zuul
 
     bool TileMap::checkCollision(float x, float y, float width, float height) const
     {
-        // Constants for Tiled's tile flags
-        const unsigned FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
-        const unsigned FLIPPED_VERTICALLY_FLAG = 0x40000000;
-        const unsigned FLIPPED_DIAGONALLY_FLAG = 0x20000000;
-        const unsigned ALL_FLAGS = FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG;
+        return getCollisionWorld().overlaps({x, y, width, height});
+    }
+
+    void TileMap::rebuildColliders()
+    {
+        mChunkColliders.clear();
+        mDirtyColliderChunks.clear();
+        mTiles.forEachChunk([this](const TileGrid::Chunk &chunk) { rebuildChunkColliders(chunk.chunkX, chunk.chunkY); });
+        buildCollisionWorld();
+    }
 
-        // Convert world coordinates to tile coordinates
-        int startTileX = static_cast<int>(x / mTileWidth);
-        int startTileY = static_cast<int>(y / mTileHeight);
-        int endTileX = static_cast<int>((x + width - 1) / mTileWidth); // -1 to make it inclusive
-        int endTileY = static_cast<int>((y + height - 1) / mTileHeight);
+    void TileMap::updateCollision() const
+    {
+        for (const auto &[chunkX, chunkY] : mDirtyColliderChunks)
+        {
+            rebuildChunkColliders(chunkX, chunkY);
+        }
+        mDirtyColliderChunks.clear();
+        buildCollisionWorld();
+    }
+
+    void TileMap::buildCollisionWorld() const
+    {
+        std::vector<CollisionBox> colliders;
+        for (const auto &[chunk, boxes] : mChunkColliders)
+        {
+            colliders.insert(colliders.end(), boxes.begin(), boxes.end());
+        }
+        mCollision.build(std::move(colliders));
+    }
+
+    void TileMap::rebuildChunkColliders(int chunkX, int chunkY) const
+    {
+        constexpr int CHUNK_SIZE = TileGrid::CHUNK_SIZE;
+        const TileGrid::Chunk *chunk = mTiles.findChunk(chunkX, chunkY);
+        if (!chunk)
+        {
+            mChunkColliders.erase({chunkX, chunkY});
+            return;
+        }
 
-        // Check each potentially colliding tile
-        for (int tileY = startTileY; tileY <= endTileY; ++tileY)
+        // Collision boxes as they are, solid tiles as cells, on every layer
+        std::vector<CollisionBox> colliders;
+        std::array<bool, TileGrid::CHUNK_CELLS> solid{};
+        const int layerCount = static_cast<int>(mLayers.size());
+        for (int cell = 0; cell < TileGrid::CHUNK_CELLS; ++cell)
         {
-            for (int tileX = startTileX; tileX <= endTileX; ++tileX)
+            int tileX = chunkX * CHUNK_SIZE + cell % CHUNK_SIZE;
+            int tileY = chunkY * CHUNK_SIZE + cell / CHUNK_SIZE;
+            for (int layerIndex = 0; layerIndex < layerCount; ++layerIndex)
             {
-                if (tileX >= 0 && tileX < mWidth && tileY >= 0 && tileY < mHeight)
+                int tileId = 0;
+                const MapTileset *tileset = resolveTile(mTiles.getTile(*chunk, layerIndex, cell), tileId);
+                if (!tileset)
                 {
-                    for (const auto &layer : mLayers)
+                    continue;
+                }
+
+                solid[cell] = solid[cell] || tileset->data->isSolid(tileId);
+                if (const CollisionBox *box = tileset->data->getCollisionBox(tileId))
+                {
+                    // Boxes are relative to the tile image, which is bottom aligned in the cell
+                    colliders.push_back({tileX * static_cast<float>(mTileWidth) + box->x,
+                                         (tileY + 1) * static_cast<float>(mTileHeight) - tileset->tileHeight + box->y,
+                                         box->width, box->height});
+                }
+            }
+        }
+
+        // Greedy rectangle merging of solid cells: grow each unclaimed cell right as far
+        // as possible, then down while the whole span below is solid and unclaimed
+        std::array<bool, TileGrid::CHUNK_CELLS> claimed{};
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+        {
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+            {
+                if (!solid[y * CHUNK_SIZE + x] || claimed[y * CHUNK_SIZE + x])
+                {
+                    continue;
+                }
+
+                int width = 1;
+                while (x + width < CHUNK_SIZE && solid[y * CHUNK_SIZE + x + width] && !claimed[y * CHUNK_SIZE + x + width])
+                {
+                    width++;
+                }
+
+                int height = 1;
+                while (y + height < CHUNK_SIZE)
+                {
+                    bool spanFree = true;
+                    for (int i = x; i < x + width && spanFree; ++i)
                     {
-                        unsigned int gid = layer.tileData[tileY * mWidth + tileX];
-                        if (gid > 0)
-                        {
-                            // Extract the actual tile ID (remove flip flags)
-                            int tileId = (gid & ~ALL_FLAGS) - 1; // Convert to 0-based
-
-                            // Check if tile is solid
-                            if (mTilesetData->isSolid(tileId))
-                            {
-                                // Do a precise AABB collision check
-                                float tileLeft = tileX * mTileWidth;
-                                float tileRight = tileLeft + mTileWidth - 1; // -1 for inclusive bounds
-                                float tileTop = tileY * mTileHeight;
-                                float tileBottom = tileTop + mTileHeight - 1;
-
-                                if (x <= tileRight && x + width - 1 >= tileLeft &&
-                                    y <= tileBottom && y + height - 1 >= tileTop)
-                                {
-                                    return true;
-                                }
-                            }
-
-                            // Check collision box if present
-                            if (const CollisionBox *box = mTilesetData->getCollisionBox(tileId))
-                            {
-                                float boxLeft = tileX * mTileWidth + box->x;
-                                float boxRight = boxLeft + box->width - 1; // -1 for inclusive bounds
-                                float boxTop = tileY * mTileHeight + box->y;
-                                float boxBottom = boxTop + box->height - 1;
-
-                                if (x <= boxRight && x + width - 1 >= boxLeft &&
-                                    y <= boxBottom && y + height - 1 >= boxTop)
-                                {
-                                    return true;
-                                }
-                            }
-                        }
+                        int cell = (y + height) * CHUNK_SIZE + i;
+                        spanFree = solid[cell] && !claimed[cell];
+                    }
+                    if (!spanFree)
+                    {
+                        break;
+                    }
+                    height++;
+                }
+
+                for (int row = y; row < y + height; ++row)
+                {
+                    std::fill_n(claimed.begin() + row * CHUNK_SIZE + x, width, true);
+                }
+                colliders.push_back({static_cast<float>((chunkX * CHUNK_SIZE + x) * mTileWidth),
+                                     static_cast<float>((chunkY * CHUNK_SIZE + y) * mTileHeight),
+                                     static_cast<float>(width * mTileWidth),
+                                     static_cast<float>(height * mTileHeight)});
+            }
+        }
+
+        // Boxes repeated along a fence or wall touch each other: join them into rows, then
+        // stack rows that line up
+        auto mergeTouching = [&colliders](bool horizontal)
+        {
+            auto along = [horizontal](const CollisionBox &box) { return horizontal ? box.x : box.y; };
+            auto alongSize = [horizontal](const CollisionBox &box) { return horizontal ? box.width : box.height; };
+            auto across = [horizontal](const CollisionBox &box) { return horizontal ? box.y : box.x; };
+            auto acrossSize = [horizontal](const CollisionBox &box) { return horizontal ? box.height : box.width; };
+
+            std::sort(colliders.begin(), colliders.end(), [&](const CollisionBox &a, const CollisionBox &b)
+                      { return std::make_tuple(across(a), acrossSize(a), along(a)) < std::make_tuple(across(b), acrossSize(b), along(b)); });
+
+            std::vector<CollisionBox> merged;
+            for (const auto &box : colliders)
+            {
+                if (!merged.empty())
+                {
+                    CollisionBox &last = merged.back();
+                    float lastEnd = along(last) + alongSize(last);
+                    if (across(last) == across(box) && acrossSize(last) == acrossSize(box) && along(box) <= lastEnd)
+                    {
+                        float end = std::max(lastEnd, along(box) + alongSize(box));
+                        (horizontal ? last.width : last.height) = end - along(last);
+                        continue;
                     }
                 }
+                merged.push_back(box);
+            }
+            colliders = std::move(merged);
+        };
+        mergeTouching(true);
+        mergeTouching(false);
+
+        if (colliders.empty())
+        {
+            mChunkColliders.erase({chunkX, chunkY});
+        }
+        else
+        {
+            mChunkColliders[{chunkX, chunkY}] = std::move(colliders);
+        }
+    }
+
+    uint8_t TileMap::findFirstVisibleLayer(const TileGrid::Chunk &chunk, int cell) const
+    {
+        // Walk down from the top layer until a tile covers the whole cell. Only tiles of
+        // the map's grid size cover exactly their cell.
+        int covering = 0;
+        for (int layerIndex = static_cast<int>(mLayers.size()) - 1; layerIndex > 0; --layerIndex)
+        {
+            if (!mLayers[layerIndex].visible)
+            {
+                continue;
+            }
+
+            int tileId = 0;
+            const MapTileset *tileset = resolveTile(mTiles.getTile(chunk, layerIndex, cell), tileId);
+            if (tileset && !tileset->oversized && tileset->data->isOpaque(tileId))
+            {
+                covering = layerIndex;
+                break;
             }
         }
-        return false;
+
+        // Oversized tiles reach into neighbouring cells, so they are never culled
+        for (int layerIndex = 0; layerIndex < covering; ++layerIndex)
+        {
+            int tileId = 0;
+            const MapTileset *tileset = resolveTile(mTiles.getTile(chunk, layerIndex, cell), tileId);
+            if (mLayers[layerIndex].visible && tileset && tileset->oversized)
+            {
+                return static_cast<uint8_t>(layerIndex);
+            }
+        }
+        return static_cast<uint8_t>(covering);
+    }
+
+    bool TileMap::findStaticStack(const TileGrid::Chunk &chunk, int cell, int firstLayer, std::vector<uint16_t> &stack) const
+    {
+        stack.clear();
+        for (int layerIndex = firstLayer; layerIndex < mFlattenedLayerEnd; ++layerIndex)
+        {
+            uint16_t tile = mTiles.getTile(chunk, layerIndex, cell);
+            int tileId = 0;
+            const MapTileset *tileset = resolveTile(tile, tileId);
+            if (!mLayers[layerIndex].visible || !tileset)
+            {
+                continue;
+            }
+
+            // Cells with animated or oversized tiles are left to the regular render path
+            if (tileset->oversized || tileset->data->hasAnimation(tileId))
+            {
+                return false;
+            }
+            stack.push_back(tile);
+        }
+
+        // A single tile is already one draw
+        return stack.size() >= 2;
+    }
+
+    const TileMap::ChunkCells &TileMap::getChunkCells(const TileGrid::Chunk &chunk) const
+    {
+        auto [it, created] = mChunkCells.try_emplace(TileGrid::keyOf(chunk.chunkX, chunk.chunkY));
+        if (created || chunk.dirty)
+        {
+            refreshChunk(chunk, it->second);
+        }
+        return it->second;
+    }
+
+    void TileMap::refreshChunk(const TileGrid::Chunk &chunk, ChunkCells &cells) const
+    {
+        std::vector<uint16_t> stack;
+        for (int cell = 0; cell < TileGrid::CHUNK_CELLS; ++cell)
+        {
+            cells.firstVisibleLayer[cell] = findFirstVisibleLayer(chunk, cell);
+
+            // Edited cells keep a composite only if their new stack was baked before
+            cells.composite[cell] = TileGrid::NO_COMPOSITE;
+            if (mCompositeAtlas && findStaticStack(chunk, cell, cells.firstVisibleLayer[cell], stack))
+            {
+                auto it = mCompositeStacks.find(stack);
+                if (it != mCompositeStacks.end())
+                {
+                    cells.composite[cell] = static_cast<uint16_t>(it->second);
+                }
+            }
+        }
+        chunk.dirty = false;
+    }
+
+    bool TileMap::setTile(int layer, int x, int y, uint32_t gid)
+    {
+        TileChange change{layer, x, y, gid};
+        return setTiles({&change, 1}) == 1;
+    }
+
+    size_t TileMap::setTiles(std::span<const TileChange> changes)
+    {
+        std::vector<TileChange> applied;
+        applied.reserve(changes.size());
+
+        for (const auto &change : changes)
+        {
+            if (change.layer < 0 || change.layer >= static_cast<int>(mLayers.size()) ||
+                change.x < 0 || change.x >= mWidth || change.y < 0 || change.y >= mHeight)
+            {
+                continue;
+            }
+
+            uint32_t tileId = change.gid & ~ALL_FLIP_FLAGS;
+            if (tileId >= mGidTable.size() || (tileId != 0 && mGidTable[tileId].tileset == GidEntry::NO_TILESET))
+            {
+                continue;
+            }
+
+            if (mTiles.setGid(change.layer, change.x, change.y, change.gid))
+            {
+                applied.push_back(change);
+            }
+        }
+
+        if (!applied.empty())
+        {
+            // Colliders are merged per chunk, so only the touched chunks are rebuilt, on
+            // the next collision query
+            for (const auto &change : applied)
+            {
+                mDirtyColliderChunks.insert({change.x >> 4, change.y >> 4});
+            }
+
+            for (const auto &callback : mTileChangeCallbacks)
+            {
+                callback(applied);
+            }
+        }
+        return applied.size();
+    }
+
+    void TileMap::addTileChangeCallback(std::function<void(std::span<const TileChange>)> callback)
+    {
+        mTileChangeCallbacks.push_back(std::move(callback));
+    }
+
+    bool TileMap::bakeCompositeTiles(AssetRegistry &assets)
+    {
+        Renderer &renderer = assets.getRenderer();
+        // Keep the atlas within a texture size every backend supports
+        const int ATLAS_COLUMNS = 32;
+        const int MAX_COMPOSITES = std::min<int>(ATLAS_COLUMNS * (4096 / std::max(1, mTileHeight)),
+                                                 TileGrid::NO_COMPOSITE);
+
+        mCompositeAtlas.reset();
+        mCompositeStacks.clear();
+        mChunkCells.clear();
+
+        // Only layers below the entity layer are never y-sorted or drawn over sprites
+        mFlattenedLayerEnd = static_cast<uint8_t>(std::min<size_t>(mEntityLayer, mLayers.size()));
+        if (mFlattenedLayerEnd < 2)
+        {
+            return true;
+        }
+
+        // Find the unique stacks of static tiles
+        std::vector<const std::vector<uint16_t> *> stacks;
+        std::vector<uint16_t> stack;
+        int bakedCells = 0;
+
+        mTiles.forEachChunk([&](const TileGrid::Chunk &chunk)
+        {
+            for (int cell = 0; cell < TileGrid::CHUNK_CELLS; ++cell)
+            {
+                if (!findStaticStack(chunk, cell, findFirstVisibleLayer(chunk, cell), stack))
+                {
+                    continue;
+                }
+
+                auto it = mCompositeStacks.find(stack);
+                if (it == mCompositeStacks.end())
+                {
+                    if (static_cast<int>(stacks.size()) >= MAX_COMPOSITES)
+                    {
+                        continue;
+                    }
+                    it = mCompositeStacks.emplace(stack, static_cast<int>(stacks.size())).first;
+                    stacks.push_back(&it->first);
+                }
+                bakedCells++;
+            }
+        });
+
+        if (stacks.empty())
+        {
+            return true;
+        }
+
+        // Composite every stack once into the atlas
+        mCompositeColumns = ATLAS_COLUMNS;
+        int rows = (static_cast<int>(stacks.size()) + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+        mCompositeAtlas = assets.createRenderTarget(ATLAS_COLUMNS * mTileWidth, rows * mTileHeight);
+        if (!mCompositeAtlas || !renderer.setRenderTarget(mCompositeAtlas.get()))
+        {
+            ZUUL_LOG_ERROR(Map, "Failed to create composite tile atlas");
+            mCompositeAtlas.reset();
+            mCompositeStacks.clear();
+            return false;
+        }
+
+        renderer.clear({0, 0, 0, 0});
+
+        for (size_t composite = 0; composite < stacks.size(); ++composite)
+        {
+            int destX = static_cast<int>(composite % ATLAS_COLUMNS) * mTileWidth;
+            int destY = static_cast<int>(composite / ATLAS_COLUMNS) * mTileHeight;
+
+            for (uint16_t tile : *stacks[composite])
+            {
+                int tileId = 0;
+                const MapTileset *tileset = resolveTile(tile, tileId);
+                renderer.renderTexture(tileset->texture,
+                                       (tileId % tileset->columns) * mTileWidth, (tileId / tileset->columns) * mTileHeight,
+                                       mTileWidth, mTileHeight,
+                                       destX, destY, mTileWidth, mTileHeight);
+            }
+        }
+
+        renderer.setRenderTarget({});
+
+        ZUUL_LOG_INFO(Map, "Baked {} composite tiles for {} cells", stacks.size(), bakedCells);
+        return true;
     }
 
     std::pair<int, int> TileMap::worldToTile(float x, float y) const
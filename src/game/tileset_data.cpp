@@ -1,101 +1,329 @@
 #include <game/tileset_data.hpp>
-#include <nlohmann/json.hpp>
-#include <fstream>
-#include <iostream>
+#include <engine/file_system.hpp>
+#include <engine/log.hpp>
+#include <game/tiled_reader.hpp>
+#include <algorithm>
+#include <filesystem>
 #include <cmath>
+#include <cstring>
+#include <SDL2/SDL_image.h>
 
 using json = nlohmann::json;
 
 namespace zuul
 {
+    namespace
+    {
+        // Pixels of an image in ARGB8888, from the pack if it has them decoded, or nullptr
+        std::shared_ptr<TilesetImage> decodeImage(const std::string &imagePath)
+        {
+            auto image = std::make_shared<TilesetImage>();
+            PackImage packed;
+            if (getFileSystem().readImage(imagePath, packed))
+            {
+                image->width = packed.width;
+                image->height = packed.height;
+                image->pixels.assign(packed.pixels, packed.pixels + static_cast<size_t>(packed.width) * packed.height);
+                return image;
+            }
 
-    bool TilesetData::loadFromFile(const std::string &filepath, std::shared_ptr<Renderer> renderer)
+            SDL_Surface *loaded = IMG_Load(imagePath.c_str());
+            if (!loaded)
+            {
+                ZUUL_LOG_ERROR(Assets, "Unable to load image {}! SDL_image Error: {}", imagePath, IMG_GetError());
+                return nullptr;
+            }
+            SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+            SDL_FreeSurface(loaded);
+            if (!surface)
+            {
+                return nullptr;
+            }
+
+            SDL_LockSurface(surface);
+            const auto *pixels = static_cast<const uint8_t *>(surface->pixels);
+            image->width = surface->w;
+            image->height = surface->h;
+            image->pixels.resize(static_cast<size_t>(surface->w) * surface->h);
+            for (int y = 0; y < surface->h; ++y)
+            {
+                std::memcpy(image->pixels.data() + static_cast<size_t>(y) * surface->w,
+                            pixels + static_cast<size_t>(y) * surface->pitch, surface->w * sizeof(uint32_t));
+            }
+            SDL_UnlockSurface(surface);
+            SDL_FreeSurface(surface);
+            return image;
+        }
+    }
+
+    bool TilesetData::loadFromFile(const std::string &filepath, AssetRegistry &assets)
+    {
+        return readFromFile(filepath) && finishLoading(assets);
+    }
+
+    bool TilesetData::readFromFile(const std::string &filepath)
     {
         try
         {
-            std::ifstream file(filepath);
-            if (!file.is_open())
+            mAnimations.clear();
+            mCollisionBoxes.clear();
+            mSolidTiles.clear();
+
+            bool read = readTiledFile(filepath, [this](const TiledPath &path, TiledObject &object)
+                                      { readObject(path, object); });
+            if (!read)
             {
-                std::cerr << "Failed to open tileset file: " << filepath << std::endl;
+                ZUUL_LOG_ERROR(Assets, "Failed to read tileset file: {}", filepath);
                 return false;
             }
 
-            json tilesetJson;
-            file >> tilesetJson;
+            mSourcePath = std::filesystem::path(filepath).lexically_normal().string();
+            resolveImagePath(std::filesystem::path(filepath).parent_path().string());
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            ZUUL_LOG_ERROR(Assets, "Error loading tileset data: {}", e.what());
+            return false;
+        }
+    }
 
-            // Load tileset info
-            mTilesetInfo.columns = tilesetJson["columns"].get<int>();
-            mTilesetInfo.tileWidth = tilesetJson["tilewidth"].get<int>();
-            mTilesetInfo.tileHeight = tilesetJson["tileheight"].get<int>();
-            mTilesetInfo.imagePath = tilesetJson["image"].get<std::string>();
+    void TilesetData::readObject(const TiledPath &path, TiledObject &object)
+    {
+        const json &fields = object.fields;
 
-            // Load the tileset texture
-            std::string fullImagePath = "assets/" + mTilesetInfo.imagePath;
-            mTexture = renderer->loadTexture(fullImagePath);
-            if (!mTexture)
+        if (path.is({"tiles", "animation"}))
+        {
+            // Load animation data
+            AnimationFrame newFrame;
+            newFrame.tileId = fields["tileid"].get<int>();
+            newFrame.duration = fields["duration"].get<float>() / 1000.0f;
+            mPendingAnimation.frames.push_back(newFrame);
+        }
+        else if (path.is({"tiles", "objectgroup", "objects"}))
+        {
+            // Load collision data
+            if (fields.value("name", "") == "collision_box")
             {
-                std::cerr << "Failed to load tileset texture: " << fullImagePath << std::endl;
-                return false;
+                CollisionBox box;
+                box.x = fields["x"].get<float>();
+                box.y = fields["y"].get<float>();
+                box.width = fields["width"].get<float>();
+                box.height = fields["height"].get<float>();
+                mPendingCollisionBox = box;
+            }
+        }
+        else if (path.is({"tiles", "properties"}))
+        {
+            // Load solid property
+            if (fields["name"] == "solid" && fields["type"] == "bool")
+            {
+                mPendingSolid = fields["value"].get<bool>();
             }
+        }
+        else if (path.is({"tiles"}))
+        {
+            int id = fields["id"].get<int>();
+            if (!mPendingAnimation.frames.empty())
+            {
+                mAnimations[id] = std::move(mPendingAnimation);
+            }
+            if (mPendingCollisionBox)
+            {
+                mCollisionBoxes[id] = *mPendingCollisionBox;
+            }
+            if (mPendingSolid)
+            {
+                mSolidTiles[id] = *mPendingSolid;
+            }
+            mPendingAnimation = TileAnimation();
+            mPendingCollisionBox.reset();
+            mPendingSolid.reset();
+        }
+        else if (path.is({}))
+        {
+            // Load tileset info
+            mTilesetInfo.columns = fields["columns"].get<int>();
+            mTilesetInfo.tileWidth = fields["tilewidth"].get<int>();
+            mTilesetInfo.tileHeight = fields["tileheight"].get<int>();
+            mTilesetInfo.tileCount = fields["tilecount"].get<int>();
+            mTilesetInfo.imagePath = fields["image"].get<std::string>();
+        }
+    }
+
+    void TilesetData::resolveImagePath(const std::string &directory)
+    {
+        // Tiled stores the image relative to the tileset
+        mImagePath = (std::filesystem::path(directory) / mTilesetInfo.imagePath).lexically_normal().string();
+    }
+
+    bool TilesetData::finishLoading(AssetRegistry &assets)
+    {
+        return loadImage(assets, false);
+    }
+
+    bool TilesetData::loadImage(AssetRegistry &assets, bool reload)
+    {
+        // Textures can't be read back, so the image is decoded here once and the same
+        // pixels feed both the texture and the opacity analysis
+        std::shared_ptr<TilesetImage> image = decodeImage(mImagePath);
+        if (!image)
+        {
+            ZUUL_LOG_ERROR(Assets, "Failed to load tileset image: {}", mImagePath);
+            return false;
+        }
+
+        // The registry would hand out the cached texture, so refresh that first
+        if (reload && !assets.reloadTexture(mImagePath, image->width, image->height, image->pixels.data()))
+        {
+            return false;
+        }
 
-            // Process each tile's data
-            const auto &tiles = tilesetJson["tiles"];
-            for (const auto &tile : tiles)
+        // Tilesets sharing an image share its texture
+        TextureAsset texture = assets.loadTexture(mImagePath, image->width, image->height, image->pixels.data());
+        if (!texture)
+        {
+            ZUUL_LOG_ERROR(Assets, "Failed to load tileset texture: {}", mImagePath);
+            return false;
+        }
+        mTexture = std::move(texture);
+        mImage = std::move(image);
+
+        // Classify tile opacity once, after the animations are known
+        analyseOpacity();
+        return true;
+    }
+
+    bool TilesetData::patchFrom(const TilesetData &other, AssetRegistry &assets)
+    {
+        const bool layoutChanged = other.mImagePath != mImagePath ||
+                                   other.mTilesetInfo.columns != mTilesetInfo.columns ||
+                                   other.mTilesetInfo.tileWidth != mTilesetInfo.tileWidth ||
+                                   other.mTilesetInfo.tileHeight != mTilesetInfo.tileHeight;
+        mTilesetInfo = other.mTilesetInfo;
+        mImagePath = other.mImagePath;
+
+        // Only replace the tiles that changed, so untouched animations keep running in step
+        bool animationsChanged = false;
+        for (auto it = mAnimations.begin(); it != mAnimations.end();)
+        {
+            if (other.mAnimations.find(it->first) == other.mAnimations.end())
             {
-                int id = tile["id"].get<int>();
+                it = mAnimations.erase(it);
+                animationsChanged = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (const auto &[id, animation] : other.mAnimations)
+        {
+            auto it = mAnimations.find(id);
+            bool same = it != mAnimations.end() && it->second.frames.size() == animation.frames.size() &&
+                        std::equal(animation.frames.begin(), animation.frames.end(), it->second.frames.begin(),
+                                   [](const AnimationFrame &a, const AnimationFrame &b)
+                                   { return a.tileId == b.tileId && a.duration == b.duration; });
+            if (!same)
+            {
+                mAnimations[id] = animation;
+                animationsChanged = true;
+            }
+        }
 
-                // Load animation data
-                if (tile.contains("animation"))
-                {
-                    TileAnimation animation;
-                    for (const auto &frame : tile["animation"])
-                    {
-                        AnimationFrame newFrame;
-                        newFrame.tileId = frame["tileid"].get<int>();
-                        newFrame.duration = frame["duration"].get<float>() / 1000.0f;
-                        animation.frames.push_back(newFrame);
-                    }
-                    mAnimations[id] = animation;
-                }
+        // Collision data is small and has no running state
+        mCollisionBoxes = other.mCollisionBoxes;
+        mSolidTiles = other.mSolidTiles;
+
+        if (layoutChanged)
+        {
+            return reloadImage(assets);
+        }
+        if (animationsChanged && mImage)
+        {
+            analyseOpacity();
+        }
+        return true;
+    }
+
+    bool TilesetData::reloadImage(AssetRegistry &assets)
+    {
+        // Keeps the old image on failure rather than drawing nothing
+        return loadImage(assets, true);
+    }
+
+    void TilesetData::analyseOpacity()
+    {
+        const TilesetImage &image = *mImage;
+        const int tileWidth = mTilesetInfo.tileWidth;
+        const int tileHeight = mTilesetInfo.tileHeight;
+        const int columns = mTilesetInfo.columns;
+        const int rows = tileHeight > 0 ? image.height / tileHeight : 0;
+        mOpacity.assign(columns * rows, TileOpacity::Mixed);
+
+        for (int tileId = 0; tileId < columns * rows; ++tileId)
+        {
+            int originX = (tileId % columns) * tileWidth;
+            int originY = (tileId / columns) * tileHeight;
+            bool anyOpaque = false;
+            bool anyTransparent = false;
+            bool anyPartial = false;
 
-                // Load collision data
-                if (tile.contains("objectgroup") && tile["objectgroup"].contains("objects"))
+            for (int y = originY; y < originY + tileHeight && y < image.height; ++y)
+            {
+                const uint32_t *row = image.pixels.data() + static_cast<size_t>(y) * image.width;
+                for (int x = originX; x < originX + tileWidth && x < image.width; ++x)
                 {
-                    const auto &objects = tile["objectgroup"]["objects"];
-                    for (const auto &obj : objects)
-                    {
-                        if (obj["name"] == "collision_box")
-                        {
-                            CollisionBox box;
-                            box.x = obj["x"].get<float>();
-                            box.y = obj["y"].get<float>();
-                            box.width = obj["width"].get<float>();
-                            box.height = obj["height"].get<float>();
-                            mCollisionBoxes[id] = box;
-                        }
-                    }
+                    uint32_t alpha = row[x] >> 24;
+                    anyOpaque |= alpha == 255;
+                    anyTransparent |= alpha == 0;
+                    anyPartial |= alpha != 0 && alpha != 255;
                 }
+            }
 
-                // Load solid property
-                if (tile.contains("properties"))
+            if (!anyPartial && !anyTransparent)
+            {
+                mOpacity[tileId] = TileOpacity::Opaque;
+            }
+            else if (!anyPartial && !anyOpaque)
+            {
+                mOpacity[tileId] = TileOpacity::Transparent;
+            }
+        }
+
+        // An animated tile only keeps a uniform class if all of its frames share it
+        const std::vector<TileOpacity> frameOpacity = mOpacity;
+        auto opacityOf = [&](int tileId)
+        {
+            return tileId >= 0 && tileId < static_cast<int>(frameOpacity.size()) ? frameOpacity[tileId] : TileOpacity::Mixed;
+        };
+        for (const auto &[id, animation] : mAnimations)
+        {
+            if (id < 0 || id >= static_cast<int>(mOpacity.size()) || animation.frames.empty())
+            {
+                continue;
+            }
+
+            TileOpacity combined = opacityOf(animation.frames.front().tileId);
+            for (const auto &frame : animation.frames)
+            {
+                if (opacityOf(frame.tileId) != combined)
                 {
-                    for (const auto &prop : tile["properties"])
-                    {
-                        if (prop["name"] == "solid" && prop["type"] == "bool")
-                        {
-                            mSolidTiles[id] = prop["value"].get<bool>();
-                        }
-                    }
+                    combined = TileOpacity::Mixed;
+                    break;
                 }
             }
-
-            return true;
+            mOpacity[id] = combined;
         }
-        catch (const std::exception &e)
+    }
+
+    TileOpacity TilesetData::getOpacity(int tileId) const
+    {
+        if (tileId < 0 || tileId >= static_cast<int>(mOpacity.size()))
         {
-            std::cerr << "Error loading tileset data: " << e.what() << std::endl;
-            return false;
+            return TileOpacity::Mixed;
         }
+        return mOpacity[tileId];
     }
 
     void TilesetData::update(float deltaTime)
@@ -154,7 +382,7 @@ namespace zuul
         return it != mSolidTiles.end() ? it->second : false;
     }
 
-    void TilesetData::renderTile(std::shared_ptr<Renderer> renderer, int tileId, float x, float y, float zoom) const
+    void TilesetData::renderTile(Renderer &renderer, int tileId, float x, float y, float zoom) const
     {
         // Calculate source rectangle in tileset
         int srcX = (tileId % mTilesetInfo.columns) * mTilesetInfo.tileWidth;
@@ -168,11 +396,11 @@ namespace zuul
         int destH = static_cast<int>(std::ceil(mTilesetInfo.tileHeight * zoom));
 
         // Render the tile
-        renderer->renderTexture(mTexture,
-                                srcX, srcY, mTilesetInfo.tileWidth, mTilesetInfo.tileHeight,
-                                static_cast<int>(destX),
-                                static_cast<int>(destY),
-                                destW, destH);
+        renderer.renderTexture(mTexture.get(),
+                               srcX, srcY, mTilesetInfo.tileWidth, mTilesetInfo.tileHeight,
+                               static_cast<int>(destX),
+                               static_cast<int>(destY),
+                               destW, destH);
     }
 
 } // namespace zuul
\ No newline at end of file
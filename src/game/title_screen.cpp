@@ -1,11 +1,23 @@
 #include <game/title_screen.hpp>
+#include <engine/log.hpp>
+#include <asset_manifest.hpp>
 #include <SDL2/SDL.h>
-#include <iostream>
 #include <filesystem>
 #include <algorithm>
+#include <array>
 
 namespace zuul
 {
+    namespace
+    {
+        constexpr auto TITLE_ASSETS = []
+        {
+            std::array<AssetId, manifest::TITLE_FRAMES.size() + 1> assets{manifest::TITLE_BACKGROUND};
+            std::copy(manifest::TITLE_FRAMES.begin(), manifest::TITLE_FRAMES.end(), assets.begin() + 1);
+            return assets;
+        }();
+    }
+
     TitleScreen::TitleScreen()
         : mAnimationTimer(0.0f),
           mFrameDuration(0.2f), // 5 frames per second
@@ -19,48 +31,39 @@ namespace zuul
     {
     }
 
-    bool TitleScreen::initialize(std::shared_ptr<Renderer> renderer)
+    std::span<const AssetId> TitleScreen::getAssets() const
+    {
+        return TITLE_ASSETS;
+    }
+
+    SceneLoad TitleScreen::load(AssetRegistry &assets)
     {
         // Get window size
         SDL_GetWindowSize(SDL_GL_GetCurrentWindow(), &mWindowWidth, &mWindowHeight);
 
         // Load background
-        mBackground = renderer->loadTexture("assets/title_screen_background.png");
+        mBackground = assets.loadTexture(manifest::TITLE_BACKGROUND);
         if (!mBackground)
         {
-            std::cerr << "Failed to load title background: assets/title_screen_background.png" << std::endl;
-            return false;
+            ZUUL_LOG_ERROR(Game, "Failed to load title background: {}", manifest::TITLE_BACKGROUND.path);
+            return SceneLoad::Failed;
         }
 
-        // Load all title screen frames
-        std::string basePath = "assets/title_screen_";
-        int frameNumber = 1;
-
-        while (true)
+        // The manifest lists the frames, so their number is known up front
+        mFrames.reserve(manifest::TITLE_FRAMES.size());
+        for (AssetId frame : manifest::TITLE_FRAMES)
         {
-            std::string frameNumberStr = std::to_string(frameNumber);
-            // Pad with zeros to make it 4 digits
-            frameNumberStr = std::string(4 - frameNumberStr.length(), '0') + frameNumberStr;
-            std::string framePath = basePath + frameNumberStr + ".png";
-
-            // Try to load the texture
-            auto texture = renderer->loadTexture(framePath);
+            TextureAsset texture = assets.loadTexture(frame);
             if (!texture)
             {
-                if (frameNumber == 1)
-                {
-                    std::cerr << "Failed to load first title screen frame: " << framePath << std::endl;
-                    return false;
-                }
-                break; // No more frames to load
+                ZUUL_LOG_ERROR(Game, "Failed to load title screen frame: {}", frame.path);
+                return SceneLoad::Failed;
             }
-
-            mFrames.push_back(texture);
-            frameNumber++;
+            mFrames.push_back(std::move(texture));
         }
 
-        std::cout << "Loaded " << mFrames.size() << " title screen frames" << std::endl;
-        return !mFrames.empty();
+        ZUUL_LOG_INFO(Game, "Loaded {} title screen frames", mFrames.size());
+        return mFrames.empty() ? SceneLoad::Failed : SceneLoad::Ready;
     }
 
     void TitleScreen::update(float deltaTime)
@@ -75,8 +78,9 @@ namespace zuul
         {
             if (keyState[i])
             {
+                // Keeps animating while the next scene loads
                 mIsDone = true;
-                return;
+                break;
             }
         }
 
@@ -97,16 +101,15 @@ namespace zuul
         }
     }
 
-    void TitleScreen::render(std::shared_ptr<Renderer> renderer)
+    void TitleScreen::render(Renderer &renderer)
     {
         // Set background color (hex 69bd2f = RGB 105, 189, 47)
-        renderer->clear();
+        renderer.clear();
 
         // Render tiled background
-        if (mBackground)
+        int bgWidth, bgHeight;
+        if (renderer.getTextureSize(mBackground.get(), bgWidth, bgHeight))
         {
-            int bgWidth = mBackground->getWidth();
-            int bgHeight = mBackground->getHeight();
 
             // Calculate how many tiles we need in each direction
             int tilesX = (mWindowWidth + bgWidth - 1) / bgWidth;
@@ -120,39 +123,43 @@ namespace zuul
                     int destX = x * bgWidth;
                     int destY = y * bgHeight;
 
-                    renderer->renderTexture(mBackground,
-                                            0, 0, bgWidth, bgHeight,
-                                            destX, destY, bgWidth, bgHeight);
+                    renderer.renderTexture(mBackground.get(),
+                                           0, 0, bgWidth, bgHeight,
+                                           destX, destY, bgWidth, bgHeight);
                 }
             }
         }
 
-        if (mCurrentFrame < mFrames.size())
+        int frameWidth, frameHeight;
+        if (mCurrentFrame < mFrames.size() &&
+            renderer.getTextureSize(mFrames[mCurrentFrame].get(), frameWidth, frameHeight))
         {
-            auto texture = mFrames[mCurrentFrame];
-
             // Calculate scaling to fit the window while maintaining aspect ratio
-            float scaleX = static_cast<float>(mWindowWidth) / texture->getWidth();
-            float scaleY = static_cast<float>(mWindowHeight) / texture->getHeight();
+            float scaleX = static_cast<float>(mWindowWidth) / frameWidth;
+            float scaleY = static_cast<float>(mWindowHeight) / frameHeight;
             float scale = std::min(scaleX, scaleY);
 
-            int destWidth = static_cast<int>(texture->getWidth() * scale);
-            int destHeight = static_cast<int>(texture->getHeight() * scale);
+            int destWidth = static_cast<int>(frameWidth * scale);
+            int destHeight = static_cast<int>(frameHeight * scale);
 
             // Center the image
             int destX = (mWindowWidth - destWidth) / 2;
             int destY = (mWindowHeight - destHeight) / 2;
 
             // Render the current frame
-            renderer->renderTexture(texture,
-                                    0, 0, texture->getWidth(), texture->getHeight(),
-                                    destX, destY, destWidth, destHeight);
+            renderer.renderTexture(mFrames[mCurrentFrame].get(),
+                                   0, 0, frameWidth, frameHeight,
+                                   destX, destY, destWidth, destHeight);
         }
 
         // Render blinking text in color #211f34
-        if (mShowText)
+        if (mIsDone)
+        {
+            renderer.renderText("Loading...", mWindowWidth / 2 - 40, mWindowHeight - 100, {33, 31, 52, 255});
+        }
+        else if (mShowText)
         {
-            renderer->renderText("Press any key to start", mWindowWidth / 2 - 100, mWindowHeight - 100, {33, 31, 52, 255});
+            renderer.renderText("Press any key to start", mWindowWidth / 2 - 100, mWindowHeight - 100, {33, 31, 52, 255});
         }
     }
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include <game/ui.hpp>
+#include <engine/alloc_tracker.hpp>
+#include <charconv>
+#include <span>
 #include <string>
-#include <sstream>
-#include <SDL2/SDL.h>
-#include <iostream>
 namespace zuul
 {
     UI::UI()
@@ -10,67 +10,108 @@ namespace zuul
     {
     }
 
-    bool UI::initialize(std::shared_ptr<Renderer> renderer)
+    bool UI::initialize(MapSnapshot &&snapshot, AssetRegistry &assets)
     {
-        if (!loadFromFile("assets/ui.tmj", renderer))
+        if (!loadSnapshot(std::move(snapshot), assets))
         {
             return false;
         }
 
-        // Get window size
-        int windowWidth, windowHeight;
-        SDL_GetWindowSize(SDL_GL_GetCurrentWindow(), &windowWidth, &windowHeight);
-        mWindowWidth = windowWidth;
-        mWindowHeight = windowHeight;
+        mAssets = &assets;
 
+        // Hot reloads patch the bar's tiles in place, which leaves the generation alone
+        addTileChangeCallback([this](std::span<const TileChange>) { mDirty = true; });
         return true;
     }
 
-    void UI::render(std::shared_ptr<Renderer> renderer, float offsetX, float offsetY, float zoom)
+    void UI::render(Renderer &renderer, float offsetX, float offsetY, float zoom)
     {
-        // Calculate zoom to stretch UI to window width
+        ZUUL_ALLOC_ZONE("UI::render");
+        int windowWidth, windowHeight;
+        renderer.getOutputSize(windowWidth, windowHeight);
+        if (windowWidth != mWindowWidth || windowHeight != mWindowHeight || getContentGeneration() != mBuiltGeneration)
+        {
+            mWindowWidth = windowWidth;
+            mWindowHeight = windowHeight;
+            mBuiltGeneration = getContentGeneration();
+            mDirty = true;
+        }
+
+        // Stretch the bar to the window width, at the bottom of the screen
         float stretchZoom = static_cast<float>(mWindowWidth) / (mWidth * mTileWidth);
+        int barHeight = static_cast<int>(mHeight * mTileHeight * stretchZoom);
+        int barTop = mWindowHeight - barHeight;
+
+        if (mDirty)
+        {
+            rebuild(renderer, stretchZoom, barHeight);
+        }
+
+        if (mTarget)
+        {
+            renderer.renderTexture(mTarget.get(), 0, 0, mWindowWidth, barHeight, 0, barTop, mWindowWidth, barHeight);
+        }
+        else
+        {
+            // No render target support, draw the bar every frame
+            drawBar(renderer, static_cast<float>(barTop), stretchZoom);
+        }
+    }
+
+    void UI::rebuild(Renderer &renderer, float stretchZoom, int barHeight)
+    {
+        mDirty = false;
+
+        int currentWidth, currentHeight;
+        if (!renderer.getTextureSize(mTarget.get(), currentWidth, currentHeight) ||
+            currentWidth != mWindowWidth || currentHeight != barHeight)
+        {
+            mTarget = mAssets && mWindowWidth > 0 && barHeight > 0
+                          ? mAssets->createRenderTarget(mWindowWidth, barHeight)
+                          : TextureAsset();
+        }
 
-        // Calculate UI position at the bottom of the screen
-        float uiHeight = mHeight * mTileHeight * stretchZoom;
-        float renderY = mWindowHeight - uiHeight;
+        if (!mTarget || !renderer.setRenderTarget(mTarget.get()))
+        {
+            mTarget.reset();
+            return;
+        }
 
-        std::cout << "Window Width: " << mWindowWidth
-                  << ", UI Width: " << (mWidth * mTileWidth)
-                  << ", Stretch Zoom: " << stretchZoom
-                  << ", UI Height: " << uiHeight
-                  << ", Render Y: " << renderY << std::endl;
+        renderer.clear({0, 0, 0, 0});
+        drawBar(renderer, 0.0f, stretchZoom);
+        renderer.setRenderTarget({});
+    }
 
-        // Render the UI tilemap at the bottom
-        for (const auto &layer : mLayers)
+    void UI::drawBar(Renderer &renderer, float top, float stretchZoom)
+    {
+        // Render the UI tilemap
+        for (size_t layerIndex = 0; layerIndex < mLayers.size(); ++layerIndex)
         {
-            if (layer.visible)
+            if (mLayers[layerIndex].visible)
             {
                 for (int y = 0; y < mHeight; ++y)
                 {
                     for (int x = 0; x < mWidth; ++x)
                     {
-                        unsigned int tileId = layer.tileData[y * mWidth + x];
-                        if (tileId > 0)
+                        int tileId = 0;
+                        const MapTileset *tileset = resolveTile(mTiles.getTile(static_cast<int>(layerIndex), x, y), tileId);
+                        if (tileset)
                         {
-                            // Convert from Tiled's 1-based indices to 0-based
-                            tileId--;
-
                             // Calculate source rectangle in tileset
-                            int srcX = (tileId % mTilesetData->getTilesetInfo().columns) * mTileWidth;
-                            int srcY = (tileId / mTilesetData->getTilesetInfo().columns) * mTileHeight;
+                            int srcX = (tileId % tileset->columns) * mTileWidth;
+                            int srcY = (tileId / tileset->columns) * mTileHeight;
 
                             // Calculate destination position
                             float destX = x * mTileWidth * stretchZoom;
-                            float destY = renderY + (y * mTileHeight * stretchZoom);
+                            float destY = top + (y * mTileHeight * stretchZoom);
 
                             // Render the tile
-                            renderer->renderTexture(mTileset,
-                                                    srcX, srcY, mTileWidth, mTileHeight,
-                                                    static_cast<int>(destX),
-                                                    static_cast<int>(destY),
-                                                    static_cast<int>(mTileWidth * stretchZoom),
-                                                    static_cast<int>(mTileHeight * stretchZoom));
+                            renderer.renderTexture(tileset->texture,
+                                                   srcX, srcY, mTileWidth, mTileHeight,
+                                                   static_cast<int>(destX),
+                                                   static_cast<int>(destY),
+                                                   static_cast<int>(mTileWidth * stretchZoom),
+                                                   static_cast<int>(mTileHeight * stretchZoom));
                         }
                     }
                 }
@@ -87,18 +128,18 @@ namespace zuul
         {
             // Calculate position based on the UI layout
             float x = currentX;
-            float y = renderY + (mTileHeight * stretchZoom * 0.5f); // Position items in the UI bar
+            float y = top + (mTileHeight * stretchZoom * 0.5f); // Position items in the UI bar
 
-            // Render item icon using the new renderTile method
-            mTilesetData->renderTile(renderer, itemId, x, y - textOffsetY);
+            // Render item icon using the new renderTile method; items come from the map's first tileset
+            mTilesets.front().data->renderTile(renderer, itemId, x, y - textOffsetY);
 
-            // Render count above the item
-            std::stringstream ss;
-            ss << "x" << count;
-            renderer->renderText(ss.str(),
-                                 static_cast<int>(x + (mTileWidth * stretchZoom * 0.5f)),
-                                 static_cast<int>(y - textOffsetY),
-                                 {255, 255, 255, 255}); // White text
+            // Render count above the item, formatted on the stack
+            char text[16] = "x";
+            char *end = std::to_chars(text + 1, text + sizeof(text), count).ptr;
+            renderer.renderText(std::string_view(text, end - text),
+                                static_cast<int>(x + (mTileWidth * stretchZoom * 0.5f)),
+                                static_cast<int>(y - textOffsetY),
+                                {255, 255, 255, 255}); // White text
 
             // Move to next position
             currentX += itemSpacing;
@@ -107,9 +148,8 @@ namespace zuul
 
     void UI::addCollectedItem(int itemId)
     {
-        std::cout << "Adding item to collection: " << itemId << std::endl;
         mCollectedItems[itemId]++;
-        std::cout << "Current count for item " << itemId << ": " << mCollectedItems[itemId] << std::endl;
+        mDirty = true;
     }
 
     int UI::getCollectedItemCount(int itemId) const
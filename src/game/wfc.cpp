@@ -0,0 +1,596 @@
+#include <game/wfc.hpp>
+#include <engine/log.hpp>
+#include <game/tiled_reader.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace zuul
+{
+    namespace
+    {
+        // Seams are placed every REGION_SIZE cells in both directions
+        constexpr int REGION_SIZE = 64;
+        constexpr int REGION_ATTEMPTS = 8;
+        constexpr int MAP_ATTEMPTS = 4;
+
+        // Directions: east, west, south, north. Each is followed by its opposite.
+        constexpr int OFFSET_X[4] = {1, -1, 0, 0};
+        constexpr int OFFSET_Y[4] = {0, 0, 1, -1};
+
+        // Wang ids list top, top right, right, bottom right, bottom, bottom left, left
+        // and top left. These are the entries along each side, matched entry by entry
+        // with the opposite side of the neighbour.
+        constexpr int SIDES[4][3] = {
+            {1, 2, 3}, // East
+            {7, 6, 5}, // West
+            {3, 4, 5}, // South
+            {1, 0, 7}, // North
+        };
+
+        struct WangSet
+        {
+            std::string type;
+            std::vector<std::string> colors;
+            std::string base; // Colour the tiles of this set have in the other sets
+            std::map<int, std::array<uint8_t, 8>> tiles;
+        };
+
+        uint64_t mix(uint64_t value)
+        {
+            // splitmix64 finalizer
+            value += 0x9E3779B97F4A7C15ull;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+
+        // Copy of the rule tables in the form the solver reads them
+        struct RuleTables
+        {
+            int patterns;
+            int words;
+            const uint64_t *compatible;
+            std::vector<float> weights;
+            std::vector<float> weightLogWeights;
+        };
+
+        struct Wave
+        {
+            int width;
+            int height;
+            int words;
+            std::vector<uint64_t> bits; // Pattern set of every cell
+            std::vector<uint16_t> counts;
+
+            uint64_t *cell(int index) { return bits.data() + static_cast<size_t>(index) * words; }
+        };
+
+        struct Region
+        {
+            int minX;
+            int minY;
+            int maxX; // Exclusive
+            int maxY;
+        };
+
+        bool isSeam(int x, int y, int width, int height)
+        {
+            return (x % REGION_SIZE == REGION_SIZE - 1 && x < width - 1) ||
+                   (y % REGION_SIZE == REGION_SIZE - 1 && y < height - 1);
+        }
+
+        // Collapses the cells of one region, never touching cells outside it. With
+        // seamsOnly, only seam cells are collapsed, but propagation still narrows the
+        // cells around them.
+        bool collapse(Wave &wave, const RuleTables &rules, const Region &region, bool seamsOnly, uint64_t seed)
+        {
+            struct Entry
+            {
+                float entropy;
+                int cell;
+                uint16_t count; // Entries for a cell that has changed since are skipped
+
+                bool operator>(const Entry &other) const { return entropy > other.entropy; }
+            };
+
+            std::mt19937_64 random(seed);
+            std::uniform_real_distribution<float> noise(0.0f, 1e-3f);
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+            const int words = wave.words;
+
+            auto push = [&](int index)
+            {
+                int x = index % wave.width;
+                int y = index / wave.width;
+                if (wave.counts[index] <= 1 || (seamsOnly && !isSeam(x, y, wave.width, wave.height)))
+                {
+                    return;
+                }
+
+                // Shannon entropy of the weighted patterns that are left
+                float weight = 0.0f;
+                float weightLogWeight = 0.0f;
+                const uint64_t *bits = wave.cell(index);
+                for (int word = 0; word < words; ++word)
+                {
+                    for (uint64_t set = bits[word]; set; set &= set - 1)
+                    {
+                        int pattern = word * 64 + std::countr_zero(set);
+                        weight += rules.weights[pattern];
+                        weightLogWeight += rules.weightLogWeights[pattern];
+                    }
+                }
+                float entropy = std::log(weight) - weightLogWeight / weight;
+                heap.push({entropy + noise(random), index, wave.counts[index]});
+            };
+
+            std::vector<int> stack;
+            std::vector<uint64_t> allowed(words);
+            auto propagate = [&]()
+            {
+                while (!stack.empty())
+                {
+                    int index = stack.back();
+                    stack.pop_back();
+                    int x = index % wave.width;
+                    int y = index / wave.width;
+                    const uint64_t *bits = wave.cell(index);
+
+                    for (int direction = 0; direction < 4; ++direction)
+                    {
+                        int neighbourX = x + OFFSET_X[direction];
+                        int neighbourY = y + OFFSET_Y[direction];
+                        if (neighbourX < region.minX || neighbourY < region.minY ||
+                            neighbourX >= region.maxX || neighbourY >= region.maxY)
+                        {
+                            continue;
+                        }
+
+                        // Union of the patterns allowed next to any pattern left in this cell
+                        std::fill(allowed.begin(), allowed.end(), 0);
+                        for (int word = 0; word < words; ++word)
+                        {
+                            for (uint64_t set = bits[word]; set; set &= set - 1)
+                            {
+                                int pattern = word * 64 + std::countr_zero(set);
+                                const uint64_t *row = rules.compatible + (static_cast<size_t>(direction) * rules.patterns + pattern) * words;
+                                for (int i = 0; i < words; ++i)
+                                {
+                                    allowed[i] |= row[i];
+                                }
+                            }
+                        }
+
+                        int neighbour = neighbourY * wave.width + neighbourX;
+                        uint64_t *neighbourBits = wave.cell(neighbour);
+                        uint64_t changed = 0;
+                        int count = 0;
+                        for (int word = 0; word < words; ++word)
+                        {
+                            uint64_t next = neighbourBits[word] & allowed[word];
+                            changed |= next ^ neighbourBits[word];
+                            count += std::popcount(next);
+                        }
+                        if (count == 0)
+                        {
+                            return false;
+                        }
+                        if (changed)
+                        {
+                            for (int word = 0; word < words; ++word)
+                            {
+                                neighbourBits[word] &= allowed[word];
+                            }
+                            wave.counts[neighbour] = static_cast<uint16_t>(count);
+                            stack.push_back(neighbour);
+                            push(neighbour);
+                        }
+                    }
+                }
+                return true;
+            };
+
+            for (int y = region.minY; y < region.maxY; ++y)
+            {
+                for (int x = region.minX; x < region.maxX; ++x)
+                {
+                    push(y * wave.width + x);
+                }
+            }
+
+            while (!heap.empty())
+            {
+                Entry entry = heap.top();
+                heap.pop();
+                if (wave.counts[entry.cell] != entry.count || entry.count <= 1)
+                {
+                    continue;
+                }
+
+                // Pick one of the remaining patterns by weight
+                uint64_t *bits = wave.cell(entry.cell);
+                float total = 0.0f;
+                for (int word = 0; word < words; ++word)
+                {
+                    for (uint64_t set = bits[word]; set; set &= set - 1)
+                    {
+                        total += rules.weights[word * 64 + std::countr_zero(set)];
+                    }
+                }
+
+                float choice = std::uniform_real_distribution<float>(0.0f, total)(random);
+                int chosen = -1;
+                for (int word = 0; word < words && choice >= 0.0f; ++word)
+                {
+                    for (uint64_t set = bits[word]; set && choice >= 0.0f; set &= set - 1)
+                    {
+                        chosen = word * 64 + std::countr_zero(set);
+                        choice -= rules.weights[chosen];
+                    }
+                }
+
+                std::fill(bits, bits + words, 0);
+                bits[chosen / 64] = 1ull << (chosen % 64);
+                wave.counts[entry.cell] = 1;
+                stack.push_back(entry.cell);
+                if (!propagate())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool WfcRules::loadFromFile(const std::string &filepath)
+    {
+        try
+        {
+            std::vector<WangSet> sets;
+            WangSet pending;
+            std::map<int, float> probabilities;
+
+            // Child objects complete before their wang set, so they are collected until it does
+            bool read = readTiledFile(filepath, [&](const TiledPath &path, TiledObject &object)
+                                      {
+                const json &fields = object.fields;
+                if (path.is({"wangsets", "colors"}))
+                {
+                    pending.colors.push_back(fields["name"].get<std::string>());
+                }
+                else if (path.is({"wangsets", "properties"}))
+                {
+                    if (fields["name"] == "base" && fields["type"] == "string")
+                    {
+                        pending.base = fields["value"].get<std::string>();
+                    }
+                }
+                else if (path.is({"wangsets", "wangtiles"}))
+                {
+                    std::array<uint8_t, 8> wangId{};
+                    const json &ids = fields["wangid"];
+                    for (size_t i = 0; i < wangId.size() && i < ids.size(); ++i)
+                    {
+                        wangId[i] = ids[i].get<uint8_t>();
+                    }
+                    pending.tiles[fields["tileid"].get<int>()] = wangId;
+                }
+                else if (path.is({"wangsets"}))
+                {
+                    pending.type = fields.value("type", "mixed");
+                    sets.push_back(std::move(pending));
+                    pending = WangSet();
+                }
+                else if (path.is({"tiles"}))
+                {
+                    if (fields.contains("probability"))
+                    {
+                        probabilities[fields["id"].get<int>()] = fields["probability"].get<float>();
+                    }
+                } });
+
+            if (!read)
+            {
+                ZUUL_LOG_ERROR(Map, "Failed to read WFC rules from: {}", filepath);
+                return false;
+            }
+
+            // Wang colours of every tile across all sets. A tile outside a set takes the
+            // base colour of a set it belongs to, on the corners or edges that set uses.
+            std::set<int> tileIds;
+            for (const WangSet &set : sets)
+            {
+                for (const auto &[tileId, wangId] : set.tiles)
+                {
+                    tileIds.insert(tileId);
+                }
+            }
+
+            std::map<std::vector<uint8_t>, int> patternIndex;
+            std::vector<std::vector<uint8_t>> signatures;
+            mPatterns.clear();
+            for (int tileId : tileIds)
+            {
+                auto probability = probabilities.find(tileId);
+                float weight = probability != probabilities.end() ? probability->second : 1.0f;
+                if (weight <= 0.0f)
+                {
+                    continue;
+                }
+
+                std::vector<uint8_t> signature(sets.size() * 8, 0);
+                for (size_t index = 0; index < sets.size(); ++index)
+                {
+                    const WangSet &set = sets[index];
+                    auto member = set.tiles.find(tileId);
+                    if (member != set.tiles.end())
+                    {
+                        std::copy(member->second.begin(), member->second.end(), signature.begin() + index * 8);
+                        continue;
+                    }
+
+                    for (const WangSet &own : sets)
+                    {
+                        auto color = std::find(set.colors.begin(), set.colors.end(), own.base);
+                        if (own.base.empty() || !own.tiles.contains(tileId) || color == set.colors.end())
+                        {
+                            continue;
+                        }
+                        for (int i = 0; i < 8; ++i)
+                        {
+                            bool corner = i % 2 == 1;
+                            if (set.type == "mixed" || (set.type == "corner") == corner)
+                            {
+                                signature[index * 8 + i] = static_cast<uint8_t>(color - set.colors.begin() + 1);
+                            }
+                        }
+                        break;
+                    }
+                }
+
+                auto [it, added] = patternIndex.try_emplace(signature, static_cast<int>(mPatterns.size()));
+                if (added)
+                {
+                    mPatterns.push_back({});
+                    mPatterns.back().weight = 0.0f;
+                    signatures.push_back(signature);
+                }
+                Pattern &pattern = mPatterns[it->second];
+                pattern.tiles.push_back(tileId);
+                pattern.tileWeights.push_back(weight);
+                pattern.weight += weight;
+            }
+
+            if (mPatterns.empty())
+            {
+                ZUUL_LOG_ERROR(Map, "No wang tiles to generate maps from in: {}", filepath);
+                return false;
+            }
+
+            const int patterns = getPatternCount();
+            mWords = (patterns + 63) / 64;
+            mCompatible.assign(static_cast<size_t>(4) * patterns * mWords, 0);
+            for (int direction = 0; direction < 4; ++direction)
+            {
+                for (int a = 0; a < patterns; ++a)
+                {
+                    for (int b = 0; b < patterns; ++b)
+                    {
+                        bool matches = true;
+                        for (size_t set = 0; set < sets.size() && matches; ++set)
+                        {
+                            for (int i = 0; i < 3; ++i)
+                            {
+                                matches = matches && signatures[a][set * 8 + SIDES[direction][i]] ==
+                                                         signatures[b][set * 8 + SIDES[direction ^ 1][i]];
+                            }
+                        }
+                        if (matches)
+                        {
+                            mCompatible[(static_cast<size_t>(direction) * patterns + a) * mWords + b / 64] |= 1ull << (b % 64);
+                        }
+                    }
+                }
+            }
+
+            mTilesetPath = filepath;
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            ZUUL_LOG_ERROR(Map, "Error loading WFC rules: {}", e.what());
+            return false;
+        }
+    }
+
+    WfcGenerator::WfcGenerator(const WfcRules &rules)
+        : mRules(rules)
+    {
+    }
+
+    bool WfcGenerator::generate(int width, int height, uint32_t seed, std::vector<int> &tiles) const
+    {
+        if (width <= 0 || height <= 0 || mRules.mPatterns.empty())
+        {
+            return false;
+        }
+
+        RuleTables rules{mRules.getPatternCount(), mRules.mWords, mRules.mCompatible.data(), {}, {}};
+        for (const auto &pattern : mRules.mPatterns)
+        {
+            rules.weights.push_back(pattern.weight);
+            rules.weightLogWeights.push_back(pattern.weight * std::log(pattern.weight));
+        }
+
+        std::vector<uint64_t> allPatterns(rules.words, 0);
+        for (int pattern = 0; pattern < rules.patterns; ++pattern)
+        {
+            allPatterns[pattern / 64] |= 1ull << (pattern % 64);
+        }
+
+        // The regions between the seams
+        std::vector<Region> regions;
+        for (int y = 0; y < height; y += REGION_SIZE)
+        {
+            for (int x = 0; x < width; x += REGION_SIZE)
+            {
+                // The last region in a row or column also takes the cell a seam would be on
+                regions.push_back({x, y, x + REGION_SIZE >= width ? width : x + REGION_SIZE - 1,
+                                   y + REGION_SIZE >= height ? height : y + REGION_SIZE - 1});
+            }
+        }
+
+        Wave wave{width, height, rules.words, {}, {}};
+        const size_t cellCount = static_cast<size_t>(width) * height;
+        for (int attempt = 0; attempt < MAP_ATTEMPTS; ++attempt)
+        {
+            const uint64_t attemptSeed = mix(seed + 0x1000000ull * attempt);
+            wave.bits.resize(cellCount * rules.words);
+            for (size_t cell = 0; cell < cellCount; ++cell)
+            {
+                std::copy(allPatterns.begin(), allPatterns.end(), wave.bits.begin() + cell * rules.words);
+            }
+            wave.counts.assign(cellCount, static_cast<uint16_t>(rules.patterns));
+
+            if (regions.size() > 1 && !collapse(wave, rules, {0, 0, width, height}, true, attemptSeed))
+            {
+                continue;
+            }
+
+            // Regions only touch seams, which are fixed now, so they are filled in parallel.
+            // Every region draws from its own seed, so the result doesn't depend on threads.
+            std::atomic<size_t> nextRegion{0};
+            std::atomic<bool> solved{true};
+            auto solveRegions = [&]()
+            {
+                std::vector<uint64_t> savedBits;
+                std::vector<uint16_t> savedCounts;
+                for (size_t i = nextRegion++; i < regions.size() && solved; i = nextRegion++)
+                {
+                    const Region &region = regions[i];
+                    const int rowWords = (region.maxX - region.minX) * rules.words;
+                    savedBits.clear();
+                    savedCounts.clear();
+                    for (int y = region.minY; y < region.maxY; ++y)
+                    {
+                        const int first = y * width + region.minX;
+                        savedBits.insert(savedBits.end(), wave.cell(first), wave.cell(first) + rowWords);
+                        savedCounts.insert(savedCounts.end(), wave.counts.begin() + first, wave.counts.begin() + first + (region.maxX - region.minX));
+                    }
+
+                    bool regionSolved = false;
+                    for (int regionAttempt = 0; regionAttempt < REGION_ATTEMPTS && !regionSolved; ++regionAttempt)
+                    {
+                        if (regionAttempt > 0)
+                        {
+                            for (int y = region.minY; y < region.maxY; ++y)
+                            {
+                                const int first = y * width + region.minX;
+                                const size_t row = static_cast<size_t>(y - region.minY);
+                                std::copy_n(savedBits.begin() + row * rowWords, rowWords, wave.cell(first));
+                                std::copy_n(savedCounts.begin() + row * (region.maxX - region.minX), region.maxX - region.minX,
+                                            wave.counts.begin() + first);
+                            }
+                        }
+                        regionSolved = collapse(wave, rules, region, false, mix(attemptSeed ^ mix(i * REGION_ATTEMPTS + regionAttempt)));
+                    }
+                    if (!regionSolved)
+                    {
+                        solved = false;
+                    }
+                }
+            };
+
+            std::vector<std::thread> workers;
+            size_t workerCount = std::min<size_t>(regions.size(), std::max(1u, std::thread::hardware_concurrency()));
+            for (size_t i = 1; i < workerCount; ++i)
+            {
+                workers.emplace_back(solveRegions);
+            }
+            solveRegions();
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+            if (!solved)
+            {
+                continue;
+            }
+
+            // Pick a tile of each cell's pattern by its probability
+            tiles.resize(cellCount);
+            for (size_t cell = 0; cell < cellCount; ++cell)
+            {
+                const uint64_t *bits = wave.cell(static_cast<int>(cell));
+                int word = 0;
+                while (bits[word] == 0)
+                {
+                    ++word;
+                }
+                const WfcRules::Pattern &pattern = mRules.mPatterns[word * 64 + std::countr_zero(bits[word])];
+
+                float choice = static_cast<float>(mix(attemptSeed ^ cell) >> 40) / static_cast<float>(1 << 24) * pattern.weight;
+                size_t variant = 0;
+                while (variant + 1 < pattern.tiles.size() && choice >= pattern.tileWeights[variant])
+                {
+                    choice -= pattern.tileWeights[variant++];
+                }
+                tiles[cell] = pattern.tiles[variant];
+            }
+            return true;
+        }
+
+        ZUUL_LOG_ERROR(Map, "Map generation failed after {} attempts", MAP_ATTEMPTS);
+        return false;
+    }
+
+    std::shared_ptr<MapSnapshot> WfcGenerator::generateMap(int width, int height, uint32_t seed, TileGrid::Layout layout) const
+    {
+        auto tileset = std::make_shared<TilesetData>();
+        if (!tileset->readFromFile(mRules.getTilesetPath()))
+        {
+            return nullptr;
+        }
+
+        std::vector<int> tiles;
+        if (!generate(width, height, seed, tiles))
+        {
+            return nullptr;
+        }
+
+        auto snapshot = std::make_shared<MapSnapshot>();
+        MapSnapshot &map = *snapshot;
+        map.width = width;
+        map.height = height;
+        map.tileWidth = tileset->getTilesetInfo().tileWidth;
+        map.tileHeight = tileset->getTilesetInfo().tileHeight;
+        map.layers.push_back({"generated", true, false});
+        map.tilesets.push_back({1, tileset});
+        map.buildGidTable();
+
+        map.tiles.reset(1, layout);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                if (!map.tiles.setGid(0, x, y, static_cast<uint32_t>(tiles[static_cast<size_t>(y) * width + x] + 1)))
+                {
+                    ZUUL_LOG_ERROR(Map, "Generated tile does not fit the map: {}", tiles[static_cast<size_t>(y) * width + x]);
+                    return nullptr;
+                }
+            }
+        }
+        return snapshot;
+    }
+
+} // namespace zuul
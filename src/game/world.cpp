@@ -0,0 +1,145 @@
+#include <game/world.hpp>
+#include <engine/file_system.hpp>
+#include <engine/log.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+
+using json = nlohmann::json;
+
+namespace zuul
+{
+
+    bool World::loadFromFile(const std::string &filepath, AssetRegistry &assets)
+    {
+        std::shared_ptr<WorldSnapshot> snapshot = readSnapshot(filepath);
+        return snapshot && loadSnapshot(std::move(*snapshot), assets);
+    }
+
+    std::shared_ptr<WorldSnapshot> World::readSnapshot(const std::string &filepath)
+    {
+        try
+        {
+            std::string text;
+            if (!getFileSystem().readFile(filepath, text))
+            {
+                ZUUL_LOG_ERROR(Map, "Failed to open world file: {}", filepath);
+                return nullptr;
+            }
+
+            json worldJson = json::parse(text);
+
+            auto snapshot = std::make_shared<WorldSnapshot>();
+            snapshot->filepath = filepath;
+            const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+            for (const auto &mapJson : worldJson["maps"])
+            {
+                // Map file names are relative to the world file
+                std::string mapPath = (directory / mapJson["fileName"].get<std::string>()).lexically_normal().string();
+                // World maps keep the default cell layout
+                std::shared_ptr<MapSnapshot> map = TileMap::readSnapshot(mapPath, TileGrid::Layout::Cell);
+                if (!map)
+                {
+                    ZUUL_LOG_WARN(Map, "Skipping world map {}", mapPath);
+                    continue;
+                }
+                snapshot->maps.push_back({mapJson["x"].get<int>(), mapJson["y"].get<int>(), std::move(map)});
+            }
+            return snapshot;
+        }
+        catch (const std::exception &e)
+        {
+            ZUUL_LOG_ERROR(Map, "Error loading world: {}", e.what());
+            return nullptr;
+        }
+    }
+
+    bool World::loadSnapshot(WorldSnapshot &&snapshot, AssetRegistry &assets)
+    {
+        mMaps.clear();
+        for (auto &placement : snapshot.maps)
+        {
+            auto map = std::make_unique<TileMap>();
+            if (!map->loadSnapshot(std::move(*placement.map), assets))
+            {
+                ZUUL_LOG_WARN(Map, "Skipping world map {}", map->getFilepath());
+                continue;
+            }
+            map->bakeCompositeTiles(assets);
+
+            uint64_t pathHash = hashAssetPath(map->getFilepath());
+            auto lod = std::make_unique<MapLod>(*map, mLodWorker);
+            mMaps.push_back({placement.x, placement.y, pathHash, std::move(map), std::move(lod)});
+        }
+
+        if (mMaps.empty())
+        {
+            ZUUL_LOG_ERROR(Map, "No maps loaded from world file: {}", snapshot.filepath);
+            return false;
+        }
+
+        mMinX = mMinY = std::numeric_limits<int>::max();
+        mMaxX = mMaxY = std::numeric_limits<int>::min();
+        for (const auto &worldMap : mMaps)
+        {
+            mMinX = std::min(mMinX, worldMap.x);
+            mMinY = std::min(mMinY, worldMap.y);
+            mMaxX = std::max(mMaxX, worldMap.x + worldMap.map->getWidth() * worldMap.map->getTileWidth());
+            mMaxY = std::max(mMaxY, worldMap.y + worldMap.map->getHeight() * worldMap.map->getTileHeight());
+        }
+
+        return true;
+    }
+
+    void World::update(AssetRegistry &assets)
+    {
+        for (auto &worldMap : mMaps)
+        {
+            worldMap.lod->update(assets);
+        }
+    }
+
+    void World::queue(DrawQueue &queue, float offsetX, float offsetY, float zoom, int viewWidth, int viewHeight)
+    {
+        const int level = MapLod::levelForZoom(zoom);
+        const float viewRight = offsetX + viewWidth / zoom;
+        const float viewBottom = offsetY + viewHeight / zoom;
+
+        for (auto &worldMap : mMaps)
+        {
+            TileMap &map = *worldMap.map;
+            if (worldMap.x >= viewRight || worldMap.y >= viewBottom ||
+                worldMap.x + map.getWidth() * map.getTileWidth() <= offsetX ||
+                worldMap.y + map.getHeight() * map.getTileHeight() <= offsetY)
+            {
+                continue;
+            }
+
+            float mapOffsetX = offsetX - worldMap.x;
+            float mapOffsetY = offsetY - worldMap.y;
+            if (level == 0)
+            {
+                map.setViewSize(viewWidth, viewHeight);
+                map.queueTiles(queue, mapOffsetX, mapOffsetY, zoom);
+            }
+            else
+            {
+                worldMap.lod->queue(queue, 0, mapOffsetX, mapOffsetY, zoom, viewWidth, viewHeight, level);
+            }
+        }
+    }
+
+    WorldMap *World::findMap(AssetId map)
+    {
+        for (auto &worldMap : mMaps)
+        {
+            if (worldMap.pathHash == map.hash)
+            {
+                return &worldMap;
+            }
+        }
+        return nullptr;
+    }
+
+} // namespace zuul
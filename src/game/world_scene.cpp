@@ -0,0 +1,347 @@
+#include <game/world_scene.hpp>
+#include <engine/log.hpp>
+#include <engine/alloc_tracker.hpp>
+#include <asset_manifest.hpp>
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace zuul
+{
+    namespace
+    {
+        // Prefetched by the scene stack, so the player and the world tilesets find them loaded
+        constexpr std::array<AssetId, 2> WORLD_ASSETS = {manifest::PLAYER_TILES, manifest::MAP_TILES};
+    }
+
+    WorldScene::WorldScene(const Game &game, int windowWidth, int windowHeight)
+        : mGame(game),
+          mWindowWidth(windowWidth),
+          mWindowHeight(windowHeight)
+    {
+    }
+
+    std::span<const AssetId> WorldScene::getAssets() const
+    {
+        return WORLD_ASSETS;
+    }
+
+    SceneLoad WorldScene::load(AssetRegistry &assets)
+    {
+        if (!mAssets)
+        {
+            // Parsing the maps doesn't touch the renderer, so it runs while the scene below shows
+            mAssets = &assets;
+            mStartupReader = std::async(std::launch::async, []
+                                        { return StartupFiles{World::readSnapshot(manifest::WORLD.path),
+                                                              UI::readSnapshot(manifest::UI_MAP.path, TileGrid::Layout::Cell)}; });
+        }
+
+        if (!loadNextPhase())
+        {
+            return SceneLoad::Failed;
+        }
+        return mLoadPhase == LoadPhase::Done ? SceneLoad::Ready : SceneLoad::Loading;
+    }
+
+    bool WorldScene::loadNextPhase()
+    {
+        if (mLoadPhase == LoadPhase::Reading)
+        {
+            if (mStartupReader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                return true;
+            }
+            mStartupFiles = mStartupReader.get();
+            if (!mStartupFiles.world || !mStartupFiles.ui)
+            {
+                return false;
+            }
+            mLoadPhase = LoadPhase::World;
+        }
+        else if (mLoadPhase == LoadPhase::World)
+        {
+            if (!mWorld.loadSnapshot(std::move(*mStartupFiles.world), *mAssets))
+            {
+                return false;
+            }
+            mStartupFiles.world.reset();
+
+            mCurrentMap = mWorld.findMap(manifest::HOME_MAP);
+            if (!mCurrentMap)
+            {
+                ZUUL_LOG_ERROR(Game, "The world has no {}", manifest::HOME_MAP.path);
+                return false;
+            }
+            mTileMap = mCurrentMap->map.get();
+            mNavWorld.build(mWorld);
+            mLoadPhase = LoadPhase::Player;
+        }
+        else if (mLoadPhase == LoadPhase::Player)
+        {
+            mPlayer = std::make_unique<Player>();
+            if (!mPlayer->initialize(*mAssets))
+            {
+                return false;
+            }
+
+            // Set initial player position
+            mPlayer->setPosition(100, 100);
+
+            // Initialize camera
+            mCamera = std::make_unique<Camera>(
+                mWindowWidth,
+                mWindowHeight,
+                mTileMap->getWidth() * mTileMap->getTileWidth(),
+                mTileMap->getHeight() * mTileMap->getTileHeight());
+            mLoadPhase = LoadPhase::UI;
+        }
+        else if (mLoadPhase == LoadPhase::UI)
+        {
+            mUI = std::make_unique<UI>();
+            if (!mUI->initialize(std::move(*mStartupFiles.ui), *mAssets))
+            {
+                return false;
+            }
+            mStartupFiles.ui.reset();
+
+            // Set up item collect callback
+            mTileMap->setItemCollectCallback([this](int itemId)
+                                             {
+                ZUUL_LOG_DEBUG(Game, "Item collected: {}", itemId);
+                mUI->addCollectedItem(itemId); });
+
+            // Edits to the maps, tilesets and images in assets show up without a restart
+            for (const auto &worldMap : mWorld.getMaps())
+            {
+                mHotReloader.addMap(worldMap.map.get(), true);
+            }
+            mHotReloader.addMap(mUI.get());
+            mHotReloader.start("assets");
+
+            mLoadPhase = LoadPhase::Done;
+        }
+        return true;
+    }
+
+    void WorldScene::update(float deltaTime)
+    {
+        mHotReloader.update(*mAssets);
+        mWorld.update(*mAssets);
+
+        // Get keyboard state
+        const Uint8 *keyState = SDL_GetKeyboardState(nullptr);
+
+        // Toggle debug rendering with F1
+        static bool lastF1State = false;
+        bool currentF1State = keyState[SDL_SCANCODE_F1];
+        if (currentF1State && !lastF1State)
+        {
+            mDebugRendering = !mDebugRendering;
+            mTileMap->setDebugRendering(mDebugRendering);
+            mPlayer->setDebugRendering(mDebugRendering);
+        }
+        lastF1State = currentF1State;
+
+        // Handle camera zoom with + and - keys, at a speed relative to the zoom so the
+        // zoomed out range takes as long as the zoomed in one
+        if (keyState[SDL_SCANCODE_EQUALS])
+        {
+            mCamera->adjustZoom(deltaTime * mCamera->getZoom()); // Zoom in
+        }
+        if (keyState[SDL_SCANCODE_MINUS])
+        {
+            mCamera->adjustZoom(-deltaTime * mCamera->getZoom()); // Zoom out
+        }
+
+        // Update game objects
+        mPlayer->update(deltaTime, *mTileMap);
+        mTileMap->update(deltaTime);
+        mCamera->setMapSize(mTileMap->getWidth() * mTileMap->getTileWidth(),
+                            mTileMap->getHeight() * mTileMap->getTileHeight());
+        mCamera->update(mPlayer->getX(), mPlayer->getY());
+    }
+
+    void WorldScene::render(Renderer &renderer)
+    {
+        renderWorld(renderer);
+
+        // Render UI (always on top, no offset)
+        mUI->render(renderer, 0, 0);
+        mMinimap.render(renderer, mWorld,
+                        mCurrentMap->x + mPlayer->getX(), mCurrentMap->y + mPlayer->getY(), mWindowWidth);
+        if (mDebugRendering)
+        {
+            renderAllocStats(renderer);
+        }
+    }
+
+    void WorldScene::renderAllocStats(Renderer &renderer)
+    {
+        if (!AllocTracker::ENABLED)
+        {
+            return;
+        }
+
+        // Formatted on the stack; only numbers that changed cost a new text texture
+        auto renderLine = [&renderer](int line, const char *name, const AllocStats &allocs)
+        {
+            char text[96];
+            char *end = text + sizeof(text);
+            char *out = text + std::min(std::strlen(name), sizeof(text) - 48);
+            std::memcpy(text, name, out - text);
+            *out++ = ' ';
+            out = std::to_chars(out, end, allocs.count).ptr;
+            std::memcpy(out, " allocs ", 8);
+            out = std::to_chars(out + 8, end, allocs.bytes).ptr;
+            *out++ = ' ';
+            *out++ = 'B';
+            renderer.renderText(std::string_view(text, out - text), 10, 10 + line * 18, {255, 255, 0, 255});
+        };
+
+        const AllocTracker &tracker = getAllocTracker();
+        renderLine(0, "frame", tracker.getLastFrame());
+        int line = 1;
+        for (const AllocZoneStats &zone : tracker.getZones())
+        {
+            renderLine(line++, zone.name, zone.frame);
+        }
+    }
+
+    void WorldScene::renderDebugPath(Renderer &renderer, float offsetX, float offsetY, float zoom)
+    {
+        // Route from the player back to the spawn point
+        NavPoint start, goal;
+        if (!mNavWorld.locate(mCurrentMap->x + mPlayer->getX(), mCurrentMap->y + mPlayer->getY(), start) ||
+            !mNavWorld.locate(mCurrentMap->x + 100.0f, mCurrentMap->y + 100.0f, goal) ||
+            !mNavWorld.findPath(start, goal, mDebugPath))
+        {
+            return;
+        }
+
+        int size = std::max(2, static_cast<int>(4 * zoom));
+        for (const NavPoint &point : mDebugPath)
+        {
+            float x, y;
+            mNavWorld.getCenter(point, x, y);
+            renderer.renderRect(static_cast<int>((x - mCurrentMap->x - offsetX) * zoom) - size / 2,
+                                static_cast<int>((y - mCurrentMap->y - offsetY) * zoom) - size / 2,
+                                size, size, 255, 255, 0, 255);
+        }
+    }
+
+    void WorldScene::renderWorld(Renderer &renderer)
+    {
+        float zoom = mCamera->getZoom();
+        float offsetX = mCamera->getOffsetX();
+        float offsetY = mCamera->getOffsetY();
+
+        // Zoomed out, tiles would be smaller than pixels
+        if (zoom < 1.0f)
+        {
+            renderOverview(renderer);
+            return;
+        }
+
+        // Pixel art is only magnified by whole factors, so every world pixel covers the same
+        // number of screen pixels: the view shows the largest integer zoom around the camera
+        // centre, and the fraction left over is cropped or shown as a border.
+        int pixelZoom = static_cast<int>(zoom);
+        float viewOffsetX = offsetX + mWindowWidth / (2.0f * zoom) - mWindowWidth / (2.0f * pixelZoom);
+        float viewOffsetY = offsetY + mWindowHeight / (2.0f * zoom) - mWindowHeight / (2.0f * pixelZoom);
+
+        // The world is drawn 1:1 in pixel-art resolution, or at an integer multiple of it
+        // when the frame budget allows, and enlarged by the remaining whole factor in one blit
+        mResolution.setScaleRange(1, pixelZoom);
+        mResolution.update(mGame.getFrameWorkTime());
+        int scale = mResolution.getScale();
+        while (pixelZoom % scale != 0)
+        {
+            scale--;
+        }
+
+        // Snap the origin to whole world pixels so every tile lands on exact target pixels
+        float originX = std::floor(viewOffsetX);
+        float originY = std::floor(viewOffsetY);
+        int viewWidth = (mWindowWidth + pixelZoom - 1) / pixelZoom + 1;
+        int viewHeight = (mWindowHeight + pixelZoom - 1) / pixelZoom + 1;
+        int targetWidth = viewWidth * scale;
+        int targetHeight = viewHeight * scale;
+
+        // Grow the target when needed; smaller views only use part of it
+        int currentWidth, currentHeight;
+        if (!renderer.getTextureSize(mWorldTarget.get(), currentWidth, currentHeight) ||
+            currentWidth < targetWidth || currentHeight < targetHeight)
+        {
+            mWorldTarget = mAssets->createRenderTarget(targetWidth, targetHeight);
+        }
+
+        bool offscreen = mWorldTarget && renderer.setRenderTarget(mWorldTarget.get());
+        if (offscreen)
+        {
+            renderer.clear();
+            mTileMap->setViewSize(targetWidth, targetHeight);
+        }
+        else
+        {
+            // No render target support, draw straight to the window at the camera zoom
+            originX = offsetX;
+            originY = offsetY;
+            scale = 1;
+            mTileMap->setViewSize(mWindowWidth, mWindowHeight);
+        }
+        float drawZoom = offscreen ? static_cast<float>(scale) : zoom;
+
+        // Queue map layers, items and the player, then draw them in depth order
+        mDrawQueue.clear();
+        mTileMap->queueTiles(mDrawQueue, originX, originY, drawZoom);
+        mTileMap->queueItems(mDrawQueue, originX, originY, drawZoom);
+        mPlayer->queue(mDrawQueue, mTileMap->getEntityLayer(), originX, originY, drawZoom);
+        mDrawQueue.sort();
+        mDrawQueue.submit(renderer);
+
+        // Render debug info if enabled
+        if (mDebugRendering)
+        {
+            mTileMap->renderDebugCollisions(renderer, originX, originY, drawZoom);
+            mPlayer->renderDebug(renderer, originX, originY, drawZoom);
+            renderDebugPath(renderer, originX, originY, drawZoom);
+        }
+
+        if (offscreen)
+        {
+            renderer.setRenderTarget({});
+
+            // Upscale to the window by a whole factor with nearest filtering, shifted by the
+            // sub-pixel part of the camera offset
+            int blitZoom = pixelZoom / scale;
+            renderer.renderTexture(mWorldTarget.get(),
+                                   0, 0, targetWidth, targetHeight,
+                                   static_cast<int>(std::floor(-(viewOffsetX - originX) * pixelZoom)),
+                                   static_cast<int>(std::floor(-(viewOffsetY - originY) * pixelZoom)),
+                                   targetWidth * blitZoom,
+                                   targetHeight * blitZoom);
+        }
+    }
+
+    void WorldScene::renderOverview(Renderer &renderer)
+    {
+        float zoom = mCamera->getZoom();
+        float offsetX = mCamera->getOffsetX();
+        float offsetY = mCamera->getOffsetY();
+
+        // Every map of the world around the current one, drawn straight to the window.
+        // Below half size each chunk is a single downsampled image.
+        mDrawQueue.clear();
+        mWorld.queue(mDrawQueue, offsetX + mCurrentMap->x, offsetY + mCurrentMap->y, zoom, mWindowWidth, mWindowHeight);
+        mTileMap->queueItems(mDrawQueue, offsetX, offsetY, zoom);
+        mPlayer->queue(mDrawQueue, mTileMap->getEntityLayer(), offsetX, offsetY, zoom);
+        mDrawQueue.sort();
+        mDrawQueue.submit(renderer);
+    }
+
+} // namespace zuul
\ No newline at end of file
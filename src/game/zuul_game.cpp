@@ -1,6 +1,7 @@
 #include <game/zuul_game.hpp>
-#include <SDL2/SDL.h>
-#include <iostream>
+#include <game/title_screen.hpp>
+#include <game/world_scene.hpp>
+#include <engine/log.hpp>
 
 namespace zuul
 {
@@ -12,128 +13,47 @@ namespace zuul
             return false;
         }
 
-        mWindowWidth = windowWidth;
-        mWindowHeight = windowHeight;
-
-        // Initialize title screen first
-        mTitleScreen = std::make_unique<TitleScreen>();
-        if (!mTitleScreen->initialize(getRenderer()))
+        // Only the title screen is loaded before the first frame. The world loads in the
+        // frames after and takes over once the title is dismissed, releasing its images.
+        mScenes = std::make_unique<SceneStack>(getAssets());
+        mScenes->push(std::make_unique<TitleScreen>());
+        if (!mScenes->finishLoading())
         {
             return false;
         }
+        mScenes->replace(std::make_unique<WorldScene>(*this, windowWidth, windowHeight));
+        return true;
+    }
 
-        // Initialize game components (they'll be used after the title screen)
-        mTileMap = std::make_unique<TileMap>();
-        if (!mTileMap->loadFromFile("assets/home.tmj", getRenderer()))
+    void ZuulGame::beginFrame()
+    {
+        if (!mScenes->beginFrame())
         {
-            return false;
+            ZUUL_LOG_ERROR(Game, "Failed to load the game");
+            stop();
+            return;
         }
-
-        mPlayer = std::make_unique<Player>();
-        if (!mPlayer->initialize(getRenderer()))
+        if (mScenes->isEmpty())
         {
-            return false;
+            stop();
+            return;
         }
 
-        // Set initial player position
-        mPlayer->setPosition(100, 100);
-
-        // Initialize camera
-        mCamera = std::make_unique<Camera>(
-            windowWidth,
-            windowHeight,
-            mTileMap->getWidth() * mTileMap->getTileWidth(),
-            mTileMap->getHeight() * mTileMap->getTileHeight());
-
-        // Initialize UI
-        mUI = std::make_unique<UI>();
-        if (!mUI->initialize(getRenderer()))
+        if (!mInteractive && !mScenes->isLoading())
         {
-            return false;
+            mInteractive = true;
+            ZUUL_LOG_INFO(Game, "Time to interactive: {:.1f} ms", getMillisecondsSinceStart());
         }
-
-        // Set up item collect callback
-        mTileMap->setItemCollectCallback([this](int itemId)
-                                         {
-            std::cout << "Item collected: " << itemId << std::endl;
-            mUI->addCollectedItem(itemId); });
-
-        return true;
     }
 
     void ZuulGame::update(float deltaTime)
     {
-        if (!mGameStarted)
-        {
-            // Update title screen
-            mTitleScreen->update(deltaTime);
-            if (mTitleScreen->isDone())
-            {
-                mGameStarted = true;
-                return;
-            }
-        }
-        else
-        {
-            // Get keyboard state
-            const Uint8 *keyState = SDL_GetKeyboardState(nullptr);
-
-            // Toggle debug rendering with F1
-            static bool lastF1State = false;
-            bool currentF1State = keyState[SDL_SCANCODE_F1];
-            if (currentF1State && !lastF1State)
-            {
-                mDebugRendering = !mDebugRendering;
-                mTileMap->setDebugRendering(mDebugRendering);
-                mPlayer->setDebugRendering(mDebugRendering);
-            }
-            lastF1State = currentF1State;
-
-            // Handle camera zoom with + and - keys
-            if (keyState[SDL_SCANCODE_EQUALS])
-            {
-                mCamera->adjustZoom(deltaTime); // Zoom in
-            }
-            if (keyState[SDL_SCANCODE_MINUS])
-            {
-                mCamera->adjustZoom(-deltaTime); // Zoom out
-            }
-
-            // Update game objects
-            mPlayer->update(deltaTime, *mTileMap);
-            mTileMap->update(deltaTime);
-            mCamera->update(mPlayer->getX(), mPlayer->getY());
-        }
+        mScenes->update(deltaTime);
     }
 
     void ZuulGame::render()
     {
-        if (!mGameStarted)
-        {
-            // Render title screen
-            mTitleScreen->render(getRenderer());
-        }
-        else
-        {
-            float zoom = mCamera->getZoom();
-            float offsetX = mCamera->getOffsetX();
-            float offsetY = mCamera->getOffsetY();
-
-            // Render map layers
-            mTileMap->render(getRenderer(), offsetX, offsetY, zoom);
-
-            // Render player
-            mPlayer->render(getRenderer(), offsetX, offsetY, zoom);
-
-            // Render debug info if enabled
-            if (mDebugRendering)
-            {
-                mTileMap->renderDebugCollisions(getRenderer(), offsetX, offsetY, zoom);
-            }
-
-            // Render UI (always on top, no offset)
-            mUI->render(getRenderer(), 0, 0);
-        }
+        mScenes->render(getRenderer());
     }
 
-} // namespace zuul
\ No newline at end of file
+} // namespace zuul
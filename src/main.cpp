@@ -1,5 +1,5 @@
 #include <game/zuul_game.hpp>
-#include <iostream>
+#include <engine/log.hpp>
 
 int main(int argc, char *argv[])
 {
@@ -10,11 +10,13 @@ int main(int argc, char *argv[])
 
     if (!game.initialize(WINDOW_WIDTH, WINDOW_HEIGHT, "Zuul"))
     {
-        std::cerr << "Failed to initialize game" << std::endl;
+        ZUUL_LOG_ERROR(Game, "Failed to initialize game");
+        zuul::flushLogs();
         return 1;
     }
 
     game.run();
 
+    zuul::flushLogs();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+// Builds an asset pack for the game: zuul_pack [--lz4] <output> <directory or file>...
+//
+// Maps, tilesets, worlds, fonts and other data files are stored as they are; images are
+// decoded to ARGB8888 here, so the game can upload them without decoding PNGs. Entries
+// are named by their lexically normal path as given, so run it from the directory the
+// game runs in, e.g. zuul_pack assets.pack assets
+#include <engine/asset_pack.hpp>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(ZUUL_HAVE_LZ4)
+#include <lz4.h>
+#endif
+
+namespace
+{
+    using namespace zuul;
+
+    const std::set<std::string> DATA_EXTENSIONS = {".json", ".tmj", ".tsj", ".ttf", ".tx", ".world"};
+    const std::set<std::string> IMAGE_EXTENSIONS = {".png"};
+
+    struct Item
+    {
+        std::string name;
+        PackEntry entry{};
+        std::vector<char> data;
+    };
+
+    size_t alignUp(size_t value)
+    {
+        return (value + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+    }
+
+    bool readData(const std::filesystem::path &path, Item &item)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        item.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        item.entry.type = PackEntryType::File;
+        item.entry.rawSize = item.data.size();
+        return true;
+    }
+
+    bool readImage(const std::filesystem::path &path, Item &item, bool compress)
+    {
+        SDL_Surface *loaded = IMG_Load(path.string().c_str());
+        if (!loaded)
+        {
+            return false;
+        }
+        SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        if (!surface)
+        {
+            return false;
+        }
+
+        // The same layout Renderer::createTexture takes: rows of ARGB8888 without padding
+        const size_t rowBytes = static_cast<size_t>(surface->w) * sizeof(uint32_t);
+        std::vector<char> pixels(rowBytes * surface->h);
+        SDL_LockSurface(surface);
+        for (int y = 0; y < surface->h; ++y)
+        {
+            std::memcpy(pixels.data() + y * rowBytes, static_cast<const char *>(surface->pixels) + y * surface->pitch, rowBytes);
+        }
+        SDL_UnlockSurface(surface);
+
+        item.entry.type = PackEntryType::Image;
+        item.entry.width = static_cast<uint32_t>(surface->w);
+        item.entry.height = static_cast<uint32_t>(surface->h);
+        item.entry.rawSize = pixels.size();
+        item.entry.compression = PackCompression::None;
+        SDL_FreeSurface(surface);
+
+#if defined(ZUUL_HAVE_LZ4)
+        if (compress)
+        {
+            std::vector<char> compressed(LZ4_compressBound(static_cast<int>(pixels.size())));
+            int size = LZ4_compress_default(pixels.data(), compressed.data(), static_cast<int>(pixels.size()),
+                                            static_cast<int>(compressed.size()));
+            // Only worth it if it saves something, uncompressed pixels need no copy at runtime
+            if (size > 0 && static_cast<size_t>(size) < pixels.size())
+            {
+                compressed.resize(size);
+                item.data = std::move(compressed);
+                item.entry.compression = PackCompression::LZ4;
+                return true;
+            }
+        }
+#else
+        (void)compress;
+#endif
+        item.data = std::move(pixels);
+        return true;
+    }
+
+    bool addFile(const std::filesystem::path &path, bool compress, std::vector<Item> &items)
+    {
+        std::string extension = path.extension().string();
+        bool isImage = IMAGE_EXTENSIONS.contains(extension);
+        if (!isImage && !DATA_EXTENSIONS.contains(extension))
+        {
+            return true;
+        }
+
+        Item item;
+        item.name = path.lexically_normal().generic_string();
+        if (!(isImage ? readImage(path, item, compress) : readData(path, item)))
+        {
+            std::cerr << "Failed to read " << path.string() << std::endl;
+            return false;
+        }
+        item.entry.size = item.data.size();
+        items.push_back(std::move(item));
+        return true;
+    }
+
+    bool writePack(const std::string &output, std::vector<Item> &items)
+    {
+        // Sorted, so the game can binary search the index in place
+        std::sort(items.begin(), items.end(), [](const Item &a, const Item &b)
+                  { return a.name < b.name; });
+        auto duplicate = std::adjacent_find(items.begin(), items.end(), [](const Item &a, const Item &b)
+                                            { return a.name == b.name; });
+        if (duplicate != items.end())
+        {
+            std::cerr << "Added twice: " << duplicate->name << std::endl;
+            return false;
+        }
+
+        std::string names;
+        for (Item &item : items)
+        {
+            item.entry.nameOffset = static_cast<uint32_t>(names.size());
+            item.entry.nameLength = static_cast<uint32_t>(item.name.size());
+            names += item.name;
+        }
+
+        PackHeader header{};
+        std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+        header.version = PACK_VERSION;
+        header.entryCount = static_cast<uint32_t>(items.size());
+        header.namesSize = static_cast<uint32_t>(names.size());
+
+        size_t offset = alignUp(sizeof(header) + items.size() * sizeof(PackEntry) + names.size());
+        for (Item &item : items)
+        {
+            item.entry.offset = offset;
+            offset = alignUp(offset + item.data.size());
+        }
+
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to create " << output << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (const Item &item : items)
+        {
+            file.write(reinterpret_cast<const char *>(&item.entry), sizeof(item.entry));
+        }
+        file.write(names.data(), names.size());
+
+        const char padding[PACK_ALIGNMENT] = {};
+        for (const Item &item : items)
+        {
+            file.write(padding, item.entry.offset - static_cast<size_t>(file.tellp()));
+            file.write(item.data.data(), item.data.size());
+        }
+        return static_cast<bool>(file);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool compress = !args.empty() && args.front() == "--lz4";
+    if (compress)
+    {
+        args.erase(args.begin());
+#if !defined(ZUUL_HAVE_LZ4)
+        std::cerr << "zuul_pack was built without LZ4 support" << std::endl;
+        return 1;
+#endif
+    }
+    if (args.size() < 2)
+    {
+        std::cerr << "Usage: zuul_pack [--lz4] <output> <directory or file>..." << std::endl;
+        return 1;
+    }
+
+    IMG_Init(IMG_INIT_PNG);
+
+    std::vector<Item> items;
+    bool ok = true;
+    for (size_t i = 1; i < args.size() && ok; ++i)
+    {
+        std::error_code error;
+        if (std::filesystem::is_directory(args[i], error))
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(args[i], error))
+            {
+                if (entry.is_regular_file() && !addFile(entry.path(), compress, items))
+                {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            ok = addFile(args[i], compress, items);
+        }
+    }
+
+    ok = ok && writePack(args[0], items);
+    IMG_Quit();
+    if (!ok)
+    {
+        return 1;
+    }
+
+    std::cout << "Packed " << items.size() << " files into " << args[0] << std::endl;
+    return 0;
+}
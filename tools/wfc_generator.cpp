@@ -0,0 +1,100 @@
+// Generates a map with wave function collapse and loads it like the game would:
+// zuul_wfc <width> <height> [seed] [tileset]
+//
+// The rules come from the wang sets of the tileset, assets/map_tiles.tsj by default. The
+// map is loaded through TileMap::loadSnapshot with the software renderer, so it runs
+// without a display, and the time of each step is printed.
+#include <engine/asset_registry.hpp>
+#include <engine/log.hpp>
+#include <engine/software_renderer.hpp>
+#include <game/tilemap.hpp>
+#include <game/wfc.hpp>
+#include <SDL2/SDL.h>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    bool parseNumber(const std::string &text, uint32_t &value)
+    {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t seed = 1;
+    if (args.size() < 2 || args.size() > 4 ||
+        !parseNumber(args[0], width) || !parseNumber(args[1], height) || width == 0 || height == 0 ||
+        (args.size() > 2 && !parseNumber(args[2], seed)))
+    {
+        std::cerr << "Usage: zuul_wfc <width> <height> [seed] [tileset]" << std::endl;
+        return 1;
+    }
+    const std::string tilesetPath = args.size() > 3 ? args[3] : "assets/map_tiles.tsj";
+
+    zuul::WfcRules rules;
+    if (!rules.loadFromFile(tilesetPath))
+    {
+        std::cerr << "Failed to read rules from " << tilesetPath << std::endl;
+        zuul::flushLogs();
+        return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::shared_ptr<zuul::MapSnapshot> snapshot =
+        zuul::WfcGenerator(rules).generateMap(static_cast<int>(width), static_cast<int>(height), seed);
+    double generateTime = millisecondsSince(start);
+    if (!snapshot)
+    {
+        std::cerr << "Failed to generate a " << width << "x" << height << " map" << std::endl;
+        zuul::flushLogs();
+        return 1;
+    }
+
+    // No window is shown; SDL_VIDEODRIVER still takes precedence over the hint
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    zuul::SoftwareRenderer renderer;
+    if (!renderer.initialize(static_cast<int>(width), static_cast<int>(height), "zuul_wfc"))
+    {
+        zuul::flushLogs();
+        return 1;
+    }
+
+    bool loaded = false;
+    double loadTime = 0.0;
+    {
+        zuul::AssetRegistry assets(renderer);
+        zuul::TileMap map;
+        start = Clock::now();
+        loaded = map.loadSnapshot(std::move(*snapshot), assets);
+        loadTime = millisecondsSince(start);
+    }
+    zuul::flushLogs();
+    if (!loaded)
+    {
+        std::cerr << "Failed to load the generated map" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Generated a " << width << "x" << height << " map from " << rules.getPatternCount()
+              << " patterns with seed " << seed << " in " << generateTime << " ms, loaded it in "
+              << loadTime << " ms" << std::endl;
+    return 0;
+}